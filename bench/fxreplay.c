@@ -0,0 +1,81 @@
+/*
+ * FX Shader Runtime - GL Trace Replay
+ * Replays a capture from fxgl_trace_begin() as fast as possible, timed per call type
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_trace.h"
+#include "mock_gl.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Output is one JSON object per line, like the other benchmarks: a line per
+// call type, most expensive first, then the totals
+static FXGLReplayStats g_stats;
+
+static int by_total_ns(const void* a, const void* b) {
+    uint64_t x = g_stats.ns[*(const int*)a], y = g_stats.ns[*(const int*)b];
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: fxreplay [--mock] <trace>\n");
+    fprintf(stderr, "  --mock  replay against the counting mock GL instead of a headless context\n");
+}
+
+int main(int argc, char** argv) {
+    const char* path = NULL;
+    int mock = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mock") == 0) mock = 1;
+        else if (!path && argv[i][0] != '-') path = argv[i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (!path) {
+        usage();
+        return 1;
+    }
+
+    const char* backend = "mock";
+    if (mock) {
+        mock_gl_install();
+    } else {
+        // 4.3 if there is one, so captures of the multi-draw paths replay too
+        if (!fxgl_create_headless_context(4, 3) && !fxgl_create_headless_context(3, 3)) {
+            fprintf(stderr, "No headless GL context; use --mock\n");
+            return 1;
+        }
+        if (!fxgl_init()) return 1;
+        FXGLLoaderInfo info;
+        fxgl_loader_info(&info);
+        backend = info.backend;
+    }
+
+    if (!fxgl_trace_replay(path, &g_stats)) return 1;
+
+    int order[FXGL_TRACE_OP_COUNT];
+    for (int i = 0; i < FXGL_TRACE_OP_COUNT; i++) order[i] = i;
+    qsort(order, FXGL_TRACE_OP_COUNT, sizeof(int), by_total_ns);
+
+    uint64_t gl_ns = 0;
+    for (int i = 0; i < FXGL_TRACE_OP_COUNT; i++) {
+        int op = order[i];
+        gl_ns += g_stats.ns[op];
+        if (!g_stats.calls[op]) continue;
+        printf("{\"call\":\"%s\",\"calls\":%llu,\"ns_per_call\":%.2f,\"total_ms\":%.3f}\n",
+               fxgl_trace_op_name((FXGLTraceOp)op), (unsigned long long)g_stats.calls[op],
+               (double)g_stats.ns[op] / g_stats.calls[op], g_stats.ns[op] / 1e6);
+    }
+    printf("{\"trace\":\"%s\",\"backend\":\"%s\",\"calls\":%llu,\"gl_ms\":%.3f,\"total_ms\":%.3f,"
+           "\"timer_ns\":%llu,\"skipped\":%llu,\"name_mismatches\":%llu}\n",
+           path, backend, (unsigned long long)g_stats.total_calls, gl_ns / 1e6, g_stats.total_ns / 1e6,
+           (unsigned long long)g_stats.timer_ns, (unsigned long long)g_stats.skipped,
+           (unsigned long long)g_stats.name_mismatches);
+    return 0;
+}
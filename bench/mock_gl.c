@@ -0,0 +1,213 @@
+/*
+ * FX Shader Runtime - Mock GL Backend
+ * Counting stand-ins for every loaded GL entry point, for benchmarks without a GPU
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "mock_gl.h"
+#include <string.h>
+
+unsigned long long mock_gl_counts[MOCK_GL_CALL_COUNT];
+
+static const char* g_names[MOCK_GL_CALL_COUNT] = {
+#define MOCK_GL_NAME(ret, name, params, args) #name,
+    FXGL_ENTRY_POINTS(MOCK_GL_NAME)
+#undef MOCK_GL_NAME
+};
+
+static GLuint g_next_name = 1;
+
+#define COUNT(name) mock_gl_counts[MOCK_##name]++
+
+static void gen_names(GLsizei n, GLuint* out) {
+    for (GLsizei i = 0; i < n; i++) out[i] = g_next_name++;
+}
+
+static void APIENTRY mock_glGenVertexArrays(GLsizei n, GLuint* out) { COUNT(glGenVertexArrays); gen_names(n, out); }
+static void APIENTRY mock_glBindVertexArray(GLuint vao) { COUNT(glBindVertexArray); (void)vao; }
+static void APIENTRY mock_glDeleteVertexArrays(GLsizei n, const GLuint* vaos) { COUNT(glDeleteVertexArrays); (void)n; (void)vaos; }
+static void APIENTRY mock_glGenBuffers(GLsizei n, GLuint* out) { COUNT(glGenBuffers); gen_names(n, out); }
+static void APIENTRY mock_glDeleteBuffers(GLsizei n, const GLuint* buffers) { COUNT(glDeleteBuffers); (void)n; (void)buffers; }
+static void APIENTRY mock_glBindBuffer(GLenum target, GLuint buffer) { COUNT(glBindBuffer); (void)target; (void)buffer; }
+static void APIENTRY mock_glBufferData(GLenum target, ptrdiff_t size, const void* data, GLenum usage) {
+    COUNT(glBufferData); (void)target; (void)size; (void)data; (void)usage;
+}
+static void APIENTRY mock_glBufferSubData(GLenum target, ptrdiff_t offset, ptrdiff_t size, const void* data) {
+    COUNT(glBufferSubData); (void)target; (void)offset; (void)size; (void)data;
+}
+static void APIENTRY mock_glBindBufferRange(GLenum target, GLuint index, GLuint buffer, ptrdiff_t offset, ptrdiff_t size) {
+    COUNT(glBindBufferRange); (void)target; (void)index; (void)buffer; (void)offset; (void)size;
+}
+static void APIENTRY mock_glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                                GLsizei stride, const void* pointer) {
+    COUNT(glVertexAttribPointer); (void)index; (void)size; (void)type; (void)normalized; (void)stride; (void)pointer;
+}
+static void APIENTRY mock_glEnableVertexAttribArray(GLuint index) { COUNT(glEnableVertexAttribArray); (void)index; }
+static void APIENTRY mock_glVertexAttribDivisor(GLuint index, GLuint divisor) {
+    COUNT(glVertexAttribDivisor); (void)index; (void)divisor;
+}
+static void APIENTRY mock_glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    COUNT(glDrawArraysInstanced); (void)mode; (void)first; (void)count; (void)instances;
+}
+static void APIENTRY mock_glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices,
+                                                  GLsizei instances) {
+    COUNT(glDrawElementsInstanced); (void)mode; (void)count; (void)type; (void)indices; (void)instances;
+}
+static void APIENTRY mock_glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices,
+                                                   GLint base_vertex) {
+    COUNT(glDrawElementsBaseVertex); (void)mode; (void)count; (void)type; (void)indices; (void)base_vertex;
+}
+static void APIENTRY mock_glProgramUniform1f(GLuint program, GLint location, float x) {
+    COUNT(glProgramUniform1f); (void)program; (void)location; (void)x;
+}
+static void APIENTRY mock_glProgramUniform3f(GLuint program, GLint location, float x, float y, float z) {
+    COUNT(glProgramUniform3f); (void)program; (void)location; (void)x; (void)y; (void)z;
+}
+static void APIENTRY mock_glProgramUniform4f(GLuint program, GLint location, float x, float y, float z, float w) {
+    COUNT(glProgramUniform4f); (void)program; (void)location; (void)x; (void)y; (void)z; (void)w;
+}
+static void APIENTRY mock_glProgramUniformMatrix4fv(GLuint program, GLint location, GLsizei count, GLboolean transpose,
+                                                    const float* value) {
+    COUNT(glProgramUniformMatrix4fv); (void)program; (void)location; (void)count; (void)transpose; (void)value;
+}
+static void APIENTRY mock_glProgramUniform1i(GLuint program, GLint location, GLint x) {
+    COUNT(glProgramUniform1i); (void)program; (void)location; (void)x;
+}
+static void APIENTRY mock_glMultiDrawArraysIndirect(GLenum mode, const void* indirect, GLsizei count, GLsizei stride) {
+    COUNT(glMultiDrawArraysIndirect); (void)mode; (void)indirect; (void)count; (void)stride;
+}
+static void APIENTRY mock_glMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei count,
+                                                      GLsizei stride) {
+    COUNT(glMultiDrawElementsIndirect); (void)mode; (void)type; (void)indirect; (void)count; (void)stride;
+}
+static void APIENTRY mock_glDebugMessageCallback(FXGLDebugProc callback, const void* user) {
+    COUNT(glDebugMessageCallback); (void)callback; (void)user;
+}
+static void APIENTRY mock_glDebugMessageControl(GLenum source, GLenum type, GLenum severity, GLsizei count,
+                                                const GLuint* ids, GLboolean enabled) {
+    COUNT(glDebugMessageControl); (void)source; (void)type; (void)severity; (void)count; (void)ids; (void)enabled;
+}
+static void APIENTRY mock_glGetPointerv(GLenum pname, void** params) { COUNT(glGetPointerv); (void)pname; *params = NULL; }
+static void APIENTRY mock_glUseProgram(GLuint program) { COUNT(glUseProgram); (void)program; }
+static GLuint APIENTRY mock_glCreateShader(GLenum type) { COUNT(glCreateShader); (void)type; return g_next_name++; }
+static void APIENTRY mock_glShaderSource(GLuint shader, GLsizei count, const char* const* strings, const GLint* lengths) {
+    COUNT(glShaderSource); (void)shader; (void)count; (void)strings; (void)lengths;
+}
+static void APIENTRY mock_glCompileShader(GLuint shader) { COUNT(glCompileShader); (void)shader; }
+static void APIENTRY mock_glGetShaderiv(GLuint shader, GLenum pname, GLint* value) {
+    COUNT(glGetShaderiv); (void)shader; (void)pname; *value = 1;
+}
+static void APIENTRY mock_glGetShaderInfoLog(GLuint shader, GLsizei size, GLsizei* length, char* log) {
+    COUNT(glGetShaderInfoLog); (void)shader;
+    if (length) *length = 0;
+    if (size > 0) log[0] = '\0';
+}
+static void APIENTRY mock_glDeleteShader(GLuint shader) { COUNT(glDeleteShader); (void)shader; }
+static GLuint APIENTRY mock_glCreateProgram(void) { COUNT(glCreateProgram); return g_next_name++; }
+static void APIENTRY mock_glAttachShader(GLuint program, GLuint shader) { COUNT(glAttachShader); (void)program; (void)shader; }
+static void APIENTRY mock_glLinkProgram(GLuint program) { COUNT(glLinkProgram); (void)program; }
+static void APIENTRY mock_glGetProgramiv(GLuint program, GLenum pname, GLint* value) {
+    COUNT(glGetProgramiv); (void)program; (void)pname; *value = 1;
+}
+static void APIENTRY mock_glGetProgramInfoLog(GLuint program, GLsizei size, GLsizei* length, char* log) {
+    COUNT(glGetProgramInfoLog); (void)program;
+    if (length) *length = 0;
+    if (size > 0) log[0] = '\0';
+}
+static void APIENTRY mock_glDeleteProgram(GLuint program) { COUNT(glDeleteProgram); (void)program; }
+static GLint APIENTRY mock_glGetUniformLocation(GLuint program, const char* name) {
+    COUNT(glGetUniformLocation); (void)program;
+    unsigned int hash = 2166136261u;
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    return (GLint)(hash % 64);
+}
+static void APIENTRY mock_glUniform1f(GLint location, float x) { COUNT(glUniform1f); (void)location; (void)x; }
+static void APIENTRY mock_glUniform2f(GLint location, float x, float y) { COUNT(glUniform2f); (void)location; (void)x; (void)y; }
+static void APIENTRY mock_glUniform3f(GLint location, float x, float y, float z) {
+    COUNT(glUniform3f); (void)location; (void)x; (void)y; (void)z;
+}
+static void APIENTRY mock_glUniform4f(GLint location, float x, float y, float z, float w) {
+    COUNT(glUniform4f); (void)location; (void)x; (void)y; (void)z; (void)w;
+}
+static void APIENTRY mock_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const float* value) {
+    COUNT(glUniformMatrix4fv); (void)location; (void)count; (void)transpose; (void)value;
+}
+static GLint APIENTRY mock_glGetAttribLocation(GLuint program, const char* name) {
+    COUNT(glGetAttribLocation); (void)program; (void)name; return 0;
+}
+static void APIENTRY mock_glBindAttribLocation(GLuint program, GLuint index, const char* name) {
+    COUNT(glBindAttribLocation); (void)program; (void)index; (void)name;
+}
+static void APIENTRY mock_glUniform1i(GLint location, GLint x) { COUNT(glUniform1i); (void)location; (void)x; }
+static const GLubyte* APIENTRY mock_glGetStringi(GLenum name, GLuint index) {
+    COUNT(glGetStringi); (void)name; (void)index; return NULL;
+}
+static void APIENTRY mock_glActiveTexture(GLenum unit) { COUNT(glActiveTexture); (void)unit; }
+static void APIENTRY mock_glGenQueries(GLsizei n, GLuint* out) { COUNT(glGenQueries); gen_names(n, out); }
+static void APIENTRY mock_glDeleteQueries(GLsizei n, const GLuint* queries) { COUNT(glDeleteQueries); (void)n; (void)queries; }
+static void APIENTRY mock_glBeginQuery(GLenum target, GLuint query) { COUNT(glBeginQuery); (void)target; (void)query; }
+static void APIENTRY mock_glEndQuery(GLenum target) { COUNT(glEndQuery); (void)target; }
+static void APIENTRY mock_glGetQueryObjectiv(GLuint query, GLenum pname, GLint* value) {
+    COUNT(glGetQueryObjectiv); (void)query; (void)pname; *value = 1;
+}
+static void APIENTRY mock_glGetQueryObjectui64v(GLuint query, GLenum pname, uint64_t* value) {
+    COUNT(glGetQueryObjectui64v); (void)query; (void)pname; *value = 0;
+}
+// Fences are signalled as soon as they are made
+static GLsync APIENTRY mock_glFenceSync(GLenum condition, GLbitfield flags) {
+    COUNT(glFenceSync); (void)condition; (void)flags; return (GLsync)(size_t)g_next_name++;
+}
+static GLenum APIENTRY mock_glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    COUNT(glClientWaitSync); (void)sync; (void)flags; (void)timeout; return GL_ALREADY_SIGNALED;
+}
+static void APIENTRY mock_glDeleteSync(GLsync sync) { COUNT(glDeleteSync); (void)sync; }
+static void APIENTRY mock_glGetIntegerv(GLenum pname, GLint* data) { COUNT(glGetIntegerv); (void)pname; *data = 0; }
+static void APIENTRY mock_glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    COUNT(glDrawArrays); (void)mode; (void)first; (void)count;
+}
+static void APIENTRY mock_glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    COUNT(glDrawElements); (void)mode; (void)count; (void)type; (void)indices;
+}
+static void APIENTRY mock_glFlush(void) { COUNT(glFlush); }
+static void APIENTRY mock_glEnable(GLenum cap) { COUNT(glEnable); (void)cap; }
+static void APIENTRY mock_glDisable(GLenum cap) { COUNT(glDisable); (void)cap; }
+static GLboolean APIENTRY mock_glIsEnabled(GLenum cap) { COUNT(glIsEnabled); (void)cap; return GL_FALSE; }
+static void APIENTRY mock_glDepthMask(GLboolean flag) { COUNT(glDepthMask); (void)flag; }
+static void APIENTRY mock_glDepthFunc(GLenum func) { COUNT(glDepthFunc); (void)func; }
+static void APIENTRY mock_glCullFace(GLenum mode) { COUNT(glCullFace); (void)mode; }
+static void APIENTRY mock_glBlendFunc(GLenum sfactor, GLenum dfactor) { COUNT(glBlendFunc); (void)sfactor; (void)dfactor; }
+static void APIENTRY mock_glBindTexture(GLenum target, GLuint texture) { COUNT(glBindTexture); (void)target; (void)texture; }
+
+void mock_gl_install(void) {
+#define MOCK_GL_INSTALL(ret, name, params, args) name = mock_##name;
+    FXGL_ENTRY_POINTS(MOCK_GL_INSTALL)
+#undef MOCK_GL_INSTALL
+    // A 3.3 driver that also has every optional entry point mocked here
+    FXGLCaps* caps = &fxgl_dispatch->caps;
+    memset(caps, 0, sizeof(*caps));
+    caps->major = 3;
+    caps->minor = 3;
+    caps->timer_query = 1;
+    caps->separate_programs = 1;
+    caps->multi_draw_indirect = 1;
+    caps->shader_draw_parameters = 1;
+    caps->debug = 1;
+    mock_gl_reset();
+}
+
+void mock_gl_reset(void) {
+    memset(mock_gl_counts, 0, sizeof(mock_gl_counts));
+}
+
+unsigned long long mock_gl_total(void) {
+    unsigned long long total = 0;
+    for (int i = 0; i < MOCK_GL_CALL_COUNT; i++) total += mock_gl_counts[i];
+    return total;
+}
+
+const char* mock_gl_name(MockGLCall call) {
+    return call >= 0 && call < MOCK_GL_CALL_COUNT ? g_names[call] : "";
+}
@@ -0,0 +1,34 @@
+/*
+ * FX Shader Runtime - Mock GL Backend
+ * Counting stand-ins for every loaded GL entry point, for benchmarks without a GPU
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifndef MOCK_GL_H
+#define MOCK_GL_H
+
+#include "fx_gl.h"
+
+// One mock per entry in the loader table, so a function added there fails to
+// build here until it has a stand-in
+typedef enum MockGLCall {
+#define MOCK_GL_ENUM(ret, name, params, args) MOCK_##name,
+    FXGL_ENTRY_POINTS(MOCK_GL_ENUM)
+#undef MOCK_GL_ENUM
+    MOCK_GL_CALL_COUNT
+} MockGLCall;
+
+// Calls made to each entry point since the last reset
+extern unsigned long long mock_gl_counts[MOCK_GL_CALL_COUNT];
+
+// Points every fx_gl function pointer at its mock. Objects get increasing
+// names, compiles and links succeed, uniform locations are stable per name.
+void mock_gl_install(void);
+void mock_gl_reset(void);
+unsigned long long mock_gl_total(void);
+const char* mock_gl_name(MockGLCall call);
+
+#endif // MOCK_GL_H
@@ -0,0 +1,234 @@
+/*
+ * FX Shader Runtime - Render Queue Benchmark
+ * 50k draws of a synthetic scene, submitted directly and through FXRenderQueue
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_runtime.h"
+#include "fx_platform.h"
+
+#define SCENE_DRAWS     50000
+#define SCENE_SHADERS   16
+#define SCENE_MATERIALS 64
+#define RECORD_THREADS  4
+#define FRAMES          20
+
+// GL entry points are replaced by counters, so the timings are the CPU cost of
+// driving GL and the counts are what a driver would have to validate
+static struct {
+    unsigned long long programs;
+    unsigned long long vertex_arrays;
+    unsigned long long uniforms;
+} g_calls;
+
+static void count_use_program(GLuint program) { (void)program; g_calls.programs++; }
+static void count_bind_vertex_array(GLuint vao) { (void)vao; g_calls.vertex_arrays++; }
+static void count_uniform1f(GLint l, GLfloat x) { (void)l; (void)x; g_calls.uniforms++; }
+static void count_uniform3f(GLint l, GLfloat x, GLfloat y, GLfloat z) {
+    (void)l; (void)x; (void)y; (void)z; g_calls.uniforms++;
+}
+static void count_uniform4f(GLint l, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+    (void)l; (void)x; (void)y; (void)z; (void)w; g_calls.uniforms++;
+}
+static void count_uniform_matrix4fv(GLint l, GLsizei n, GLboolean t, const GLfloat* m) {
+    (void)l; (void)n; (void)t; (void)m; g_calls.uniforms++;
+}
+static GLuint g_next_vao = 1;
+static void stub_gen_vertex_arrays(GLsizei n, GLuint* out) { for (GLsizei i = 0; i < n; i++) out[i] = g_next_vao++; }
+static void stub_delete_vertex_arrays(GLsizei n, const GLuint* vaos) { (void)n; (void)vaos; }
+static void stub_bind_buffer(GLenum target, GLuint buffer) { (void)target; (void)buffer; }
+static void stub_enable_attrib(GLuint index) { (void)index; }
+static void stub_attrib_pointer(GLuint l, GLint c, GLenum t, GLboolean n, GLsizei s, const void* p) {
+    (void)l; (void)c; (void)t; (void)n; (void)s; (void)p;
+}
+static void stub_draw_arrays(GLenum mode, GLint first, GLsizei count) { (void)mode; (void)first; (void)count; }
+static void stub_draw_elements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    (void)mode; (void)count; (void)type; (void)indices;
+}
+static void stub_get_integerv(GLenum pname, GLint* data) { (void)pname; *data = 0; }
+
+static void install_stubs(void) {
+    glUseProgram = count_use_program;
+    glBindVertexArray = count_bind_vertex_array;
+    glUniform1f = count_uniform1f;
+    glUniform3f = count_uniform3f;
+    glUniform4f = count_uniform4f;
+    glUniformMatrix4fv = count_uniform_matrix4fv;
+    glGenVertexArrays = stub_gen_vertex_arrays;
+    glDeleteVertexArrays = stub_delete_vertex_arrays;
+    glBindBuffer = stub_bind_buffer;
+    glEnableVertexAttribArray = stub_enable_attrib;
+    glVertexAttribPointer = stub_attrib_pointer;
+    glDrawArrays = stub_draw_arrays;
+    glDrawElements = stub_draw_elements;
+    glGetIntegerv = stub_get_integerv;
+
+    // Plain 3.3: uniforms go through glUniform* on the bound program
+    FXGLCaps* caps = &fxgl_dispatch->caps;
+    memset(caps, 0, sizeof(*caps));
+    caps->major = 3;
+    caps->minor = 3;
+}
+
+// Shaders as fx_load() would leave them, minus the GL program
+static FXShader g_shaders[SCENE_SHADERS];
+
+static void make_shaders(void) {
+    static const FXReflectEntry uniforms[] = {
+        { "mat4", "modelViewProj", NULL, 0 },
+        { "vec4", "tint", NULL, 0 },
+        { "vec3", "lightDir", NULL, 0 },
+        { "float", "time", NULL, 0 },
+    };
+    static const FXReflectEntry inputs[] = {
+        { "vec3", "position", NULL, 0 },
+        { "vec3", "normal", "snorm8", 0 },
+        { "vec2", "texCoord", "half", 0 },
+    };
+    static char names[SCENE_SHADERS][32];
+    for (int i = 0; i < SCENE_SHADERS; i++) {
+        snprintf(names[i], sizeof(names[i]), "bench_%d", i);
+        size_t size = 0;
+        void* blob = fx_reflect_build(names[i], NULL, FX_REFLECT_ASSIGNED, uniforms, 4, inputs, 3, &size);
+        FXShader* s = &g_shaders[i];
+        s->name = names[i];
+        s->program = (GLuint)(i + 1);
+        s->slot = (unsigned int)(i + 1);
+        s->reflection.header = fx_reflect_validate(blob, size);
+        s->reflection.size = size;
+        s->uniforms = fx_reflect_uniforms(s->reflection.header);
+        s->uniform_count = (int)s->reflection.header->uniform_count;
+        s->inputs = fx_reflect_inputs(s->reflection.header);
+        s->input_count = (int)s->reflection.header->input_count;
+        fx_vertex_layout(s, &s->layout);
+    }
+}
+
+typedef struct SceneDraw {
+    int shader;
+    int material;
+    float depth;
+    float matrix[16];
+} SceneDraw;
+
+// Submission order is object order: shaders and materials interleave randomly
+static SceneDraw* make_scene(void) {
+    SceneDraw* draws = (SceneDraw*)malloc(SCENE_DRAWS * sizeof(SceneDraw));
+    unsigned int seed = 12345;
+    for (int i = 0; i < SCENE_DRAWS; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        draws[i].shader = (int)((seed >> 8) % SCENE_SHADERS);
+        seed = seed * 1664525u + 1013904223u;
+        draws[i].material = (int)((seed >> 8) % SCENE_MATERIALS);
+        seed = seed * 1664525u + 1013904223u;
+        draws[i].depth = (float)((seed >> 8) & 0xFFFF) / 65535.0f;
+        for (int m = 0; m < 16; m++) draws[i].matrix[m] = (float)(i + m);
+    }
+    return draws;
+}
+
+static void material_tint(int material, float* tint) {
+    tint[0] = (float)(material & 3) / 3.0f;
+    tint[1] = (float)((material >> 2) & 3) / 3.0f;
+    tint[2] = (float)((material >> 4) & 3) / 3.0f;
+    tint[3] = 1.0f;
+}
+
+static void submit_direct(const SceneDraw* draws) {
+    for (int i = 0; i < SCENE_DRAWS; i++) {
+        const SceneDraw* d = &draws[i];
+        FXShader* s = &g_shaders[d->shader];
+        float tint[4];
+        material_tint(d->material, tint);
+        fx_use(s);
+        fx_bind_vertex_buffers(s, (GLuint)(d->material + 1), 0);
+        fx_set_uniform_mat4(s, "modelViewProj", d->matrix);
+        fx_set_uniform_vec4(s, "tint", tint[0], tint[1], tint[2], tint[3]);
+        fx_set_uniform_vec3(s, "lightDir", 0.0f, 1.0f, 0.0f);
+        fx_set_uniform_float(s, "time", 1.0f);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+}
+
+typedef struct RecordJob {
+    FXRenderQueue* queue;
+    const SceneDraw* draws;
+    int thread;
+    int begin;
+    int end;
+} RecordJob;
+
+static void record_range(void* arg) {
+    RecordJob* job = (RecordJob*)arg;
+    for (int i = job->begin; i < job->end; i++) {
+        const SceneDraw* d = &job->draws[i];
+        FXShader* s = &g_shaders[d->shader];
+        float tint[4];
+        material_tint(d->material, tint);
+        FXDrawCall draw = { s, (GLuint)(d->material + 1), 0, GL_TRIANGLES, 0, 36, 0, 0 };
+        fx_queue_draw(job->queue, job->thread, fx_sort_key(s, (uint32_t)d->material, d->depth), &draw);
+        fx_queue_uniform_mat4(job->queue, job->thread, "modelViewProj", d->matrix);
+        fx_queue_uniform_vec4(job->queue, job->thread, "tint", tint[0], tint[1], tint[2], tint[3]);
+        fx_queue_uniform_vec3(job->queue, job->thread, "lightDir", 0.0f, 1.0f, 0.0f);
+        fx_queue_uniform_float(job->queue, job->thread, "time", 1.0f);
+    }
+}
+
+static void record_parallel(FXRenderQueue* queue, const SceneDraw* draws) {
+    FXThread threads[RECORD_THREADS];
+    RecordJob jobs[RECORD_THREADS];
+    int per_thread = (SCENE_DRAWS + RECORD_THREADS - 1) / RECORD_THREADS;
+    for (int t = 0; t < RECORD_THREADS; t++) {
+        jobs[t].queue = queue;
+        jobs[t].draws = draws;
+        jobs[t].thread = t;
+        jobs[t].begin = t * per_thread;
+        jobs[t].end = jobs[t].begin + per_thread < SCENE_DRAWS ? jobs[t].begin + per_thread : SCENE_DRAWS;
+        fx_thread_start(&threads[t], record_range, &jobs[t]);
+    }
+    for (int t = 0; t < RECORD_THREADS; t++) fx_thread_join(threads[t]);
+}
+
+int main(void) {
+    install_stubs();
+    make_shaders();
+    SceneDraw* draws = make_scene();
+    FXRenderQueue* queue = fx_queue_create(RECORD_THREADS);
+
+    // Warm the VAO cache so neither path pays for creation
+    submit_direct(draws);
+
+    memset(&g_calls, 0, sizeof(g_calls));
+    uint64_t start = fx_time_ns();
+    for (int f = 0; f < FRAMES; f++) submit_direct(draws);
+    double direct_ms = (double)(fx_time_ns() - start) / 1e6 / FRAMES;
+    printf("direct: %8.3f ms/frame  programs %7llu  vaos %7llu  uniforms %7llu\n", direct_ms,
+           g_calls.programs / FRAMES, g_calls.vertex_arrays / FRAMES, g_calls.uniforms / FRAMES);
+
+    memset(&g_calls, 0, sizeof(g_calls));
+    uint64_t record_ns = 0, sort_ns = 0, replay_ns = 0;
+    FXQueueStats stats;
+    for (int f = 0; f < FRAMES; f++) {
+        start = fx_time_ns();
+        record_parallel(queue, draws);
+        record_ns += fx_time_ns() - start;
+        fx_queue_submit(queue, &stats);
+        sort_ns += stats.sort_ns;
+        replay_ns += stats.replay_ns;
+    }
+    printf("queue:  %8.3f ms/frame  programs %7llu  vaos %7llu  uniforms %7llu\n",
+           (double)(record_ns + sort_ns + replay_ns) / 1e6 / FRAMES,
+           g_calls.programs / FRAMES, g_calls.vertex_arrays / FRAMES, g_calls.uniforms / FRAMES);
+    printf("        record %.3f ms (%d threads), sort %.3f ms, replay %.3f ms, %d uniforms skipped\n",
+           (double)record_ns / 1e6 / FRAMES, RECORD_THREADS, (double)sort_ns / 1e6 / FRAMES,
+           (double)replay_ns / 1e6 / FRAMES, stats.uniforms_skipped);
+
+    fx_queue_destroy(queue);
+    fx_vertex_cache_clear();
+    for (int i = 0; i < SCENE_SHADERS; i++) free(g_shaders[i].reflection.header);
+    free(draws);
+    return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * FX Shader Runtime - Runtime Micro-Benchmarks
+ * Load, uniform, program switch and cleanup costs against the mock GL backend
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_runtime.h"
+#include "fx_platform.h"
+#include "fxc.h"
+#include "mock_gl.h"
+
+#define BENCH_SHADER  "runtime_bench_shader"
+#define LOAD_OPS      2000
+#define UNIFORM_OPS   2000000
+#define USE_OPS       2000000
+#define REPEATS       5
+
+// Output is one JSON object per line: ns/op is the best of REPEATS runs, GL
+// calls per op come from the mock's counts over call_ops operations
+static const char* g_source =
+    "uniform mat4 modelViewProj;\n"
+    "uniform vec4 tint;\n"
+    "uniform vec3 lightDir;\n"
+    "uniform float time;\n"
+    "input vec3 position;\n"
+    "input vec3 normal packed(snorm8);\n"
+    "input vec2 texCoord packed(half);\n"
+    "vertex_shader() {\n"
+    "    gl_Position = modelViewProj * vec4(position, 1.0);\n"
+    "}\n"
+    "fragment_shader() {\n"
+    "    fragColor = tint * max(dot(normal, lightDir), 0.0) * time;\n"
+    "}\n";
+
+static void report(const char* name, int ops, uint64_t best_ns, int call_ops) {
+    printf("{\"bench\":\"%s\",\"ops\":%d,\"ns_per_op\":%.2f,\"gl_calls_per_op\":%.3f,\"calls\":{",
+           name, ops, (double)best_ns / ops, (double)mock_gl_total() / call_ops);
+    const char* separator = "";
+    for (int i = 0; i < MOCK_GL_CALL_COUNT; i++) {
+        if (!mock_gl_counts[i]) continue;
+        printf("%s\"%s\":%.3f", separator, mock_gl_name((MockGLCall)i), (double)mock_gl_counts[i] / call_ops);
+        separator = ",";
+    }
+    printf("}}\n");
+}
+
+static int write_file(const char* path, const void* data, size_t size) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return 0;
+    size_t written = fwrite(data, 1, size, f);
+    fclose(f);
+    return written == size;
+}
+
+// What 'fxc runtime_bench_shader.fx' would leave on disk
+static int write_shader_files(void) {
+    FXCOptions options = {0};
+    options.name = BENCH_SHADER;
+    FXCResult result;
+    int ok = fxc_compile_source(g_source, strlen(g_source), &options, &result) == FXC_OK;
+    if (ok) {
+        const FXCShaderOutput* out = &result.shaders[0];
+        ok = write_file(BENCH_SHADER ".vert.glsl", out->vertex_glsl, strlen(out->vertex_glsl)) &&
+             write_file(BENCH_SHADER ".frag.glsl", out->fragment_glsl, strlen(out->fragment_glsl)) &&
+             write_file(BENCH_SHADER ".meta", out->metadata, out->metadata_size);
+    } else {
+        fprintf(stderr, "Bench shader failed to compile: %s\n", result.error);
+    }
+    fxc_result_free(&result);
+    return ok;
+}
+
+static void remove_shader_files(void) {
+    remove(BENCH_SHADER ".vert.glsl");
+    remove(BENCH_SHADER ".frag.glsl");
+    remove(BENCH_SHADER ".meta");
+}
+
+// fx_load() of files that are in the page cache, and the fx_cleanup() that
+// follows; timed apart so each gets its own line
+static void bench_load_cleanup(void) {
+    uint64_t best_load = UINT64_MAX, best_cleanup = UINT64_MAX;
+    unsigned long long load_counts[MOCK_GL_CALL_COUNT], cleanup_counts[MOCK_GL_CALL_COUNT];
+    for (int r = 0; r < REPEATS; r++) {
+        uint64_t load_ns = 0, cleanup_ns = 0;
+        memset(load_counts, 0, sizeof(load_counts));
+        memset(cleanup_counts, 0, sizeof(cleanup_counts));
+        for (int i = 0; i < LOAD_OPS; i++) {
+            mock_gl_reset();
+            uint64_t start = fx_time_ns();
+            FXShader* shader = fx_load(BENCH_SHADER);
+            load_ns += fx_time_ns() - start;
+            for (int c = 0; c < MOCK_GL_CALL_COUNT; c++) load_counts[c] += mock_gl_counts[c];
+
+            mock_gl_reset();
+            start = fx_time_ns();
+            fx_cleanup(shader);
+            cleanup_ns += fx_time_ns() - start;
+            for (int c = 0; c < MOCK_GL_CALL_COUNT; c++) cleanup_counts[c] += mock_gl_counts[c];
+        }
+        if (load_ns < best_load) best_load = load_ns;
+        if (cleanup_ns < best_cleanup) best_cleanup = cleanup_ns;
+    }
+    memcpy(mock_gl_counts, load_counts, sizeof(load_counts));
+    report("fx_load", LOAD_OPS, best_load, LOAD_OPS);
+    memcpy(mock_gl_counts, cleanup_counts, sizeof(cleanup_counts));
+    report("fx_cleanup", LOAD_OPS, best_cleanup, LOAD_OPS);
+}
+
+// fx_load_source(): the .fx compiled in process, then the same GL work
+static void bench_load_source(void) {
+    uint64_t best = UINT64_MAX;
+    size_t length = strlen(g_source);
+    for (int r = 0; r < REPEATS; r++) {
+        uint64_t ns = 0;
+        for (int i = 0; i < LOAD_OPS; i++) {
+            uint64_t start = fx_time_ns();
+            FXShader* shader = fx_load_source(BENCH_SHADER "_source", g_source, length);
+            ns += fx_time_ns() - start;
+            fx_cleanup(shader);
+        }
+        if (ns < best) best = ns;
+    }
+    // One more, counted on its own, for calls per op
+    mock_gl_reset();
+    FXShader* shader = fx_load_source(BENCH_SHADER "_source", g_source, length);
+    report("fx_load_source", LOAD_OPS, best, 1);
+    fx_cleanup(shader);
+}
+
+typedef enum UniformKind { UNIFORM_FLOAT, UNIFORM_VEC3, UNIFORM_VEC4, UNIFORM_MAT4 } UniformKind;
+
+static void bench_uniform(FXShader* shader, UniformKind kind, const char* name) {
+    static const float matrix[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < REPEATS; r++) {
+        mock_gl_reset();
+        uint64_t start = fx_time_ns();
+        for (int i = 0; i < UNIFORM_OPS; i++) {
+            float v = (float)i;
+            switch (kind) {
+                case UNIFORM_FLOAT: fx_set_uniform_float(shader, "time", v); break;
+                case UNIFORM_VEC3:  fx_set_uniform_vec3(shader, "lightDir", v, 1.0f, 0.0f); break;
+                case UNIFORM_VEC4:  fx_set_uniform_vec4(shader, "tint", v, 1.0f, 1.0f, 1.0f); break;
+                case UNIFORM_MAT4:  fx_set_uniform_mat4(shader, "modelViewProj", matrix); break;
+            }
+        }
+        uint64_t ns = fx_time_ns() - start;
+        if (ns < best) best = ns;
+    }
+    report(name, UNIFORM_OPS, best, UNIFORM_OPS);
+}
+
+static void bench_use(FXShader* a, FXShader* b, const char* name) {
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < REPEATS; r++) {
+        mock_gl_reset();
+        uint64_t start = fx_time_ns();
+        for (int i = 0; i < USE_OPS; i += 2) {
+            fx_use(a);
+            fx_use(b);
+        }
+        uint64_t ns = fx_time_ns() - start;
+        if (ns < best) best = ns;
+    }
+    report(name, USE_OPS, best, USE_OPS);
+}
+
+int main(void) {
+    mock_gl_install();
+    if (!write_shader_files()) return 1;
+
+    bench_load_cleanup();
+    bench_load_source();
+
+    FXShader* a = fx_load(BENCH_SHADER);
+    FXShader* b = fx_load_source(BENCH_SHADER "_source", g_source, strlen(g_source));
+    if (!a || !b) return 1;
+    fx_use(a);
+    bench_uniform(a, UNIFORM_FLOAT, "fx_set_uniform_float");
+    bench_uniform(a, UNIFORM_VEC3, "fx_set_uniform_vec3");
+    bench_uniform(a, UNIFORM_VEC4, "fx_set_uniform_vec4");
+    bench_uniform(a, UNIFORM_MAT4, "fx_set_uniform_mat4");
+
+    // Before 4.1: a write to the bound program, and one bound for the write
+    // and put back
+    fxgl_dispatch->caps.separate_programs = 0;
+    bench_uniform(a, UNIFORM_VEC4, "fx_set_uniform_vec4_gl33_bound");
+    bench_uniform(b, UNIFORM_VEC4, "fx_set_uniform_vec4_gl33_unbound");
+    fxgl_dispatch->caps.separate_programs = 1;
+
+    bench_use(a, b, "fx_use_switch");
+    bench_use(a, a, "fx_use_same");
+
+    fx_cleanup(a);
+    fx_cleanup(b);
+    remove_shader_files();
+    return 0;
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+# Linux build: EGL or GLX through the same loader, headless with EGL
+set -e
+mkdir -p bin
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_gl.c -o bin/fx_gl.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_runtime.c -o bin/fx_runtime.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_async.c -o bin/fx_async.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_compile.c -o bin/fx_compile.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_trace.c -o bin/fx_trace.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_debug.c -o bin/fx_debug.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_profile.c -o bin/fx_profile.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_registry.c -o bin/fx_registry.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_reload.c -o bin/fx_reload.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_vertex.c -o bin/fx_vertex.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_pack.c -o bin/fx_pack.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_queue.c -o bin/fx_queue.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_batch.c -o bin/fx_batch.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_texture.c -o bin/fx_texture.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_pipeline.c -o bin/fx_pipeline.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_timing.c -o bin/fx_timing.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_stats.c -o bin/fx_stats.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_platform.c -o bin/fx_platform.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fx_reflect.c -o bin/fx_reflect.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fxc_lib.c -o bin/fxc_lib.o
+gcc -std=c99 -Wall -Wextra -O2 -c src/fxc.c -o bin/fxc.o
+gcc -std=c99 -Wall -Wextra -O2 -o bin/fxc bin/fxc.o bin/fxc_lib.o bin/fx_gl.o bin/fx_runtime.o bin/fx_async.o bin/fx_compile.o bin/fx_trace.o bin/fx_debug.o bin/fx_profile.o bin/fx_registry.o bin/fx_reload.o bin/fx_vertex.o bin/fx_pack.o bin/fx_queue.o bin/fx_batch.o bin/fx_texture.o bin/fx_pipeline.o bin/fx_timing.o bin/fx_stats.o bin/fx_platform.o bin/fx_reflect.o -lGL -ldl -lpthread
+gcc -std=c99 -Wall -Wextra -O2 -Isrc -o bin/queue_bench bench/queue_bench.c bin/fxc_lib.o bin/fx_gl.o bin/fx_runtime.o bin/fx_async.o bin/fx_compile.o bin/fx_trace.o bin/fx_debug.o bin/fx_profile.o bin/fx_registry.o bin/fx_reload.o bin/fx_vertex.o bin/fx_pack.o bin/fx_queue.o bin/fx_batch.o bin/fx_texture.o bin/fx_pipeline.o bin/fx_timing.o bin/fx_stats.o bin/fx_platform.o bin/fx_reflect.o -lGL -ldl -lpthread
+gcc -std=c99 -Wall -Wextra -O2 -Isrc -Ibench -o bin/runtime_bench bench/runtime_bench.c bench/mock_gl.c bin/fxc_lib.o bin/fx_gl.o bin/fx_runtime.o bin/fx_async.o bin/fx_compile.o bin/fx_trace.o bin/fx_debug.o bin/fx_profile.o bin/fx_registry.o bin/fx_reload.o bin/fx_vertex.o bin/fx_pack.o bin/fx_queue.o bin/fx_batch.o bin/fx_texture.o bin/fx_pipeline.o bin/fx_timing.o bin/fx_stats.o bin/fx_platform.o bin/fx_reflect.o -lGL -ldl -lpthread
+gcc -std=c99 -Wall -Wextra -O2 -Isrc -Ibench -o bin/fxreplay bench/fxreplay.c bench/mock_gl.c bin/fxc_lib.o bin/fx_gl.o bin/fx_runtime.o bin/fx_async.o bin/fx_compile.o bin/fx_trace.o bin/fx_debug.o bin/fx_profile.o bin/fx_registry.o bin/fx_reload.o bin/fx_vertex.o bin/fx_pack.o bin/fx_queue.o bin/fx_batch.o bin/fx_texture.o bin/fx_pipeline.o bin/fx_timing.o bin/fx_stats.o bin/fx_platform.o bin/fx_reflect.o -lGL -ldl -lpthread
+echo Build complete.
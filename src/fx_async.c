@@ -0,0 +1,195 @@
+/*
+ * FX Shader Runtime - Asynchronous Loading
+ * Worker pool for file I/O and metadata parsing, GL work drained by fx_poll()
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+#include "fx_platform.h"
+
+#define FX_ASYNC_MAX_WORKERS 8
+#define FX_ASYNC_DEFAULT_BUDGET_MS 2.0
+
+// Jobs flow pending -> (worker reads files) -> ready -> (fx_poll compiles)
+typedef struct {
+    FXLoadJob* head;
+    FXLoadJob* tail;
+} FXJobQueue;
+
+static struct {
+    int running;
+    int shutting_down;
+    int worker_count;
+    uint64_t budget_ns;
+    FXThread workers[FX_ASYNC_MAX_WORKERS];
+
+    FXMutex pending_lock;
+    FXCond pending_cond;
+    FXJobQueue pending;
+
+    FXMutex ready_lock;
+    FXJobQueue ready;
+    int ready_count;    // Read without the lock so an idle fx_poll() is one load
+} g_async;
+
+static void queue_push(FXJobQueue* q, FXLoadJob* job) {
+    job->next = NULL;
+    if (q->tail) q->tail->next = job;
+    else q->head = job;
+    q->tail = job;
+}
+
+static FXLoadJob* queue_pop(FXJobQueue* q) {
+    FXLoadJob* job = q->head;
+    if (job) {
+        q->head = job->next;
+        if (!q->head) q->tail = NULL;
+        job->next = NULL;
+    }
+    return job;
+}
+
+static void worker_main(void* arg) {
+    (void)arg;
+    for (;;) {
+        fx_mutex_lock(&g_async.pending_lock);
+        while (!g_async.pending.head && !g_async.shutting_down) {
+            fx_cond_wait(&g_async.pending_cond, &g_async.pending_lock);
+        }
+        if (g_async.shutting_down) {
+            fx_mutex_unlock(&g_async.pending_lock);
+            return;
+        }
+        FXLoadJob* job = queue_pop(&g_async.pending);
+        fx_mutex_unlock(&g_async.pending_lock);
+
+        // A failed read still goes to the ready queue so the callback fires
+        fx_load_job_read(job);
+
+        fx_mutex_lock(&g_async.ready_lock);
+        queue_push(&g_async.ready, job);
+        fx_atomic_add(&g_async.ready_count, 1);
+        fx_mutex_unlock(&g_async.ready_lock);
+    }
+}
+
+int fx_async_init(int worker_count, double budget_ms) {
+    if (g_async.running) return 1;
+
+    if (worker_count <= 0) {
+        // Leave a core for the render thread
+        worker_count = fx_cpu_count() - 1;
+        if (worker_count < 1) worker_count = 1;
+        if (worker_count > 4) worker_count = 4;
+    }
+    if (worker_count > FX_ASYNC_MAX_WORKERS) worker_count = FX_ASYNC_MAX_WORKERS;
+    if (budget_ms <= 0.0) budget_ms = FX_ASYNC_DEFAULT_BUDGET_MS;
+
+    fx_mutex_init(&g_async.pending_lock);
+    fx_cond_init(&g_async.pending_cond);
+    fx_mutex_init(&g_async.ready_lock);
+    g_async.pending.head = g_async.pending.tail = NULL;
+    g_async.ready.head = g_async.ready.tail = NULL;
+    g_async.ready_count = 0;
+    g_async.shutting_down = 0;
+    g_async.budget_ns = (uint64_t)(budget_ms * 1000000.0);
+
+    g_async.worker_count = 0;
+    for (int i = 0; i < worker_count; i++) {
+        if (!fx_thread_start(&g_async.workers[i], worker_main, NULL)) {
+            fprintf(stderr, "Could not start shader loader thread %d\n", i);
+            break;
+        }
+        g_async.worker_count++;
+    }
+    if (g_async.worker_count == 0) {
+        fx_mutex_destroy(&g_async.pending_lock);
+        fx_cond_destroy(&g_async.pending_cond);
+        fx_mutex_destroy(&g_async.ready_lock);
+        return 0;
+    }
+
+    g_async.running = 1;
+    return 1;
+}
+
+void fx_async_shutdown(void) {
+    if (!g_async.running) return;
+
+    fx_mutex_lock(&g_async.pending_lock);
+    g_async.shutting_down = 1;
+    fx_cond_broadcast(&g_async.pending_cond);
+    fx_mutex_unlock(&g_async.pending_lock);
+
+    for (int i = 0; i < g_async.worker_count; i++) {
+        fx_thread_join(g_async.workers[i]);
+    }
+
+    // Loads still in flight are dropped without calling back
+    FXLoadJob* job;
+    while ((job = queue_pop(&g_async.pending)) != NULL) fx_load_job_free(job);
+    while ((job = queue_pop(&g_async.ready)) != NULL) fx_load_job_free(job);
+
+    fx_mutex_destroy(&g_async.pending_lock);
+    fx_cond_destroy(&g_async.pending_cond);
+    fx_mutex_destroy(&g_async.ready_lock);
+    g_async.running = 0;
+}
+
+void fx_load_async(const char* shader_name, FXLoadCallback callback, void* user) {
+    if (!g_async.running && !fx_async_init(0, 0.0)) {
+        // No worker threads available: degrade to a synchronous load
+        FXShader* shader = fx_load(shader_name);
+        if (callback) callback(shader, user);
+        return;
+    }
+
+    FXLoadJob* job = fx_load_job_create(shader_name);
+    if (!job) {
+        if (callback) callback(NULL, user);
+        return;
+    }
+    job->callback = callback;
+    job->user = user;
+
+    fx_mutex_lock(&g_async.pending_lock);
+    queue_push(&g_async.pending, job);
+    fx_cond_signal(&g_async.pending_cond);
+    fx_mutex_unlock(&g_async.pending_lock);
+}
+
+int fx_poll(void) {
+    int completed = 0;
+
+    // Each check is a single load when there is nothing to do
+    if (fx_atomic_load(&fx_reload_pending)) completed += fx_reload_apply();
+    if (fx_atomic_load(&fx_compile_pending)) completed += fx_compile_apply();
+    if (!g_async.running || fx_atomic_load(&g_async.ready_count) == 0) return completed;
+
+    // Always finish at least one job so a tiny budget still makes progress
+    uint64_t start = fx_time_ns();
+    do {
+        fx_mutex_lock(&g_async.ready_lock);
+        FXLoadJob* job = queue_pop(&g_async.ready);
+        if (job) fx_atomic_sub(&g_async.ready_count, 1);
+        fx_mutex_unlock(&g_async.ready_lock);
+        if (!job) break;
+
+        // The shader may have become resident since the job was queued
+        FXShader* shader = fx_registry_acquire(job->name);
+        if (!shader && job->vert_source && fx_compile_running) {
+            // Calls back from a later fx_poll(), once built
+            fx_compile_submit(job);
+            continue;
+        }
+        if (!shader) shader = fx_load_job_finish(job);
+        if (job->callback) job->callback(shader, job->user);
+        fx_load_job_free(job);
+        completed++;
+    } while (fx_time_ns() - start < g_async.budget_ns);
+
+    return completed;
+}
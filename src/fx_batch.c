@@ -0,0 +1,347 @@
+/*
+ * FX Shader Runtime - Multi-Draw Batches
+ * Draws grouped per program and issued with glMultiDraw*Indirect on GL 4.3
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+
+// DrawElementsIndirectCommand. Non-indexed groups use the same 20-byte slots
+// with stride 20: { count, instance_count, first, base_instance = 0, unused }.
+typedef struct FXIndirectCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first;
+    GLint base_vertex;
+    GLuint base_instance;
+} FXIndirectCommand;
+
+typedef struct FXBatchGroup {
+    FXShader* shader;
+    GLuint vertex_buffer;
+    GLuint index_buffer;
+    GLenum mode;
+    GLenum index_type;
+    uint32_t stride;            // fx_reflect_draw_stride() of the shader
+    uint32_t draw_count;
+    uint32_t first;             // Submit: first command in the staging array
+    size_t data_offset;         // Submit: where its FXDrawData starts in the draw buffer
+} FXBatchGroup;
+
+typedef struct FXBatchDraw {
+    uint32_t group;
+    uint32_t data_offset;       // In FXDrawBatch::data
+    FXIndirectCommand command;
+} FXBatchDraw;
+
+struct FXDrawBatch {
+    FXBatchGroup* groups;
+    int group_count;
+    int group_capacity;
+    int last_group;             // Consecutive draws usually share a group
+    FXBatchDraw* draws;
+    uint32_t draw_count;
+    uint32_t draw_capacity;
+    unsigned char* data;        // FXDrawData of every draw, in recording order
+    size_t data_size;
+    size_t data_capacity;
+    FXIndirectCommand* commands;    // Staging, grouped, kept between frames
+    uint32_t command_capacity;
+    unsigned char* staging;
+    size_t staging_capacity;
+    GLuint indirect_buffer;
+    GLuint draw_buffer;
+    GLint storage_alignment;
+};
+
+FXDrawBatch* fx_batch_create(void) {
+    FXDrawBatch* batch = (FXDrawBatch*)calloc(1, sizeof(FXDrawBatch));
+    if (batch) batch->last_group = -1;
+    return batch;
+}
+
+void fx_batch_destroy(FXDrawBatch* batch) {
+    if (!batch) return;
+    if (batch->indirect_buffer) glDeleteBuffers(1, &batch->indirect_buffer);
+    if (batch->draw_buffer) glDeleteBuffers(1, &batch->draw_buffer);
+    free(batch->groups);
+    free(batch->draws);
+    free(batch->data);
+    free(batch->commands);
+    free(batch->staging);
+    free(batch);
+}
+
+static int group_matches(const FXBatchGroup* g, const FXDrawCall* draw) {
+    return g->shader == draw->shader && g->vertex_buffer == draw->vertex_buffer &&
+           g->index_buffer == draw->index_buffer && g->mode == draw->mode &&
+           (!draw->index_buffer || g->index_type == draw->index_type);
+}
+
+// Groups are few (about one per program), so a scan is cheaper than a table
+static int find_group(FXDrawBatch* batch, const FXDrawCall* draw) {
+    if (batch->last_group >= 0 && group_matches(&batch->groups[batch->last_group], draw)) {
+        return batch->last_group;
+    }
+    for (int i = 0; i < batch->group_count; i++) {
+        if (group_matches(&batch->groups[i], draw)) return batch->last_group = i;
+    }
+    if (batch->group_count == batch->group_capacity) {
+        int capacity = batch->group_capacity ? batch->group_capacity * 2 : 16;
+        FXBatchGroup* groups = (FXBatchGroup*)realloc(batch->groups, capacity * sizeof(FXBatchGroup));
+        if (!groups) return -1;
+        batch->groups = groups;
+        batch->group_capacity = capacity;
+    }
+    FXBatchGroup* g = &batch->groups[batch->group_count];
+    memset(g, 0, sizeof(*g));
+    g->shader = draw->shader;
+    g->vertex_buffer = draw->vertex_buffer;
+    g->index_buffer = draw->index_buffer;
+    g->mode = draw->mode;
+    g->index_type = draw->index_type;
+    g->stride = fx_reflect_draw_stride(draw->shader->reflection.header);
+    return batch->last_group = batch->group_count++;
+}
+
+static GLuint index_size(GLenum index_type) {
+    switch (index_type) {
+        case GL_UNSIGNED_BYTE:  return 1;
+        case GL_UNSIGNED_SHORT: return 2;
+        default:                return 4;
+    }
+}
+
+void* fx_batch_draw(FXDrawBatch* batch, const FXDrawCall* draw) {
+    if (!batch || !draw || !draw->shader) return NULL;
+    int group = find_group(batch, draw);
+    if (group < 0) return NULL;
+    uint32_t stride = batch->groups[group].stride;
+
+    if (batch->draw_count == batch->draw_capacity) {
+        uint32_t capacity = batch->draw_capacity ? batch->draw_capacity * 2 : 1024;
+        FXBatchDraw* draws = (FXBatchDraw*)realloc(batch->draws, capacity * sizeof(FXBatchDraw));
+        if (!draws) return NULL;
+        batch->draws = draws;
+        batch->draw_capacity = capacity;
+    }
+    if (batch->data_size + stride > batch->data_capacity) {
+        size_t capacity = batch->data_capacity ? batch->data_capacity * 2 : 64 * 1024;
+        while (capacity < batch->data_size + stride) capacity *= 2;
+        unsigned char* data = (unsigned char*)realloc(batch->data, capacity);
+        if (!data) return NULL;
+        batch->data = data;
+        batch->data_capacity = capacity;
+    }
+
+    FXBatchDraw* d = &batch->draws[batch->draw_count++];
+    d->group = (uint32_t)group;
+    d->data_offset = (uint32_t)batch->data_size;
+    d->command.count = (GLuint)draw->count;
+    d->command.instance_count = 1;
+    d->command.first = draw->index_buffer ? (GLuint)(draw->first / index_size(draw->index_type))
+                                          : (GLuint)draw->first;
+    d->command.base_vertex = draw->index_buffer ? draw->base_vertex : 0;
+    d->command.base_instance = 0;
+    batch->groups[group].draw_count++;
+
+    unsigned char* data = batch->data + batch->data_size;
+    memset(data, 0, stride);
+    batch->data_size += stride;
+    return stride ? data : NULL;
+}
+
+// Writes a per_draw value into the batch's last draw
+static void batch_set(FXDrawBatch* batch, const char* name, FXReflectType type, const float* values, int count) {
+    if (!batch || !batch->draw_count) return;
+    FXBatchDraw* d = &batch->draws[batch->draw_count - 1];
+    FXShader* shader = batch->groups[d->group].shader;
+    if (!shader->reflection.header) return;
+    FXReflectRecord* record = fx_reflect_find(shader->reflection.header, shader->uniforms,
+                                              shader->uniform_count, name);
+    if (!record || !record->divisor || record->type != type) return;
+    memcpy(batch->data + d->data_offset + record->offset, values, count * sizeof(float));
+}
+
+void fx_batch_set_float(FXDrawBatch* batch, const char* name, float value) {
+    batch_set(batch, name, FX_TYPE_FLOAT, &value, 1);
+}
+
+void fx_batch_set_vec3(FXDrawBatch* batch, const char* name, float x, float y, float z) {
+    float values[3] = { x, y, z };
+    batch_set(batch, name, FX_TYPE_VEC3, values, 3);
+}
+
+void fx_batch_set_vec4(FXDrawBatch* batch, const char* name, float x, float y, float z, float w) {
+    float values[4] = { x, y, z, w };
+    batch_set(batch, name, FX_TYPE_VEC4, values, 4);
+}
+
+void fx_batch_set_mat4(FXDrawBatch* batch, const char* name, const float* matrix) {
+    batch_set(batch, name, FX_TYPE_MAT4, matrix, 16);
+}
+
+// gl43 shaders on a context with multi-draw indirect, and gl_DrawIDARB for
+// those with per_draw values; everything else takes the per-draw uniform path
+static int uses_draw_buffer(const FXBatchGroup* g) {
+    const FXGLCaps* caps = fxgl_caps();
+    const FXReflectHeader* header = g->shader->reflection.header;
+    return caps->multi_draw_indirect && header && (header->flags & FX_REFLECT_GL43) &&
+           (!g->stride || caps->shader_draw_parameters);
+}
+
+// Lays the groups out back to back: commands contiguous per group, and each
+// group's FXDrawData starting on a shader storage offset boundary so
+// gl_DrawID 0 is its first draw. Without an indirect group the data is only
+// read back for uniforms, and a 3.3 context has no such boundary to ask for.
+// Returns 0 when out of memory.
+static int stage(FXDrawBatch* batch, int indirect) {
+    if (indirect && !batch->storage_alignment) {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &batch->storage_alignment);
+        if (batch->storage_alignment < 1) batch->storage_alignment = 256;
+    }
+    size_t alignment = indirect ? (size_t)batch->storage_alignment : 1;
+    uint32_t first = 0;
+    size_t data_size = 0;
+    for (int i = 0; i < batch->group_count; i++) {
+        FXBatchGroup* g = &batch->groups[i];
+        g->first = first;
+        first += g->draw_count;
+        data_size = (data_size + alignment - 1) / alignment * alignment;
+        g->data_offset = data_size;
+        data_size += (size_t)g->draw_count * g->stride;
+    }
+
+    if (batch->draw_count > batch->command_capacity) {
+        FXIndirectCommand* commands = (FXIndirectCommand*)realloc(batch->commands,
+                                                                  batch->draw_count * sizeof(FXIndirectCommand));
+        if (!commands) return 0;
+        batch->commands = commands;
+        batch->command_capacity = batch->draw_count;
+    }
+    if (data_size > batch->staging_capacity) {
+        unsigned char* staging = (unsigned char*)realloc(batch->staging, data_size);
+        if (!staging) return 0;
+        batch->staging = staging;
+        batch->staging_capacity = data_size;
+    }
+
+    // Counting sort by group; draws keep their recording order within one
+    for (int i = 0; i < batch->group_count; i++) batch->groups[i].draw_count = 0;
+    for (uint32_t i = 0; i < batch->draw_count; i++) {
+        const FXBatchDraw* d = &batch->draws[i];
+        FXBatchGroup* g = &batch->groups[d->group];
+        uint32_t slot = g->draw_count++;
+        batch->commands[g->first + slot] = d->command;
+        memcpy(batch->staging + g->data_offset + (size_t)slot * g->stride, batch->data + d->data_offset, g->stride);
+    }
+    return 1;
+}
+
+static void upload(GLenum target, GLuint* buffer, const void* data, size_t size) {
+    if (!*buffer) glGenBuffers(1, buffer);
+    glBindBuffer(target, *buffer);
+    glBufferData(target, (ptrdiff_t)size, data, GL_STREAM_DRAW);
+}
+
+static void apply_per_draw(const FXShader* shader, const unsigned char* data) {
+    for (int i = 0; i < shader->uniform_count; i++) {
+        const FXReflectRecord* r = &shader->uniforms[i];
+        if (!r->divisor || r->location < 0) continue;
+        float v[16];
+        memcpy(v, data + r->offset, (size_t)fx_reflect_components((FXReflectType)r->type) * sizeof(float));
+        switch (r->type) {
+            case FX_TYPE_FLOAT: glUniform1f(r->location, v[0]); break;
+            case FX_TYPE_VEC2:  glUniform2f(r->location, v[0], v[1]); break;
+            case FX_TYPE_VEC3:  glUniform3f(r->location, v[0], v[1], v[2]); break;
+            case FX_TYPE_VEC4:  glUniform4f(r->location, v[0], v[1], v[2], v[3]); break;
+            case FX_TYPE_MAT4:  glUniformMatrix4fv(r->location, 1, GL_FALSE, v); break;
+            default: continue;
+        }
+        FX_STAT_ADD(uniform_uploads, 1);
+    }
+}
+
+// Pre-4.3 path: the same draws, one call each
+static void submit_group_singly(FXDrawBatch* batch, const FXBatchGroup* g, FXBatchStats* stats) {
+    for (uint32_t i = 0; i < g->draw_count; i++) {
+        const FXIndirectCommand* c = &batch->commands[g->first + i];
+        apply_per_draw(g->shader, batch->staging + g->data_offset + (size_t)i * g->stride);
+        if (g->index_buffer) {
+            const void* offset = (const void*)((size_t)c->first * index_size(g->index_type));
+            if (c->base_vertex) {
+                glDrawElementsBaseVertex(g->mode, (GLsizei)c->count, g->index_type, offset, c->base_vertex);
+            } else {
+                glDrawElements(g->mode, (GLsizei)c->count, g->index_type, offset);
+            }
+        } else {
+            glDrawArrays(g->mode, (GLint)c->first, (GLsizei)c->count);
+        }
+        stats->single_draws++;
+    }
+}
+
+void fx_batch_submit(FXDrawBatch* batch, FXBatchStats* stats) {
+    FXBatchStats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!batch || !batch->draw_count) return;
+
+    int indirect = 0;
+    for (int i = 0; i < batch->group_count && !indirect; i++) indirect = uses_draw_buffer(&batch->groups[i]);
+
+    if (stage(batch, indirect)) {
+        size_t data_size = 0;
+        for (int i = 0; i < batch->group_count; i++) {
+            const FXBatchGroup* g = &batch->groups[i];
+            if (!uses_draw_buffer(g)) continue;
+            if (g->data_offset + (size_t)g->draw_count * g->stride > data_size) {
+                data_size = g->data_offset + (size_t)g->draw_count * g->stride;
+            }
+        }
+        if (indirect) {
+            upload(GL_DRAW_INDIRECT_BUFFER, &batch->indirect_buffer, batch->commands,
+                   batch->draw_count * sizeof(FXIndirectCommand));
+            if (data_size) upload(GL_SHADER_STORAGE_BUFFER, &batch->draw_buffer, batch->staging, data_size);
+        }
+
+        GLuint program = 0;
+        for (int i = 0; i < batch->group_count; i++) {
+            const FXBatchGroup* g = &batch->groups[i];
+            if (!g->draw_count) continue;
+            if (g->shader->program != program) {
+                glUseProgram(g->shader->program);
+                program = g->shader->program;
+                fx_program_bound(g->shader);
+            }
+            fx_bind_vertex_buffers(g->shader, g->vertex_buffer, g->index_buffer);
+            if (!uses_draw_buffer(g)) {
+                submit_group_singly(batch, g, stats);
+                continue;
+            }
+            if (g->stride) {
+                glBindBufferRange(GL_SHADER_STORAGE_BUFFER, FX_DRAW_BUFFER_BINDING, batch->draw_buffer,
+                                  (ptrdiff_t)g->data_offset, (ptrdiff_t)((size_t)g->draw_count * g->stride));
+            }
+            const void* commands = (const void*)((size_t)g->first * sizeof(FXIndirectCommand));
+            if (g->index_buffer) {
+                glMultiDrawElementsIndirect(g->mode, g->index_type, commands, (GLsizei)g->draw_count,
+                                            sizeof(FXIndirectCommand));
+            } else {
+                glMultiDrawArraysIndirect(g->mode, commands, (GLsizei)g->draw_count, sizeof(FXIndirectCommand));
+            }
+            stats->multi_draws++;
+        }
+        if (fx_gpu_timing_enabled) fx_gpu_timing_end();
+        stats->draws = (int)batch->draw_count;
+        stats->groups = batch->group_count;
+    }
+
+    batch->group_count = 0;
+    batch->last_group = -1;
+    batch->draw_count = 0;
+    batch->data_size = 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * FX Shader Runtime - Background Compile Thread
+ * Compile and link on a shared GL context, fenced back to the GL thread by fx_poll()
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+
+// Jobs flow submitted -> (compile thread builds and fences) -> built ->
+// (fx_poll waits out the fence and adopts). Both hand-offs are lock-free
+// stacks: the producer pushes with a CAS, the consumer takes the whole stack
+// with one exchange, so no node is ever popped alone and ABA cannot happen.
+int fx_compile_running = 0;
+int fx_compile_pending = 0;
+
+static struct {
+    FXThread thread;
+    FXGLSharedContext* context;
+    FXGLDispatch* dispatch;     // Copy of the GL thread's table, fully resolved
+    FXLoadJob* submitted;       // Newest first
+    FXLoadJob* built;           // Newest first
+    FXLoadJob* waiting;         // GL thread only: fence not signalled yet, oldest first
+    FXMutex wake_lock;          // Only for sleeping while idle and the start handshake
+    FXCond wake_cond;
+    int stopping;
+    int started;                // 1 once the context is current, -1 if it couldn't be
+} g_compile;
+
+static void stack_push(FXLoadJob** stack, FXLoadJob* job) {
+    FXLoadJob* head = fx_atomic_load(stack);
+    do {
+        job->next = head;
+    } while (!fx_atomic_compare_exchange(stack, &head, job));
+}
+
+// Everything pushed so far, oldest first
+static FXLoadJob* stack_take(FXLoadJob** stack) {
+    FXLoadJob* job = fx_atomic_exchange(stack, (FXLoadJob*)NULL);
+    FXLoadJob* ordered = NULL;
+    while (job) {
+        FXLoadJob* next = job->next;
+        job->next = ordered;
+        ordered = job;
+        job = next;
+    }
+    return ordered;
+}
+
+static void append_waiting(FXLoadJob* jobs) {
+    FXLoadJob** tail = &g_compile.waiting;
+    while (*tail) tail = &(*tail)->next;
+    *tail = jobs;
+}
+
+static void compile_main(void* arg) {
+    (void)arg;
+    int ok = fxgl_shared_context_make_current(g_compile.context);
+    if (ok) fxgl_make_current(g_compile.dispatch);
+    fx_mutex_lock(&g_compile.wake_lock);
+    g_compile.started = ok ? 1 : -1;
+    fx_cond_broadcast(&g_compile.wake_cond);
+    fx_mutex_unlock(&g_compile.wake_lock);
+    if (!ok) return;
+
+    for (;;) {
+        fx_mutex_lock(&g_compile.wake_lock);
+        while (!fx_atomic_load(&g_compile.submitted) && !g_compile.stopping) {
+            fx_cond_wait(&g_compile.wake_cond, &g_compile.wake_lock);
+        }
+        int stopping = g_compile.stopping;
+        fx_mutex_unlock(&g_compile.wake_lock);
+        if (stopping) break;
+
+        FXLoadJob* job = stack_take(&g_compile.submitted);
+        while (job) {
+            FXLoadJob* next = job->next;
+            job->program = fx_load_job_build(job);
+            // The GL thread may use the program once this context's commands
+            // have completed; the flush makes sure the fence gets there
+            if (job->program) {
+                job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                glFlush();
+            }
+            stack_push(&g_compile.built, job);
+            fx_atomic_add(&fx_compile_pending, 1);
+            job = next;
+        }
+    }
+
+    fxgl_make_current(NULL);
+    fxgl_shared_context_make_current(NULL);
+}
+
+int fx_compile_thread_start(void) {
+    if (fx_compile_running) return 1;
+
+    // Resolved here so the compile thread's copy never goes near the loader
+    if (!fxgl_resolve_all()) return 0;
+    g_compile.context = fxgl_shared_context_create();
+    if (!g_compile.context) return 0;
+    g_compile.dispatch = fxgl_dispatch_create(fxgl_dispatch);
+    if (!g_compile.dispatch) {
+        fxgl_shared_context_destroy(g_compile.context);
+        return 0;
+    }
+
+    fx_mutex_init(&g_compile.wake_lock);
+    fx_cond_init(&g_compile.wake_cond);
+    g_compile.stopping = 0;
+    g_compile.started = 0;
+    int started = fx_thread_start(&g_compile.thread, compile_main, NULL);
+    if (started) {
+        fx_mutex_lock(&g_compile.wake_lock);
+        while (!g_compile.started) fx_cond_wait(&g_compile.wake_cond, &g_compile.wake_lock);
+        fx_mutex_unlock(&g_compile.wake_lock);
+        if (g_compile.started < 0) {
+            fprintf(stderr, "Compile thread could not make its context current\n");
+            fx_thread_join(g_compile.thread);
+            started = 0;
+        }
+    } else {
+        fprintf(stderr, "Could not start the shader compile thread\n");
+    }
+    if (!started) {
+        fx_mutex_destroy(&g_compile.wake_lock);
+        fx_cond_destroy(&g_compile.wake_cond);
+        fxgl_dispatch_destroy(g_compile.dispatch);
+        fxgl_shared_context_destroy(g_compile.context);
+        return 0;
+    }
+
+    fx_compile_running = 1;
+    return 1;
+}
+
+void fx_compile_thread_stop(void) {
+    if (!fx_compile_running) return;
+    fx_compile_running = 0;
+
+    fx_mutex_lock(&g_compile.wake_lock);
+    g_compile.stopping = 1;
+    fx_cond_signal(&g_compile.wake_cond);
+    fx_mutex_unlock(&g_compile.wake_lock);
+    fx_thread_join(g_compile.thread);
+
+    // Jobs the thread never got to are built here, so every load still
+    // completes through fx_poll() with its callback
+    append_waiting(stack_take(&g_compile.built));
+    FXLoadJob* job = stack_take(&g_compile.submitted);
+    while (job) {
+        FXLoadJob* next = job->next;
+        job->next = NULL;
+        job->program = fx_load_job_build(job);
+        append_waiting(job);
+        fx_atomic_add(&fx_compile_pending, 1);
+        job = next;
+    }
+
+    // Fences and programs belong to the share group and outlive the context
+    fx_mutex_destroy(&g_compile.wake_lock);
+    fx_cond_destroy(&g_compile.wake_cond);
+    fxgl_dispatch_destroy(g_compile.dispatch);
+    fxgl_shared_context_destroy(g_compile.context);
+}
+
+void fx_compile_submit(FXLoadJob* job) {
+    stack_push(&g_compile.submitted, job);
+    fx_mutex_lock(&g_compile.wake_lock);
+    fx_cond_signal(&g_compile.wake_cond);
+    fx_mutex_unlock(&g_compile.wake_lock);
+}
+
+int fx_compile_apply(void) {
+    append_waiting(stack_take(&g_compile.built));
+
+    int completed = 0;
+    FXLoadJob** link = &g_compile.waiting;
+    while (*link) {
+        FXLoadJob* job = *link;
+        if (job->fence) {
+            // Never blocks: a program still in flight is looked at next poll
+            if (glClientWaitSync(job->fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+                link = &job->next;
+                continue;
+            }
+            glDeleteSync(job->fence);
+            job->fence = NULL;
+        }
+        *link = job->next;
+
+        // The shader may have become resident since the job was queued
+        FXShader* shader = fx_registry_acquire(job->name);
+        if (shader) {
+            if (job->program) glDeleteProgram(job->program);
+        } else if (job->program) {
+            shader = fx_load_job_adopt(job, job->program);
+        }
+        if (job->callback) job->callback(shader, job->user);
+        fx_load_job_free(job);
+        fx_atomic_sub(&fx_compile_pending, 1);
+        completed++;
+    }
+    return completed;
+}
@@ -0,0 +1,135 @@
+/*
+ * FX Shader Runtime - Driver Performance Warnings
+ * KHR_debug performance messages, attributed to the bound shader and counted in the stats
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+
+#define FX_PERF_WARNING_NAME 64
+#define FX_PERF_WARNING_TEXT 256
+
+typedef struct FXPerfWarningEntry {
+    GLuint id;
+    unsigned int shader_hash;   // 0 when no shader was bound
+    char shader[FX_PERF_WARNING_NAME];
+    char message[FX_PERF_WARNING_TEXT];
+    uint64_t count;
+} FXPerfWarningEntry;
+
+int fx_perf_warnings_enabled = 0;
+FXShader* fx_perf_warnings_shader = NULL;
+
+// GL thread only: synchronous output calls back on the thread making the
+// call that caused the message
+static struct {
+    FXPerfWarningEntry* entries;
+    int count;
+    int capacity;
+} g_warnings;
+
+// The app's debug output as enabling found it, put back on disable. Filters
+// can't be read back: with output already on they are left alone but for the
+// performance type; with it off they are narrowed and reset to the defaults.
+static struct {
+    GLboolean output;
+    GLboolean synchronous;
+    FXGLDebugProc callback;     // Still called while enabled, if output was on
+    const void* user;
+} g_saved;
+
+static FXPerfWarningEntry* find_entry(GLuint id, unsigned int shader_hash) {
+    for (int i = 0; i < g_warnings.count; i++) {
+        FXPerfWarningEntry* entry = &g_warnings.entries[i];
+        if (entry->id == id && entry->shader_hash == shader_hash) return entry;
+    }
+    if (g_warnings.count == g_warnings.capacity) {
+        int capacity = g_warnings.capacity ? g_warnings.capacity * 2 : 16;
+        FXPerfWarningEntry* entries =
+            (FXPerfWarningEntry*)realloc(g_warnings.entries, capacity * sizeof(FXPerfWarningEntry));
+        if (!entries) return NULL;
+        g_warnings.entries = entries;
+        g_warnings.capacity = capacity;
+    }
+    FXPerfWarningEntry* entry = &g_warnings.entries[g_warnings.count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->id = id;
+    entry->shader_hash = shader_hash;
+    return entry;
+}
+
+static void APIENTRY on_debug_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                      const GLchar* message, const void* user) {
+    (void)user;
+    if (g_saved.callback) g_saved.callback(source, type, id, severity, length, message, g_saved.user);
+    // With the app's filters kept, other messages come through too
+    if (type != GL_DEBUG_TYPE_PERFORMANCE) return;
+    FX_STAT_ADD(perf_warnings, 1);
+
+    const FXShader* shader = fx_perf_warnings_shader;
+    unsigned int hash = shader ? (shader->name_hash ? shader->name_hash : fx_hash_name(shader->name)) : 0;
+    FXPerfWarningEntry* entry = find_entry(id, hash);
+    if (!entry) return;
+    if (entry->count++ == 0) {
+        snprintf(entry->shader, sizeof(entry->shader), "%s", shader ? shader->name : "");
+        int n = length >= 0 ? (int)length : (int)strlen(message);
+        snprintf(entry->message, sizeof(entry->message), "%.*s", n, message);
+    }
+}
+
+int fx_perf_warnings_enable(int enable) {
+    enable = enable ? 1 : 0;
+    if (enable == fx_perf_warnings_enabled) return 1;
+
+    if (enable) {
+        if (!fxgl_caps()->debug) return 0;
+        memset(&g_saved, 0, sizeof(g_saved));
+        g_saved.output = glIsEnabled(GL_DEBUG_OUTPUT);
+        g_saved.synchronous = glIsEnabled(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        if (g_saved.output) {
+            void* callback = NULL;
+            void* user = NULL;
+            glGetPointerv(GL_DEBUG_CALLBACK_FUNCTION, &callback);
+            glGetPointerv(GL_DEBUG_CALLBACK_USER_PARAM, &user);
+            g_saved.callback = (FXGLDebugProc)callback;
+            g_saved.user = user;
+        } else {
+            // Filtered in the driver, so other messages aren't even formatted
+            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_FALSE);
+        }
+        glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PERFORMANCE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+        glEnable(GL_DEBUG_OUTPUT);
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(on_debug_message, NULL);
+        fx_perf_warnings_shader = NULL;
+    } else {
+        glDebugMessageCallback(g_saved.callback, g_saved.user);
+        if (!g_saved.output) {
+            // The KHR_debug default: everything but low severity
+            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_LOW, 0, NULL, GL_FALSE);
+        }
+        if (!g_saved.synchronous) glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        if (!g_saved.output) glDisable(GL_DEBUG_OUTPUT);
+        memset(&g_saved, 0, sizeof(g_saved));
+        free(g_warnings.entries);
+        memset(&g_warnings, 0, sizeof(g_warnings));
+        fx_perf_warnings_shader = NULL;
+    }
+    fx_perf_warnings_enabled = enable;
+    return 1;
+}
+
+int fx_perf_warnings(FXPerfWarning* warnings, int max_warnings) {
+    for (int i = 0; i < g_warnings.count && i < max_warnings; i++) {
+        const FXPerfWarningEntry* entry = &g_warnings.entries[i];
+        warnings[i].id = entry->id;
+        warnings[i].shader = entry->shader;
+        warnings[i].message = entry->message;
+        warnings[i].count = entry->count;
+    }
+    return g_warnings.count;
+}
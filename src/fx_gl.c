@@ -1,6 +1,6 @@
 /*
  * Handmade OpenGL Function Loader Implementation
- * Pure C implementation for Windows - no external dependencies
+ * Pure C, table driven - WGL on Windows, EGL or GLX on Linux, no external dependencies
  * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
  *
  * Copyright (c) 2024 Giovanni Carlino
@@ -8,31 +8,571 @@
  */
 
 #include "fx_gl.h"
+#include "fx_platform.h"
+#include <stdlib.h>
+#include <string.h>
 
-// Define the function pointers
-PFNGLGENVERTEXARRAYS glGenVertexArrays = NULL;
-PFNGLBINDVERTEXARRAY glBindVertexArray = NULL;
-PFNGLGENBUFFERS glGenBuffers = NULL;
-PFNGLBINDBUFFER glBindBuffer = NULL;
-PFNGLBUFFERDATA glBufferData = NULL;
-PFNGLVERTEXATTRIBPOINTER glVertexAttribPointer = NULL;
-PFNGLENABLEVERTEXATTRIBARRAY glEnableVertexAttribArray = NULL;
-PFNGLUSEPROGRAM glUseProgram = NULL;
-PFNGLCREATESHADER glCreateShader = NULL;
-PFNGLSHADERSOURCE glShaderSource = NULL;
-PFNGLCOMPILESHADER glCompileShader = NULL;
-PFNGLGETSHADERIV glGetShaderiv = NULL;
-PFNGLGETSHADERINFOLOG glGetShaderInfoLog = NULL;
-PFNGLDELETESHADER glDeleteShader = NULL;
-PFNGLCREATEPROGRAM glCreateProgram = NULL;
-PFNGLATTACHSHADER glAttachShader = NULL;
-PFNGLLINKPROGRAM glLinkProgram = NULL;
-PFNGLGETPROGRAMIV glGetProgramiv = NULL;
-PFNGLGETPROGRAMINFOLOG glGetProgramInfoLog = NULL;
-PFNGLDELETEPROGRAM glDeleteProgram = NULL;
-PFNGLGETUNIFORMLOCATION glGetUniformLocation = NULL;
-PFNGLUNIFORM1F glUniform1f = NULL;
-PFNGLUNIFORM3F glUniform3f = NULL;
-PFNGLUNIFORM4F glUniform4f = NULL;
-PFNGLUNIFORMMATRIX4FV glUniformMatrix4fv = NULL;
-PFNGLGETATTRIBLOCATION glGetAttribLocation = NULL;
\ No newline at end of file
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+enum {
+#define FXGL_INDEX(ret, name, params, args) FXGL_INDEX_##name,
+    FXGL_CORE_ENTRY_POINTS(FXGL_INDEX)
+#undef FXGL_INDEX
+    FXGL_CORE_COUNT
+};
+
+static void* resolve_core(int index);
+
+// The first call through a core slot lands in its trampoline, which patches
+// the slot of the calling thread's table with the driver's function and
+// forwards the call; later calls go straight to the driver. Threads sharing a
+// table may both patch a slot, with the same value. A function the driver
+// lacks does nothing and returns 0.
+#define FXGL_TRAMPOLINE(ret, name, params, args) \
+    static ret APIENTRY fxgl_lazy_##name params { \
+        FXGLProc_##name proc = (FXGLProc_##name)resolve_core(FXGL_INDEX_##name); \
+        FXGL_VOID_##ret(if (proc) proc args;, return proc ? proc args : (ret)0;) \
+    }
+FXGL_CORE_ENTRY_POINTS(FXGL_TRAMPOLINE)
+#undef FXGL_TRAMPOLINE
+
+// A table nothing has been resolved into yet: core entry points on their
+// trampolines, optional ones NULL
+#define FXGL_UNRESOLVED_CORE(ret, name, params, args) fxgl_lazy_##name,
+#define FXGL_UNRESOLVED_OPTIONAL(ret, name, params, args) NULL,
+#define FXGL_UNRESOLVED { \
+    FXGL_CORE_ENTRY_POINTS(FXGL_UNRESOLVED_CORE) \
+    FXGL_OPTIONAL_ENTRY_POINTS(FXGL_UNRESOLVED_OPTIONAL) \
+    { 0 } \
+}
+
+static const FXGLDispatch g_unresolved_dispatch = FXGL_UNRESOLVED;
+static FXGLDispatch g_default_dispatch = FXGL_UNRESOLVED;
+FXGL_THREAD_LOCAL FXGLDispatch* fxgl_dispatch = &g_default_dispatch;
+
+// The whole loader: one name and one table slot per entry point
+typedef struct FXGLEntry {
+    const char* name;
+    size_t offset;              // Of the slot in FXGLDispatch
+} FXGLEntry;
+
+#define FXGL_ENTRY(ret, name, params, args) { #name, offsetof(FXGLDispatch, proc_##name) },
+static const FXGLEntry g_core_entries[FXGL_CORE_COUNT] = { FXGL_CORE_ENTRY_POINTS(FXGL_ENTRY) };
+static const FXGLEntry g_optional_entries[] = { FXGL_OPTIONAL_ENTRY_POINTS(FXGL_ENTRY) };
+#undef FXGL_ENTRY
+
+static void** table_slot(FXGLDispatch* dispatch, const FXGLEntry* entry) {
+    return (void**)((char*)dispatch + entry->offset);
+}
+
+static int is_unresolved(const FXGLDispatch* dispatch, const FXGLEntry* entry) {
+    const char* unresolved = (const char*)&g_unresolved_dispatch + entry->offset;
+    return *(void* const*)((const char*)dispatch + entry->offset) == *(void* const*)unresolved;
+}
+
+#define FXGL_COUNT(array) (int)(sizeof(array) / sizeof((array)[0]))
+
+typedef void* (APIENTRY *FXGLGetProcAddress)(const char* name);
+
+// The library is opened once and kept; every lookup after that is one call
+static struct {
+    int opened;
+#ifdef _WIN32
+    HMODULE library;            // opengl32.dll, for the 1.1 entry points wgl won't return
+#else
+    void* library;              // libEGL or libGL
+#endif
+    FXGLGetProcAddress get_proc_address;
+    FXGLLoaderInfo info;
+    unsigned char reported[FXGL_CORE_COUNT];    // Missing core entry points, named once
+} g_loader = { 0, NULL, NULL, { "none", 0, 0, 0, 0 }, { 0 } };
+
+static int open_backend(void);
+
+static int open_library(void) {
+    if (!g_loader.opened) g_loader.opened = open_backend();
+    return g_loader.opened;
+}
+
+#ifdef _WIN32
+
+static int open_backend(void) {
+    g_loader.library = GetModuleHandleA("opengl32.dll");
+    if (!g_loader.library) g_loader.library = LoadLibraryA("opengl32.dll");
+    if (!g_loader.library) {
+        fprintf(stderr, "Failed to load opengl32.dll\n");
+        return 0;
+    }
+    g_loader.info.backend = "wgl";
+    return 1;
+}
+
+void* fxgl_get_proc(const char* name) {
+    if (!open_library()) return NULL;
+    void* p = (void*)wglGetProcAddress(name);
+    // Some drivers return small integers instead of NULL for a miss
+    if (p == NULL || p == (void*)1 || p == (void*)2 || p == (void*)3 || p == (void*)-1) {
+        p = (void*)GetProcAddress(g_loader.library, name);
+    }
+    return p;
+}
+
+#else
+
+typedef void* (*FXGetCurrentContext)(void);
+
+// Picks the library whose context is current: EGL for headless and Wayland,
+// GLX for X11. With nothing current yet, EGL is preferred.
+static int open_backend(void) {
+    static const char* const egl_names[] = { "libEGL.so.1", "libEGL.so" };
+    static const char* const glx_names[] = { "libGL.so.1", "libGL.so" };
+
+    void* egl = NULL;
+    for (int i = 0; i < 2 && !egl; i++) egl = dlopen(egl_names[i], RTLD_LAZY | RTLD_LOCAL);
+    if (egl) {
+        FXGetCurrentContext current = (FXGetCurrentContext)dlsym(egl, "eglGetCurrentContext");
+        if (current && current()) {
+            g_loader.library = egl;
+            g_loader.info.backend = "egl";
+            g_loader.get_proc_address = (FXGLGetProcAddress)dlsym(egl, "eglGetProcAddress");
+            return g_loader.get_proc_address != NULL;
+        }
+    }
+
+    void* glx = NULL;
+    for (int i = 0; i < 2 && !glx; i++) glx = dlopen(glx_names[i], RTLD_LAZY | RTLD_LOCAL);
+    if (glx) {
+        FXGetCurrentContext current = (FXGetCurrentContext)dlsym(glx, "glXGetCurrentContext");
+        if ((current && current()) || !egl) {
+            if (egl) dlclose(egl);
+            g_loader.library = glx;
+            g_loader.info.backend = "glx";
+            g_loader.get_proc_address = (FXGLGetProcAddress)dlsym(glx, "glXGetProcAddressARB");
+            return g_loader.get_proc_address != NULL;
+        }
+        dlclose(glx);
+    }
+
+    if (!egl) {
+        fprintf(stderr, "Failed to load libEGL or libGL\n");
+        return 0;
+    }
+    g_loader.library = egl;
+    g_loader.info.backend = "egl";
+    g_loader.get_proc_address = (FXGLGetProcAddress)dlsym(egl, "eglGetProcAddress");
+    return g_loader.get_proc_address != NULL;
+}
+
+void* fxgl_get_proc(const char* name) {
+    if (!open_library()) return NULL;
+    void* p = g_loader.get_proc_address(name);
+    if (!p) p = dlsym(g_loader.library, name);
+    return p;
+}
+
+#endif
+
+static void* resolve_core(int index) {
+    const FXGLEntry* entry = &g_core_entries[index];
+    uint64_t start = fx_time_ns();
+    void* p = open_library() ? fxgl_get_proc(entry->name) : NULL;
+    if (p) {
+        *table_slot(fxgl_dispatch, entry) = p;
+        g_loader.info.resolved++;
+    } else if (!g_loader.reported[index]) {
+        fprintf(stderr, "OpenGL entry point %s not found\n", entry->name);
+        g_loader.reported[index] = 1;
+        g_loader.info.missing++;
+    }
+    g_loader.info.lazy_ns += fx_time_ns() - start;
+    return p;
+}
+
+typedef const GLubyte* (APIENTRYP FXGLProc_glGetString)(GLenum name);
+
+static uint32_t hash_extension(const char* name) {
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+// Linear probing, stopped at three quarters full so a miss always ends on an
+// empty slot
+static int find_extension(const FXGLCaps* caps, uint32_t hash) {
+    uint32_t mask = FXGL_EXTENSION_SLOTS - 1;
+    for (uint32_t i = hash & mask; caps->extensions[i]; i = (i + 1) & mask) {
+        if (caps->extensions[i] == hash) return 1;
+    }
+    return 0;
+}
+
+static void add_extension(FXGLCaps* caps, const char* name) {
+    uint32_t hash = hash_extension(name);
+    uint32_t mask = FXGL_EXTENSION_SLOTS - 1;
+    uint32_t i = hash & mask;
+    while (caps->extensions[i] && caps->extensions[i] != hash) i = (i + 1) & mask;
+    if (!caps->extensions[i]) {
+        caps->extensions[i] = hash;
+        caps->extension_count++;
+    }
+}
+
+static int has_extension_named(const FXGLCaps* caps, const char* name) {
+    return find_extension(caps, hash_extension(name));
+}
+
+// Asked through the driver directly, not a table, so nothing gets patched.
+// With no context current every answer is no.
+static void probe_caps(FXGLCaps* caps) {
+    memset(caps, 0, sizeof(*caps));
+    FXGLProc_glGetString get_string = (FXGLProc_glGetString)fxgl_get_proc("glGetString");
+    FXGLProc_glGetStringi get_stringi = (FXGLProc_glGetStringi)fxgl_get_proc("glGetStringi");
+    FXGLProc_glGetIntegerv get_integer = (FXGLProc_glGetIntegerv)fxgl_get_proc("glGetIntegerv");
+
+    // "4.6.0 NVIDIA 550.54", "OpenGL ES 3.2 Mesa 24.0": the first number pair
+    const char* version = get_string ? (const char*)get_string(GL_VERSION) : NULL;
+    if (version) {
+        while (*version && (*version < '0' || *version > '9')) version++;
+        if (sscanf(version, "%d.%d", &caps->major, &caps->minor) != 2) caps->major = caps->minor = 0;
+    }
+
+    GLint count = 0;
+    if (get_integer && get_stringi) get_integer(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count && caps->extension_count < FXGL_EXTENSION_SLOTS * 3 / 4; i++) {
+        const char* name = (const char*)get_stringi(GL_EXTENSIONS, (GLuint)i);
+        if (name) add_extension(caps, name);
+    }
+
+#define FXGL_HAS(core_major, core_minor, extension) \
+    (caps->major > (core_major) || (caps->major == (core_major) && caps->minor >= (core_minor)) || \
+     has_extension_named(caps, extension))
+    caps->dsa = FXGL_HAS(4, 5, "GL_ARB_direct_state_access");
+    caps->separate_programs = FXGL_HAS(4, 1, "GL_ARB_separate_shader_objects");
+    caps->program_binary = FXGL_HAS(4, 1, "GL_ARB_get_program_binary");
+    caps->timer_query = FXGL_HAS(3, 3, "GL_ARB_timer_query");
+    caps->parallel_compile = has_extension_named(caps, "GL_KHR_parallel_shader_compile") ||
+                             has_extension_named(caps, "GL_ARB_parallel_shader_compile");
+    caps->persistent_mapping = FXGL_HAS(4, 4, "GL_ARB_buffer_storage");
+    caps->multi_draw_indirect = FXGL_HAS(4, 3, "GL_ARB_multi_draw_indirect");
+    caps->shader_draw_parameters = FXGL_HAS(4, 6, "GL_ARB_shader_draw_parameters");
+    caps->compute = FXGL_HAS(4, 3, "GL_ARB_compute_shader");
+    // The extension itself, whatever the version: #version 330 code declares
+    // uniform locations only where the compiler defines its macro
+    caps->explicit_uniform_location = has_extension_named(caps, "GL_ARB_explicit_uniform_location");
+    caps->debug = FXGL_HAS(4, 3, "GL_KHR_debug");
+#undef FXGL_HAS
+}
+
+// Core slots go back to their trampolines, so a new driver or context is
+// resolved against on first use rather than here
+static void reset_table(FXGLDispatch* dispatch) {
+    *dispatch = g_unresolved_dispatch;
+    for (int i = 0; i < FXGL_COUNT(g_optional_entries); i++) {
+        *table_slot(dispatch, &g_optional_entries[i]) = fxgl_get_proc(g_optional_entries[i].name);
+    }
+    FXGLCaps* caps = &dispatch->caps;
+    probe_caps(caps);
+
+    // A feature counts only with every entry point it needs, and its entry
+    // points only with the feature
+#define FXGL_LOADED(ret, name, params, args) && dispatch->proc_##name
+#define FXGL_CLEAR(ret, name, params, args) dispatch->proc_##name = NULL;
+    caps->separate_programs = caps->separate_programs FXGL_PROGRAM_UNIFORM_ENTRY_POINTS(FXGL_LOADED);
+    if (!caps->separate_programs) {
+        FXGL_PROGRAM_UNIFORM_ENTRY_POINTS(FXGL_CLEAR)
+    }
+#undef FXGL_CLEAR
+#undef FXGL_LOADED
+    caps->multi_draw_indirect = caps->multi_draw_indirect && dispatch->proc_glMultiDrawArraysIndirect &&
+                                dispatch->proc_glMultiDrawElementsIndirect;
+    if (!caps->multi_draw_indirect) {
+        dispatch->proc_glMultiDrawArraysIndirect = NULL;
+        dispatch->proc_glMultiDrawElementsIndirect = NULL;
+    }
+    caps->debug = caps->debug && dispatch->proc_glDebugMessageCallback && dispatch->proc_glDebugMessageControl &&
+                  dispatch->proc_glGetPointerv;
+    if (!caps->debug) {
+        dispatch->proc_glDebugMessageCallback = NULL;
+        dispatch->proc_glDebugMessageControl = NULL;
+        dispatch->proc_glGetPointerv = NULL;
+    }
+
+    for (int i = 0; i < FXGL_COUNT(g_optional_entries); i++) {
+        if (*table_slot(dispatch, &g_optional_entries[i])) g_loader.info.resolved++;
+        else g_loader.info.missing++;
+    }
+}
+
+int fxgl_init(void) {
+    uint64_t start = fx_time_ns();
+    if (!open_library()) return 0;
+
+    memset(g_loader.reported, 0, sizeof(g_loader.reported));
+    g_loader.info.resolved = 0;
+    g_loader.info.missing = 0;
+    g_loader.info.lazy_ns = 0;
+    reset_table(fxgl_dispatch);
+    g_loader.info.init_ns = fx_time_ns() - start;
+    return 1;
+}
+
+int fxgl_resolve_all(void) {
+    int ok = 1;
+    for (int i = 0; i < FXGL_CORE_COUNT; i++) {
+        if (is_unresolved(fxgl_dispatch, &g_core_entries[i]) && !resolve_core(i)) ok = 0;
+    }
+    return ok;
+}
+
+FXGLDispatch* fxgl_dispatch_create(const FXGLDispatch* share) {
+    FXGLDispatch* dispatch = (FXGLDispatch*)malloc(sizeof(FXGLDispatch));
+    if (!dispatch) return NULL;
+    if (share) *dispatch = *share;
+    else if (open_library()) reset_table(dispatch);
+    else *dispatch = g_unresolved_dispatch;
+    return dispatch;
+}
+
+void fxgl_dispatch_destroy(FXGLDispatch* dispatch) {
+    if (!dispatch || dispatch == &g_default_dispatch) return;
+    if (fxgl_dispatch == dispatch) fxgl_dispatch = &g_default_dispatch;
+    free(dispatch);
+}
+
+void fxgl_make_current(FXGLDispatch* dispatch) {
+    fxgl_dispatch = dispatch ? dispatch : &g_default_dispatch;
+}
+
+void fxgl_loader_info(FXGLLoaderInfo* info) {
+    if (info) *info = g_loader.info;
+}
+
+const FXGLCaps* fxgl_caps(void) {
+    return &fxgl_dispatch->caps;
+}
+
+int fxgl_has_extension(const char* name) {
+    return name && has_extension_named(&fxgl_dispatch->caps, name);
+}
+
+#ifdef _WIN32
+
+int fxgl_create_headless_context(int major, int minor) {
+    (void)major;
+    (void)minor;
+    fprintf(stderr, "Headless contexts need EGL, which this platform lacks\n");
+    return 0;
+}
+
+FXGLSharedContext* fxgl_shared_context_create(void) {
+    fprintf(stderr, "Shared worker contexts need EGL, which this platform lacks\n");
+    return NULL;
+}
+
+int fxgl_shared_context_make_current(FXGLSharedContext* context) {
+    (void)context;
+    return 0;
+}
+
+void fxgl_shared_context_destroy(FXGLSharedContext* context) {
+    (void)context;
+}
+
+#else
+
+// The slice of EGL the context helpers need, declared here so building
+// doesn't need the EGL headers
+typedef void* FXEGLDisplay;
+typedef void* FXEGLConfig;
+typedef void* FXEGLContext;
+typedef int32_t FXEGLint;
+
+#define FXEGL_NONE                                0x3038
+#define FXEGL_CONFIG_ID                           0x3028
+#define FXEGL_RENDERABLE_TYPE                     0x3040
+#define FXEGL_OPENGL_BIT                          0x0008
+#define FXEGL_OPENGL_API                          0x30A2
+#define FXEGL_EXTENSIONS                          0x3055
+#define FXEGL_CONTEXT_MAJOR_VERSION               0x3098
+#define FXEGL_CONTEXT_MINOR_VERSION               0x30FB
+#define FXEGL_CONTEXT_OPENGL_PROFILE_MASK         0x30FD
+#define FXEGL_CONTEXT_OPENGL_CORE_PROFILE_BIT     0x0001
+#define FXEGL_PLATFORM_SURFACELESS_MESA           0x31DD
+
+#define FXEGL_FUNCTIONS(X) \
+    X(FXEGLDisplay, eglGetPlatformDisplay, (unsigned int platform, void* native, const intptr_t* attribs)) \
+    X(FXEGLDisplay, eglGetDisplay, (void* native)) \
+    X(unsigned int, eglInitialize, (FXEGLDisplay display, FXEGLint* major, FXEGLint* minor)) \
+    X(const char*, eglQueryString, (FXEGLDisplay display, FXEGLint name)) \
+    X(unsigned int, eglBindAPI, (unsigned int api)) \
+    X(unsigned int, eglChooseConfig, (FXEGLDisplay display, const FXEGLint* attribs, FXEGLConfig* configs, \
+      FXEGLint size, FXEGLint* count)) \
+    X(FXEGLContext, eglCreateContext, (FXEGLDisplay display, FXEGLConfig config, FXEGLContext share, \
+      const FXEGLint* attribs)) \
+    X(unsigned int, eglDestroyContext, (FXEGLDisplay display, FXEGLContext context)) \
+    X(unsigned int, eglMakeCurrent, (FXEGLDisplay display, void* draw, void* read, FXEGLContext context)) \
+    X(FXEGLDisplay, eglGetCurrentDisplay, (void)) \
+    X(FXEGLContext, eglGetCurrentContext, (void)) \
+    X(unsigned int, eglQueryContext, (FXEGLDisplay display, FXEGLContext context, FXEGLint attribute, \
+      FXEGLint* value))
+
+// Loaded once, on first use; eglGetPlatformDisplay (EGL 1.5) may be NULL
+static struct {
+    int loaded;
+#define FXEGL_MEMBER(ret, name, params) ret (*name) params;
+    FXEGL_FUNCTIONS(FXEGL_MEMBER)
+#undef FXEGL_MEMBER
+} g_egl;
+
+static int load_egl(void) {
+    if (g_egl.loaded) return g_egl.loaded > 0;
+    g_egl.loaded = -1;
+    void* library = dlopen("libEGL.so.1", RTLD_LAZY | RTLD_LOCAL);
+    if (!library) {
+        fprintf(stderr, "Failed to load libEGL.so.1\n");
+        return 0;
+    }
+#define FXEGL_LOAD(ret, name, params) *(void**)&g_egl.name = dlsym(library, #name);
+    FXEGL_FUNCTIONS(FXEGL_LOAD)
+#undef FXEGL_LOAD
+    if (!g_egl.eglGetDisplay || !g_egl.eglInitialize || !g_egl.eglQueryString || !g_egl.eglBindAPI ||
+        !g_egl.eglChooseConfig || !g_egl.eglCreateContext || !g_egl.eglDestroyContext ||
+        !g_egl.eglMakeCurrent || !g_egl.eglGetCurrentDisplay || !g_egl.eglGetCurrentContext ||
+        !g_egl.eglQueryContext) {
+        fprintf(stderr, "libEGL is missing EGL 1.4 entry points\n");
+        dlclose(library);
+        return 0;
+    }
+    // Contexts keep libEGL in use, so the handle stays open
+    g_egl.loaded = 1;
+    return 1;
+}
+
+static int has_extension(const char* extensions, const char* name) {
+    size_t length = strlen(name);
+    for (const char* p = extensions; p && (p = strstr(p, name)) != NULL; p += length) {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) return 1;
+    }
+    return 0;
+}
+
+static FXEGLContext create_context(FXEGLDisplay display, FXEGLConfig config, FXEGLContext share,
+                                   int major, int minor) {
+    FXEGLint attribs[] = {
+        FXEGL_CONTEXT_MAJOR_VERSION, major,
+        FXEGL_CONTEXT_MINOR_VERSION, minor,
+        FXEGL_CONTEXT_OPENGL_PROFILE_MASK, FXEGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        FXEGL_NONE
+    };
+    if (!g_egl.eglBindAPI(FXEGL_OPENGL_API)) return NULL;
+    return g_egl.eglCreateContext(display, config, share, attribs);
+}
+
+int fxgl_create_headless_context(int major, int minor) {
+    if (!load_egl()) return 0;
+
+    // Mesa's surfaceless platform needs no GPU node or display server; the
+    // default display works on drivers with EGL_KHR_surfaceless_context
+    FXEGLDisplay display = NULL;
+    const char* client_extensions = g_egl.eglQueryString(NULL, FXEGL_EXTENSIONS);
+    if (g_egl.eglGetPlatformDisplay && has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+        display = g_egl.eglGetPlatformDisplay(FXEGL_PLATFORM_SURFACELESS_MESA, NULL, NULL);
+    }
+    if (!display) display = g_egl.eglGetDisplay(NULL);
+    if (!display || !g_egl.eglInitialize(display, NULL, NULL)) {
+        fprintf(stderr, "Failed to initialize an EGL display\n");
+        return 0;
+    }
+    const char* extensions = g_egl.eglQueryString(display, FXEGL_EXTENSIONS);
+    if (!has_extension(extensions, "EGL_KHR_surfaceless_context")) {
+        fprintf(stderr, "EGL display does not support surfaceless contexts\n");
+        return 0;
+    }
+
+    // Surfaceless displays may offer no configs at all; nothing is drawn to
+    // a surface, so EGL_KHR_no_config_context lets the context go without
+    FXEGLint config_attribs[] = { FXEGL_RENDERABLE_TYPE, FXEGL_OPENGL_BIT, FXEGL_NONE };
+    FXEGLConfig config = NULL;
+    FXEGLint config_count = 0;
+    if (!g_egl.eglChooseConfig(display, config_attribs, &config, 1, &config_count) || config_count < 1) {
+        config = NULL;
+    }
+    FXEGLContext context = NULL;
+    if (config || has_extension(extensions, "EGL_KHR_no_config_context")) {
+        context = create_context(display, config, NULL, major, minor);
+    }
+    if (!context || !g_egl.eglMakeCurrent(display, NULL, NULL, context)) {
+        fprintf(stderr, "Failed to create a surfaceless GL %d.%d core context\n", major, minor);
+        return 0;
+    }
+    return 1;
+}
+
+struct FXGLSharedContext {
+    FXEGLDisplay display;
+    FXEGLContext context;
+};
+
+FXGLSharedContext* fxgl_shared_context_create(void) {
+    if (!load_egl()) return NULL;
+    FXEGLDisplay display = g_egl.eglGetCurrentDisplay();
+    FXEGLContext current = g_egl.eglGetCurrentContext();
+    if (!display || !current) {
+        fprintf(stderr, "Shared contexts need a current EGL context to share with\n");
+        return NULL;
+    }
+    if (!has_extension(g_egl.eglQueryString(display, FXEGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+        fprintf(stderr, "EGL display does not support surfaceless contexts\n");
+        return NULL;
+    }
+
+    // Same config as the context it shares with (none for a configless one),
+    // same version; the core profile is all the runtime targets
+    FXEGLint config_id = 0;
+    FXEGLConfig config = NULL;
+    g_egl.eglQueryContext(display, current, FXEGL_CONFIG_ID, &config_id);
+    if (config_id) {
+        FXEGLint config_attribs[] = { FXEGL_CONFIG_ID, config_id, FXEGL_NONE };
+        FXEGLint config_count = 0;
+        if (!g_egl.eglChooseConfig(display, config_attribs, &config, 1, &config_count) || config_count < 1) {
+            config = NULL;
+        }
+    }
+    const FXGLCaps* caps = fxgl_caps();
+    int major = caps->major ? caps->major : 3, minor = caps->major ? caps->minor : 3;
+
+    FXEGLContext context = create_context(display, config, current, major, minor);
+    if (!context) {
+        fprintf(stderr, "Failed to create a GL %d.%d context sharing with the current one\n", major, minor);
+        return NULL;
+    }
+    FXGLSharedContext* shared = (FXGLSharedContext*)malloc(sizeof(FXGLSharedContext));
+    if (!shared) {
+        g_egl.eglDestroyContext(display, context);
+        return NULL;
+    }
+    shared->display = display;
+    shared->context = context;
+    return shared;
+}
+
+int fxgl_shared_context_make_current(FXGLSharedContext* context) {
+    if (!context) {
+        FXEGLDisplay display = g_egl.loaded > 0 ? g_egl.eglGetCurrentDisplay() : NULL;
+        return !display || g_egl.eglMakeCurrent(display, NULL, NULL, NULL);
+    }
+    return g_egl.eglMakeCurrent(context->display, NULL, NULL, context->context) != 0;
+}
+
+void fxgl_shared_context_destroy(FXGLSharedContext* context) {
+    if (!context) return;
+    g_egl.eglDestroyContext(context->display, context->context);
+    free(context);
+}
+
+#endif
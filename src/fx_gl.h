@@ -1,6 +1,6 @@
 /*
  * Handmade OpenGL Function Loader
- * Pure C implementation for Windows - no external dependencies
+ * Pure C, table driven - WGL on Windows, EGL or GLX on Linux, no external dependencies
  * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
  *
  * Copyright (c) 2024 Giovanni Carlino
@@ -10,9 +10,12 @@
 #ifndef FX_GL_H
 #define FX_GL_H
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <GL/gl.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 // OpenGL constants we need
@@ -28,12 +31,99 @@
 #ifndef GL_LINK_STATUS
 #define GL_LINK_STATUS 0x8B82
 #endif
+#ifndef GL_CURRENT_PROGRAM
+#define GL_CURRENT_PROGRAM 0x8B8D
+#endif
+#ifndef GL_EXTENSIONS
+#define GL_EXTENSIONS 0x1F03
+#endif
+#ifndef GL_NUM_EXTENSIONS
+#define GL_NUM_EXTENSIONS 0x821D
+#endif
 #ifndef GL_ARRAY_BUFFER
 #define GL_ARRAY_BUFFER 0x8892
 #endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#endif
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+#ifndef GL_INT_2_10_10_10_REV
+#define GL_INT_2_10_10_10_REV 0x8D9F
+#endif
+#ifndef GL_UNSIGNED_INT_2_10_10_10_REV
+#define GL_UNSIGNED_INT_2_10_10_10_REV 0x8368
+#endif
 #ifndef GL_STATIC_DRAW
 #define GL_STATIC_DRAW 0x88E4
 #endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0 0x84C0
+#endif
+#ifndef GL_TEXTURE_CUBE_MAP
+#define GL_TEXTURE_CUBE_MAP 0x8513
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED 0x911C
+#endif
+#ifndef GL_MAJOR_VERSION
+#define GL_MAJOR_VERSION 0x821B
+#endif
+#ifndef GL_MINOR_VERSION
+#define GL_MINOR_VERSION 0x821C
+#endif
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#endif
+#ifndef GL_DEBUG_OUTPUT_SYNCHRONOUS
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#endif
+#ifndef GL_DEBUG_CALLBACK_FUNCTION
+#define GL_DEBUG_CALLBACK_FUNCTION 0x8244
+#endif
+#ifndef GL_DEBUG_CALLBACK_USER_PARAM
+#define GL_DEBUG_CALLBACK_USER_PARAM 0x8245
+#endif
+#ifndef GL_DEBUG_TYPE_PERFORMANCE
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#endif
+#ifndef GL_DEBUG_SEVERITY_LOW
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#endif
+#ifndef GL_DONT_CARE
+#define GL_DONT_CARE 0x1100
+#endif
 #ifndef GL_TRIANGLES
 #define GL_TRIANGLES 0x0004
 #endif
@@ -44,78 +134,318 @@
 #define GL_FALSE 0
 #endif
 #ifndef APIENTRY
+#ifdef _WIN32
 #define APIENTRY __stdcall
+#else
+#define APIENTRY
+#endif
 #endif
 #ifndef APIENTRYP
 #define APIENTRYP APIENTRY *
 #endif
 // Type definitions
 typedef char GLchar;
+typedef const GLubyte* FXGLString;
+#ifndef GL_VERSION_3_2
+typedef struct __GLsync* GLsync;
+typedef uint64_t GLuint64;
+#endif
+typedef void (APIENTRY *FXGLDebugProc)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                       const GLchar* message, const void* user);
+
+// Every entry point the runtime loads: X(return type, name, parameters, arguments).
+// The dispatch table, the pointer types and the loader table are generated
+// from these lists; adding a function is one line here plus its name in the
+// macro layer below. Core entry points start out
+// pointing at a trampoline that resolves them on first call; optional ones are
+// resolved by fxgl_init(), so a NULL pointer means the driver lacks them.
+// Return types are single tokens, for FXGL_VOID_ below.
+#define FXGL_CORE_ENTRY_POINTS(X) \
+    X(void, glGenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays)) \
+    X(void, glBindVertexArray, (GLuint array), (array)) \
+    X(void, glDeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays)) \
+    X(void, glGenBuffers, (GLsizei n, GLuint* buffers), (n, buffers)) \
+    X(void, glDeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers)) \
+    X(void, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer)) \
+    X(void, glBufferData, (GLenum target, ptrdiff_t size, const void* data, GLenum usage), \
+      (target, size, data, usage)) \
+    X(void, glBufferSubData, (GLenum target, ptrdiff_t offset, ptrdiff_t size, const void* data), \
+      (target, offset, size, data)) \
+    X(void, glBindBufferRange, (GLenum target, GLuint index, GLuint buffer, ptrdiff_t offset, ptrdiff_t size), \
+      (target, index, buffer, offset, size)) \
+    X(void, glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, \
+      const void* pointer), (index, size, type, normalized, stride, pointer)) \
+    X(void, glEnableVertexAttribArray, (GLuint index), (index)) \
+    X(void, glVertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor)) \
+    X(void, glDrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instances), \
+      (mode, first, count, instances)) \
+    X(void, glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void* indices, \
+      GLsizei instances), (mode, count, type, indices, instances)) \
+    X(void, glDrawElementsBaseVertex, (GLenum mode, GLsizei count, GLenum type, const void* indices, \
+      GLint base_vertex), (mode, count, type, indices, base_vertex)) \
+    X(void, glUseProgram, (GLuint program), (program)) \
+    X(GLuint, glCreateShader, (GLenum type), (type)) \
+    X(void, glShaderSource, (GLuint shader, GLsizei count, const char* const* strings, const GLint* lengths), \
+      (shader, count, strings, lengths)) \
+    X(void, glCompileShader, (GLuint shader), (shader)) \
+    X(void, glGetShaderiv, (GLuint shader, GLenum pname, GLint* params), (shader, pname, params)) \
+    X(void, glGetShaderInfoLog, (GLuint shader, GLsizei size, GLsizei* length, char* log), \
+      (shader, size, length, log)) \
+    X(void, glDeleteShader, (GLuint shader), (shader)) \
+    X(GLuint, glCreateProgram, (void), ()) \
+    X(void, glAttachShader, (GLuint program, GLuint shader), (program, shader)) \
+    X(void, glLinkProgram, (GLuint program), (program)) \
+    X(void, glGetProgramiv, (GLuint program, GLenum pname, GLint* params), (program, pname, params)) \
+    X(void, glGetProgramInfoLog, (GLuint program, GLsizei size, GLsizei* length, char* log), \
+      (program, size, length, log)) \
+    X(void, glDeleteProgram, (GLuint program), (program)) \
+    X(GLint, glGetUniformLocation, (GLuint program, const char* name), (program, name)) \
+    X(void, glUniform1f, (GLint location, float x), (location, x)) \
+    X(void, glUniform2f, (GLint location, float x, float y), (location, x, y)) \
+    X(void, glUniform3f, (GLint location, float x, float y, float z), (location, x, y, z)) \
+    X(void, glUniform4f, (GLint location, float x, float y, float z, float w), (location, x, y, z, w)) \
+    X(void, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const float* value), \
+      (location, count, transpose, value)) \
+    X(GLint, glGetAttribLocation, (GLuint program, const char* name), (program, name)) \
+    X(void, glBindAttribLocation, (GLuint program, GLuint index, const char* name), (program, index, name)) \
+    X(void, glUniform1i, (GLint location, GLint x), (location, x)) \
+    X(FXGLString, glGetStringi, (GLenum name, GLuint index), (name, index)) \
+    X(void, glActiveTexture, (GLenum texture), (texture)) \
+    X(void, glGenQueries, (GLsizei n, GLuint* ids), (n, ids)) \
+    X(void, glDeleteQueries, (GLsizei n, const GLuint* ids), (n, ids)) \
+    X(void, glBeginQuery, (GLenum target, GLuint id), (target, id)) \
+    X(void, glEndQuery, (GLenum target), (target)) \
+    X(void, glGetQueryObjectiv, (GLuint id, GLenum pname, GLint* params), (id, pname, params)) \
+    X(void, glGetQueryObjectui64v, (GLuint id, GLenum pname, uint64_t* params), (id, pname, params)) \
+    X(GLsync, glFenceSync, (GLenum condition, GLbitfield flags), (condition, flags)) \
+    X(GLenum, glClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout)) \
+    X(void, glDeleteSync, (GLsync sync), (sync)) \
+    X(void, glGetIntegerv, (GLenum pname, GLint* data), (pname, data)) \
+    X(void, glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+    X(void, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), \
+      (mode, count, type, indices)) \
+    X(void, glFlush, (void), ()) \
+    X(void, glEnable, (GLenum cap), (cap)) \
+    X(void, glDisable, (GLenum cap), (cap)) \
+    X(GLboolean, glIsEnabled, (GLenum cap), (cap)) \
+    X(void, glDepthMask, (GLboolean flag), (flag)) \
+    X(void, glDepthFunc, (GLenum func), (func)) \
+    X(void, glCullFace, (GLenum mode), (mode)) \
+    X(void, glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor)) \
+    X(void, glBindTexture, (GLenum target, GLuint texture), (target, texture))
+
+// GL 4.1 or ARB_separate_shader_objects: uniforms set without binding the
+// program. fxgl_init() leaves them NULL when the context's caps lack it, as
+// some drivers hand out pointers for anything asked.
+#define FXGL_PROGRAM_UNIFORM_ENTRY_POINTS(X) \
+    X(void, glProgramUniform1f, (GLuint program, GLint location, float x), (program, location, x)) \
+    X(void, glProgramUniform3f, (GLuint program, GLint location, float x, float y, float z), \
+      (program, location, x, y, z)) \
+    X(void, glProgramUniform4f, (GLuint program, GLint location, float x, float y, float z, float w), \
+      (program, location, x, y, z, w)) \
+    X(void, glProgramUniformMatrix4fv, (GLuint program, GLint location, GLsizei count, GLboolean transpose, \
+      const float* value), (program, location, count, transpose, value)) \
+    X(void, glProgramUniform1i, (GLuint program, GLint location, GLint x), (program, location, x))
+
+// Then GL 4.3: ARB_multi_draw_indirect and KHR_debug
+#define FXGL_OPTIONAL_ENTRY_POINTS(X) \
+    FXGL_PROGRAM_UNIFORM_ENTRY_POINTS(X) \
+    X(void, glMultiDrawArraysIndirect, (GLenum mode, const void* indirect, GLsizei count, GLsizei stride), \
+      (mode, indirect, count, stride)) \
+    X(void, glMultiDrawElementsIndirect, (GLenum mode, GLenum type, const void* indirect, GLsizei count, \
+      GLsizei stride), (mode, type, indirect, count, stride)) \
+    X(void, glDebugMessageCallback, (FXGLDebugProc callback, const void* user), (callback, user)) \
+    X(void, glDebugMessageControl, (GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint* ids, \
+      GLboolean enabled), (source, type, severity, count, ids, enabled)) \
+    X(void, glGetPointerv, (GLenum pname, void** params), (pname, params))
+
+#define FXGL_ENTRY_POINTS(X) FXGL_CORE_ENTRY_POINTS(X) FXGL_OPTIONAL_ENTRY_POINTS(X)
+
+// FXGL_VOID_##ret(a, b) is a for entry points returning void and b otherwise,
+// for code generated from the lists that forwards a call
+#define FXGL_VOID_void(if_void, otherwise) if_void
+#define FXGL_VOID_GLint(if_void, otherwise) otherwise
+#define FXGL_VOID_GLenum(if_void, otherwise) otherwise
+#define FXGL_VOID_GLboolean(if_void, otherwise) otherwise
+#define FXGL_VOID_GLsync(if_void, otherwise) otherwise
+#define FXGL_VOID_GLuint(if_void, otherwise) otherwise
+#define FXGL_VOID_FXGLString(if_void, otherwise) otherwise
+
+// Function pointer types (FXGLProc_glUseProgram, ...)
+#define FXGL_DECLARE(ret, name, params, args) typedef ret (APIENTRYP FXGLProc_##name) params;
+FXGL_ENTRY_POINTS(FXGL_DECLARE)
+#undef FXGL_DECLARE
+
+#if defined(_MSC_VER)
+#define FXGL_THREAD_LOCAL __declspec(thread)
+#else
+#define FXGL_THREAD_LOCAL __thread
+#endif
+
+#define FXGL_EXTENSION_SLOTS 1024
+
+// What the context can do, probed once when its table is filled: the version
+// from GL_VERSION and the extension list hashed into a set. Each flag is the
+// core version or the extension that brings the feature, so the runtime
+// chooses a path by reading a field, never by asking GL.
+typedef struct FXGLCaps {
+    int major;
+    int minor;
+    int dsa;                        // 4.5, ARB_direct_state_access
+    int separate_programs;          // 4.1, ARB_separate_shader_objects: glProgramUniform* loaded
+    int program_binary;             // 4.1, ARB_get_program_binary
+    int timer_query;                // 3.3, ARB_timer_query
+    int parallel_compile;           // KHR_ or ARB_parallel_shader_compile
+    int persistent_mapping;         // 4.4, ARB_buffer_storage
+    int multi_draw_indirect;        // 4.3, ARB_multi_draw_indirect
+    int shader_draw_parameters;     // 4.6, ARB_shader_draw_parameters: gl_DrawIDARB
+    int compute;                    // 4.3, ARB_compute_shader
+    int explicit_uniform_location;  // ARB_explicit_uniform_location, listed (for 330 code)
+    int debug;                      // 4.3, KHR_debug: glDebugMessage* loaded
+    int extension_count;
+    uint32_t extensions[FXGL_EXTENSION_SLOTS];  // Name hashes, open addressed; 0 is empty
+} FXGLCaps;
+
+// One table of entry points per context (or per driver: contexts that share
+// objects can share a table too). Each thread calls through the table it made
+// current, so a worker thread's context never disturbs the render thread's.
+typedef struct FXGLDispatch {
+#define FXGL_DISPATCH_SLOT(ret, name, params, args) FXGLProc_##name proc_##name;
+    FXGL_ENTRY_POINTS(FXGL_DISPATCH_SLOT)
+#undef FXGL_DISPATCH_SLOT
+    FXGLCaps caps;                  // Of the context the table was filled against
+} FXGLDispatch;
+
+// This thread's table. Every thread starts on the process default table,
+// which is all a single-context program ever needs.
+extern FXGL_THREAD_LOCAL FXGLDispatch* fxgl_dispatch;
+
+// The GL names are a macro layer over the current table: glUseProgram(p) is
+// fxgl_dispatch->proc_glUseProgram(p). It also wins over gl.h headers that
+// declare 1.3 entry points (glActiveTexture) as functions. The lists only
+// ever stringize or paste names, so they still see the GL names.
+#define FXGL_CURRENT(name) (fxgl_dispatch->proc_##name)
+#define glGenVertexArrays FXGL_CURRENT(glGenVertexArrays)
+#define glBindVertexArray FXGL_CURRENT(glBindVertexArray)
+#define glDeleteVertexArrays FXGL_CURRENT(glDeleteVertexArrays)
+#define glGenBuffers FXGL_CURRENT(glGenBuffers)
+#define glDeleteBuffers FXGL_CURRENT(glDeleteBuffers)
+#define glBindBuffer FXGL_CURRENT(glBindBuffer)
+#define glBufferData FXGL_CURRENT(glBufferData)
+#define glBufferSubData FXGL_CURRENT(glBufferSubData)
+#define glBindBufferRange FXGL_CURRENT(glBindBufferRange)
+#define glVertexAttribPointer FXGL_CURRENT(glVertexAttribPointer)
+#define glEnableVertexAttribArray FXGL_CURRENT(glEnableVertexAttribArray)
+#define glVertexAttribDivisor FXGL_CURRENT(glVertexAttribDivisor)
+#define glDrawArraysInstanced FXGL_CURRENT(glDrawArraysInstanced)
+#define glDrawElementsInstanced FXGL_CURRENT(glDrawElementsInstanced)
+#define glDrawElementsBaseVertex FXGL_CURRENT(glDrawElementsBaseVertex)
+#define glUseProgram FXGL_CURRENT(glUseProgram)
+#define glCreateShader FXGL_CURRENT(glCreateShader)
+#define glShaderSource FXGL_CURRENT(glShaderSource)
+#define glCompileShader FXGL_CURRENT(glCompileShader)
+#define glGetShaderiv FXGL_CURRENT(glGetShaderiv)
+#define glGetShaderInfoLog FXGL_CURRENT(glGetShaderInfoLog)
+#define glDeleteShader FXGL_CURRENT(glDeleteShader)
+#define glCreateProgram FXGL_CURRENT(glCreateProgram)
+#define glAttachShader FXGL_CURRENT(glAttachShader)
+#define glLinkProgram FXGL_CURRENT(glLinkProgram)
+#define glGetProgramiv FXGL_CURRENT(glGetProgramiv)
+#define glGetProgramInfoLog FXGL_CURRENT(glGetProgramInfoLog)
+#define glDeleteProgram FXGL_CURRENT(glDeleteProgram)
+#define glGetUniformLocation FXGL_CURRENT(glGetUniformLocation)
+#define glUniform1f FXGL_CURRENT(glUniform1f)
+#define glUniform2f FXGL_CURRENT(glUniform2f)
+#define glUniform3f FXGL_CURRENT(glUniform3f)
+#define glUniform4f FXGL_CURRENT(glUniform4f)
+#define glUniformMatrix4fv FXGL_CURRENT(glUniformMatrix4fv)
+#define glGetAttribLocation FXGL_CURRENT(glGetAttribLocation)
+#define glBindAttribLocation FXGL_CURRENT(glBindAttribLocation)
+#define glUniform1i FXGL_CURRENT(glUniform1i)
+#define glGetStringi FXGL_CURRENT(glGetStringi)
+#define glActiveTexture FXGL_CURRENT(glActiveTexture)
+#define glGenQueries FXGL_CURRENT(glGenQueries)
+#define glDeleteQueries FXGL_CURRENT(glDeleteQueries)
+#define glBeginQuery FXGL_CURRENT(glBeginQuery)
+#define glEndQuery FXGL_CURRENT(glEndQuery)
+#define glGetQueryObjectiv FXGL_CURRENT(glGetQueryObjectiv)
+#define glGetQueryObjectui64v FXGL_CURRENT(glGetQueryObjectui64v)
+#define glFenceSync FXGL_CURRENT(glFenceSync)
+#define glClientWaitSync FXGL_CURRENT(glClientWaitSync)
+#define glDeleteSync FXGL_CURRENT(glDeleteSync)
+#define glGetIntegerv FXGL_CURRENT(glGetIntegerv)
+#define glDrawArrays FXGL_CURRENT(glDrawArrays)
+#define glDrawElements FXGL_CURRENT(glDrawElements)
+#define glFlush FXGL_CURRENT(glFlush)
+#define glEnable FXGL_CURRENT(glEnable)
+#define glDisable FXGL_CURRENT(glDisable)
+#define glIsEnabled FXGL_CURRENT(glIsEnabled)
+#define glDepthMask FXGL_CURRENT(glDepthMask)
+#define glDepthFunc FXGL_CURRENT(glDepthFunc)
+#define glCullFace FXGL_CURRENT(glCullFace)
+#define glBlendFunc FXGL_CURRENT(glBlendFunc)
+#define glBindTexture FXGL_CURRENT(glBindTexture)
+#define glProgramUniform1f FXGL_CURRENT(glProgramUniform1f)
+#define glProgramUniform3f FXGL_CURRENT(glProgramUniform3f)
+#define glProgramUniform4f FXGL_CURRENT(glProgramUniform4f)
+#define glProgramUniformMatrix4fv FXGL_CURRENT(glProgramUniformMatrix4fv)
+#define glProgramUniform1i FXGL_CURRENT(glProgramUniform1i)
+#define glMultiDrawArraysIndirect FXGL_CURRENT(glMultiDrawArraysIndirect)
+#define glMultiDrawElementsIndirect FXGL_CURRENT(glMultiDrawElementsIndirect)
+#define glDebugMessageCallback FXGL_CURRENT(glDebugMessageCallback)
+#define glDebugMessageControl FXGL_CURRENT(glDebugMessageControl)
+#define glGetPointerv FXGL_CURRENT(glGetPointerv)
+
+// A table for another context: a copy of share, which reuses everything it
+// has resolved, or with share NULL a fresh one whose optional entry points are
+// resolved against the context current on this thread. NULL if out of memory.
+FXGLDispatch* fxgl_dispatch_create(const FXGLDispatch* share);
+void fxgl_dispatch_destroy(FXGLDispatch* dispatch);
+
+// Switches this thread's table, alongside making a context current. NULL goes
+// back to the process default.
+void fxgl_make_current(FXGLDispatch* dispatch);
+
+// What the loader has done since the last fxgl_init()
+typedef struct FXGLLoaderInfo {
+    const char* backend;        // "wgl", "egl", "glx", or "none" before init
+    int resolved;               // Optional entry points plus core ones called so far
+    int missing;                // Optional entry points the driver lacks, core ones that failed
+    uint64_t init_ns;
+    uint64_t lazy_ns;           // Spent resolving core entry points on first call
+} FXGLLoaderInfo;
+
+// Opens the GL library and resolves the optional entry points of this
+// thread's table against the context current on this thread; core ones are
+// left to their trampolines. Safe to call again after switching drivers:
+// every pointer in the table resolves afresh.
+int fxgl_init(void);
+
+// Resolves every core entry point of this thread's table now, for a startup check or before a
+// latency-sensitive section. Returns 0, naming each one on stderr, if any
+// is missing.
+int fxgl_resolve_all(void);
+void fxgl_loader_info(FXGLLoaderInfo* info);
+
+// Looks up one function through the backend fxgl_init() chose
+void* fxgl_get_proc(const char* name);
+
+// The capabilities of this thread's table, and extension lookups in its set.
+// Zeroed until fxgl_init() runs with a context current.
+const FXGLCaps* fxgl_caps(void);
+int fxgl_has_extension(const char* name);
+
+// Headless rendering: creates a GL core context of at least major.minor on a
+// surfaceless EGL display and makes it current, with no window system at all.
+// Draw into a framebuffer object. EGL platforms only; returns 0 elsewhere.
+int fxgl_create_headless_context(int major, int minor);
 
-// Function pointer types
-typedef void (APIENTRYP PFNGLGENVERTEXARRAYS)(GLsizei, GLuint*);
-typedef void (APIENTRYP PFNGLBINDVERTEXARRAY)(GLuint);
-typedef void (APIENTRYP PFNGLGENBUFFERS)(GLsizei, GLuint*);
-typedef void (APIENTRYP PFNGLBINDBUFFER)(GLenum, GLuint);
-typedef void (APIENTRYP PFNGLBUFFERDATA)(GLenum, ptrdiff_t, const void*, GLenum);
-typedef void (APIENTRYP PFNGLVERTEXATTRIBPOINTER)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*);
-typedef void (APIENTRYP PFNGLENABLEVERTEXATTRIBARRAY)(GLuint);
-typedef void (APIENTRYP PFNGLUSEPROGRAM)(GLuint);
-typedef GLuint (APIENTRYP PFNGLCREATESHADER)(GLenum);
-typedef void (APIENTRYP PFNGLSHADERSOURCE)(GLuint, GLsizei, const char* const*, const GLint*);
-typedef void (APIENTRYP PFNGLCOMPILESHADER)(GLuint);
-typedef void (APIENTRYP PFNGLGETSHADERIV)(GLuint, GLenum, GLint*);
-typedef void (APIENTRYP PFNGLGETSHADERINFOLOG)(GLuint, GLsizei, GLsizei*, char*);
-typedef void (APIENTRYP PFNGLDELETESHADER)(GLuint);
-typedef GLuint (APIENTRYP PFNGLCREATEPROGRAM)(void);
-typedef void (APIENTRYP PFNGLATTACHSHADER)(GLuint, GLuint);
-typedef void (APIENTRYP PFNGLLINKPROGRAM)(GLuint);
-typedef void (APIENTRYP PFNGLGETPROGRAMIV)(GLuint, GLenum, GLint*);
-typedef void (APIENTRYP PFNGLGETPROGRAMINFOLOG)(GLuint, GLsizei, GLsizei*, char*);
-typedef void (APIENTRYP PFNGLDELETEPROGRAM)(GLuint);
-typedef GLint (APIENTRYP PFNGLGETUNIFORMLOCATION)(GLuint, const char*);
-typedef void (APIENTRYP PFNGLUNIFORM1F)(GLint, float);
-typedef void (APIENTRYP PFNGLUNIFORM3F)(GLint, float, float, float);
-typedef void (APIENTRYP PFNGLUNIFORM4F)(GLint, float, float, float, float);
-typedef void (APIENTRYP PFNGLUNIFORMMATRIX4FV)(GLint, GLsizei, GLboolean, const float*);
-typedef GLint (APIENTRYP PFNGLGETATTRIBLOCATION)(GLuint, const char*);
-
-// Function pointers
-extern PFNGLGENVERTEXARRAYS glGenVertexArrays;
-extern PFNGLBINDVERTEXARRAY glBindVertexArray;
-extern PFNGLGENBUFFERS glGenBuffers;
-extern PFNGLBINDBUFFER glBindBuffer;
-extern PFNGLBUFFERDATA glBufferData;
-extern PFNGLVERTEXATTRIBPOINTER glVertexAttribPointer;
-extern PFNGLENABLEVERTEXATTRIBARRAY glEnableVertexAttribArray;
-extern PFNGLUSEPROGRAM glUseProgram;
-extern PFNGLCREATESHADER glCreateShader;
-extern PFNGLSHADERSOURCE glShaderSource;
-extern PFNGLCOMPILESHADER glCompileShader;
-extern PFNGLGETSHADERIV glGetShaderiv;
-extern PFNGLGETSHADERINFOLOG glGetShaderInfoLog;
-extern PFNGLDELETESHADER glDeleteShader;
-extern PFNGLCREATEPROGRAM glCreateProgram;
-extern PFNGLATTACHSHADER glAttachShader;
-extern PFNGLLINKPROGRAM glLinkProgram;
-extern PFNGLGETPROGRAMIV glGetProgramiv;
-extern PFNGLGETPROGRAMINFOLOG glGetProgramInfoLog;
-extern PFNGLDELETEPROGRAM glDeleteProgram;
-extern PFNGLGETUNIFORMLOCATION glGetUniformLocation;
-extern PFNGLUNIFORM1F glUniform1f;
-extern PFNGLUNIFORM3F glUniform3f;
-extern PFNGLUNIFORM4F glUniform4f;
-extern PFNGLUNIFORMMATRIX4FV glUniformMatrix4fv;
-extern PFNGLGETATTRIBLOCATION glGetAttribLocation;
-
-// Loader function
-static void* fxgl_get_proc(const char* name) {
-    void* p = (void*)wglGetProcAddress(name);
-    if (!p) {
-        HMODULE module = LoadLibraryA("opengl32.dll");
-        p = (void*)GetProcAddress(module, name);
-    }
-    return p;
-}
+// A context sharing objects with the one current on this thread, of the same
+// version and profile, for a worker thread to make current without a surface.
+// EGL only; NULL elsewhere or on failure.
+typedef struct FXGLSharedContext FXGLSharedContext;
+FXGLSharedContext* fxgl_shared_context_create(void);
+int fxgl_shared_context_make_current(FXGLSharedContext* context);  // NULL releases
+void fxgl_shared_context_destroy(FXGLSharedContext* context);
 
 #endif // FX_GL_H 
\ No newline at end of file
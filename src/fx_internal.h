@@ -0,0 +1,102 @@
+/*
+ * FX Shader Runtime Internals
+ * Shared between the runtime translation units - not part of the public API
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifndef FX_INTERNAL_H
+#define FX_INTERNAL_H
+
+#include "fx_runtime.h"
+#include "fx_platform.h"
+
+// Statistics (fx_stats.c). FX_STAT_ADD is for the GL thread only;
+// FX_STAT_ADD_ATOMIC for code that also runs on loader or compile threads.
+#ifndef FX_NO_STATS
+extern FXStatsCounters fx_stats_counters;
+#define FX_STAT_ADD(field, n) (fx_stats_counters.field += (uint64_t)(n))
+#define FX_STAT_ADD_ATOMIC(field, n) __atomic_add_fetch(&fx_stats_counters.field, (uint64_t)(n), __ATOMIC_RELAXED)
+#define FX_STAT_TIMER(start) uint64_t start = fx_time_ns()
+#define FX_STAT_ELAPSED(field, start) FX_STAT_ADD(field, fx_time_ns() - (start))
+#define FX_STAT_ELAPSED_ATOMIC(field, start) FX_STAT_ADD_ATOMIC(field, fx_time_ns() - (start))
+#else
+#define FX_STAT_ADD(field, n) ((void)0)
+#define FX_STAT_ADD_ATOMIC(field, n) ((void)0)
+#define FX_STAT_TIMER(start)
+#define FX_STAT_ELAPSED(field, start) ((void)0)
+#define FX_STAT_ELAPSED_ATOMIC(field, start) ((void)0)
+#endif
+
+// A shader load, split into the part that can run on any thread (file reads,
+// metadata parsing), the part that needs a GL context (compile, link, location
+// lookup: fx_load_job_build) and the part for the GL thread (fx_load_job_adopt).
+// fx_load() runs them back to back; fx_load_job_finish() is the last two.
+typedef struct FXLoadJob {
+    char* name;
+    char* vert_source;
+    char* frag_source;
+    FXReflection reflection;   // From .meta, locations not yet resolved
+    FXCTarget target;          // For fx_load_job_compile(); gl33 unless set
+    FXLoadCallback callback;
+    void* user;
+    GLuint program;            // Built on the compile thread
+    GLsync fence;              // Signalled once the compile thread's commands are done
+    struct FXLoadJob* next;
+} FXLoadJob;
+
+FXLoadJob* fx_load_job_create(const char* shader_name);
+int fx_load_job_read(FXLoadJob* job);
+int fx_load_job_compile(FXLoadJob* job, const char* src, size_t length, const char* source_path,
+                        const char* program, char* output_name, size_t output_size);
+int fx_load_job_compile_file(FXLoadJob* job, const char* fx_path, const char* program,
+                             char* output_name, size_t output_size);
+GLuint fx_load_job_build(FXLoadJob* job);
+FXShader* fx_load_job_adopt(FXLoadJob* job, GLuint program);
+FXShader* fx_load_job_finish(FXLoadJob* job);
+int fx_load_job_swap(FXLoadJob* job, FXShader* shader);
+void fx_load_job_free(FXLoadJob* job);
+FXCTarget fx_reflection_target(const FXReflection* reflection);
+
+// Registry (fx_registry.c)
+FXShader* fx_registry_acquire(const char* name);
+void fx_registry_insert(FXShader* shader);
+int fx_registry_release(FXShader* shader);
+FXShader* fx_registry_find(const char* name);
+
+// Every glUseProgram the runtime makes for a shader is reported here, so
+// pipeline applies diff against the right program and GPU timing attributes
+// the draws that follow (fx_runtime.c)
+void fx_program_bound(FXShader* shader);
+
+// Vertex layouts (fx_vertex.c): hashes first, then every attribute
+int fx_vertex_layout_equal(const FXVertexLayout* a, const FXVertexLayout* b);
+
+// Pipeline state (fx_pipeline.c)
+void fx_pipeline_program_changed(GLuint program);
+GLuint fx_pipeline_current_program(void);   // Asks GL once after a state reset
+
+// GPU timing (fx_timing.c)
+extern int fx_gpu_timing_enabled;
+void fx_gpu_timing_switch(FXShader* shader);
+
+// Performance warnings (fx_debug.c): the shader the runtime bound last, for
+// attribution, while enabled; cleared when that shader is freed
+extern int fx_perf_warnings_enabled;
+extern FXShader* fx_perf_warnings_shader;
+
+// Background compile thread (fx_compile.c)
+extern int fx_compile_running;
+extern int fx_compile_pending;  // Built jobs waiting for the GL thread
+void fx_compile_submit(FXLoadJob* job);
+int fx_compile_apply(void);
+
+// Live reload (fx_reload.c)
+extern int fx_reload_pending;   // Reloaded jobs waiting for the GL thread
+void fx_reload_watch(const char* shader_name, const char* source_path, const char* source_shader, FXCTarget target);
+void fx_reload_unwatch(const char* shader_name);
+int fx_reload_apply(void);
+
+#endif // FX_INTERNAL_H
@@ -0,0 +1,212 @@
+/*
+ * FX Vertex Packing Implementation
+ * Half floats, normalized integers and 10-10-10-2 words
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_pack.h"
+#include <string.h>
+
+static float clamp(float value, float low, float high) {
+    if (value < low) return low;
+    if (value > high) return high;
+    return value;   // NaN falls through and rounds to 0 below
+}
+
+static int round_to_int(float value) {
+    return value >= 0.0f ? (int)(value + 0.5f) : (int)(value - 0.5f);
+}
+
+uint16_t fx_pack_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t float_exponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    int exponent = (int)float_exponent - 127 + 15;
+
+    if (float_exponent == 0xFF) return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));  // Inf, NaN
+    if (exponent >= 31) return (uint16_t)(sign | 0x7C00);                                   // Overflow
+    if (exponent <= 0) {
+        // Subnormal half, or zero when even that is too small
+        if (exponent < -10) return (uint16_t)sign;
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t midpoint = 1u << (shift - 1);
+        if (rest > midpoint || (rest == midpoint && (half & 1))) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    // Round to nearest even; a carry out of the mantissa correctly bumps the exponent
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+    return (uint16_t)half;
+}
+
+float fx_unpack_half(uint16_t value) {
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0) {
+        float result = (float)mantissa * (1.0f / 16777216.0f);
+        return sign ? -result : result;
+    } else if (exponent == 31) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+int16_t fx_pack_snorm16(float value) {
+    return (int16_t)round_to_int(clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+uint16_t fx_pack_unorm16(float value) {
+    return (uint16_t)round_to_int(clamp(value, 0.0f, 1.0f) * 65535.0f);
+}
+
+int8_t fx_pack_snorm8(float value) {
+    return (int8_t)round_to_int(clamp(value, -1.0f, 1.0f) * 127.0f);
+}
+
+uint8_t fx_pack_unorm8(float value) {
+    return (uint8_t)round_to_int(clamp(value, 0.0f, 1.0f) * 255.0f);
+}
+
+// x in the low bits, w in the top two: GL_*INT_2_10_10_10_REV order
+uint32_t fx_pack_snorm10_10_10_2(float x, float y, float z, float w) {
+    uint32_t px = (uint32_t)round_to_int(clamp(x, -1.0f, 1.0f) * 511.0f) & 0x3FF;
+    uint32_t py = (uint32_t)round_to_int(clamp(y, -1.0f, 1.0f) * 511.0f) & 0x3FF;
+    uint32_t pz = (uint32_t)round_to_int(clamp(z, -1.0f, 1.0f) * 511.0f) & 0x3FF;
+    uint32_t pw = (uint32_t)round_to_int(clamp(w, -1.0f, 1.0f)) & 0x3;
+    return px | (py << 10) | (pz << 20) | (pw << 30);
+}
+
+uint32_t fx_pack_unorm10_10_10_2(float x, float y, float z, float w) {
+    uint32_t px = (uint32_t)round_to_int(clamp(x, 0.0f, 1.0f) * 1023.0f);
+    uint32_t py = (uint32_t)round_to_int(clamp(y, 0.0f, 1.0f) * 1023.0f);
+    uint32_t pz = (uint32_t)round_to_int(clamp(z, 0.0f, 1.0f) * 1023.0f);
+    uint32_t pw = (uint32_t)round_to_int(clamp(w, 0.0f, 1.0f) * 3.0f);
+    return px | (py << 10) | (pz << 20) | (pw << 30);
+}
+
+// The per-vertex stream (divisor 0) or the per-instance one (divisor 1)
+static size_t float_stream_size(const FXReflectHeader* reflection, uint32_t divisor) {
+    if (!reflection) return 0;
+    const FXReflectRecord* inputs = fx_reflect_inputs((FXReflectHeader*)reflection);
+    size_t size = 0;
+    for (uint32_t i = 0; i < reflection->input_count; i++) {
+        if (inputs[i].divisor != divisor) continue;
+        size += (size_t)fx_reflect_components((FXReflectType)inputs[i].type) * sizeof(float);
+    }
+    return size;
+}
+
+static size_t packed_stream_size(const FXReflectHeader* reflection, uint32_t divisor) {
+    if (!reflection) return 0;
+    const FXReflectRecord* inputs = fx_reflect_inputs((FXReflectHeader*)reflection);
+    size_t size = 0;
+    for (uint32_t i = 0; i < reflection->input_count; i++) {
+        if (inputs[i].divisor != divisor) continue;
+        size_t end = inputs[i].offset +
+                     fx_reflect_attrib_size((FXReflectType)inputs[i].type, (FXVertexFormat)inputs[i].format);
+        if (end > size) size = end;
+    }
+    return size;
+}
+
+size_t fx_float_vertex_size(const FXReflectHeader* reflection) {
+    return float_stream_size(reflection, 0);
+}
+
+size_t fx_packed_vertex_size(const FXReflectHeader* reflection) {
+    return packed_stream_size(reflection, 0);
+}
+
+size_t fx_float_instance_size(const FXReflectHeader* reflection) {
+    return float_stream_size(reflection, 1);
+}
+
+size_t fx_packed_instance_size(const FXReflectHeader* reflection) {
+    return packed_stream_size(reflection, 1);
+}
+
+static void pack_input(const FXReflectRecord* input, const float* src, unsigned char* dst) {
+    int components = fx_reflect_components((FXReflectType)input->type);
+    switch ((FXVertexFormat)input->format) {
+        case FX_FORMAT_HALF:
+            for (int c = 0; c < components; c++) {
+                uint16_t v = fx_pack_half(src[c]);
+                memcpy(dst + c * 2, &v, 2);
+            }
+            break;
+        case FX_FORMAT_SNORM16:
+            for (int c = 0; c < components; c++) {
+                int16_t v = fx_pack_snorm16(src[c]);
+                memcpy(dst + c * 2, &v, 2);
+            }
+            break;
+        case FX_FORMAT_UNORM16:
+            for (int c = 0; c < components; c++) {
+                uint16_t v = fx_pack_unorm16(src[c]);
+                memcpy(dst + c * 2, &v, 2);
+            }
+            break;
+        case FX_FORMAT_SNORM8:
+            for (int c = 0; c < components; c++) dst[c] = (unsigned char)fx_pack_snorm8(src[c]);
+            break;
+        case FX_FORMAT_UNORM8:
+            for (int c = 0; c < components; c++) dst[c] = fx_pack_unorm8(src[c]);
+            break;
+        case FX_FORMAT_SNORM10_10_10_2:
+        case FX_FORMAT_UNORM10_10_10_2: {
+            float w = components > 3 ? src[3] : 0.0f;
+            uint32_t v = input->format == FX_FORMAT_SNORM10_10_10_2
+                ? fx_pack_snorm10_10_10_2(src[0], src[1], src[2], w)
+                : fx_pack_unorm10_10_10_2(src[0], src[1], src[2], w);
+            memcpy(dst, &v, 4);
+            break;
+        }
+        default:
+            memcpy(dst, src, (size_t)components * sizeof(float));
+            break;
+    }
+}
+
+static size_t pack_stream(const FXReflectHeader* reflection, uint32_t divisor,
+                          const float* src, size_t count, void* dst) {
+    size_t stride = packed_stream_size(reflection, divisor);
+    size_t src_floats = float_stream_size(reflection, divisor) / sizeof(float);
+    if (!stride) return 0;
+
+    const FXReflectRecord* inputs = fx_reflect_inputs((FXReflectHeader*)reflection);
+    unsigned char* out = (unsigned char*)dst;
+    memset(out, 0, count * stride);     // Padding bytes stay deterministic
+    for (size_t v = 0; v < count; v++) {
+        const float* in = src + v * src_floats;
+        for (uint32_t i = 0; i < reflection->input_count; i++) {
+            if (inputs[i].divisor != divisor) continue;
+            pack_input(&inputs[i], in, out + v * stride + inputs[i].offset);
+            in += fx_reflect_components((FXReflectType)inputs[i].type);
+        }
+    }
+    return count * stride;
+}
+
+size_t fx_pack_vertices(const FXReflectHeader* reflection, const float* src, size_t vertex_count, void* dst) {
+    return pack_stream(reflection, 0, src, vertex_count, dst);
+}
+
+size_t fx_pack_instances(const FXReflectHeader* reflection, const float* src, size_t instance_count, void* dst) {
+    return pack_stream(reflection, 1, src, instance_count, dst);
+}
@@ -0,0 +1,42 @@
+/*
+ * FX Vertex Packing
+ * Converts float vertex data to the packed() formats declared in .fx inputs
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifndef FX_PACK_H
+#define FX_PACK_H
+
+#include "fx_reflect.h"
+
+// Single values. Normalized formats clamp to their range and round to nearest.
+uint16_t fx_pack_half(float value);
+float fx_unpack_half(uint16_t value);
+int16_t fx_pack_snorm16(float value);
+uint16_t fx_pack_unorm16(float value);
+int8_t fx_pack_snorm8(float value);
+uint8_t fx_pack_unorm8(float value);
+uint32_t fx_pack_snorm10_10_10_2(float x, float y, float z, float w);
+uint32_t fx_pack_unorm10_10_10_2(float x, float y, float z, float w);
+
+// Whole meshes, driven by a shader's reflection (FXShader::reflection.header
+// at runtime, or a .meta read by a tool). The source is float vertices with
+// every input's components in declaration order (3 floats for a vec3, 16 for
+// a mat4); the result matches the layout fx_bind_vertex_buffers() sets up.
+// 'instance' inputs are left out of vertices and packed on their own.
+size_t fx_float_vertex_size(const FXReflectHeader* reflection);
+size_t fx_packed_vertex_size(const FXReflectHeader* reflection);
+size_t fx_float_instance_size(const FXReflectHeader* reflection);
+size_t fx_packed_instance_size(const FXReflectHeader* reflection);
+
+// Packs vertex_count vertices from src into dst, which must hold
+// vertex_count * fx_packed_vertex_size() bytes. Returns the bytes written.
+size_t fx_pack_vertices(const FXReflectHeader* reflection, const float* src, size_t vertex_count, void* dst);
+
+// Same for instances, ready for fx_bind_instances()
+size_t fx_pack_instances(const FXReflectHeader* reflection, const float* src, size_t instance_count, void* dst);
+
+#endif // FX_PACK_H
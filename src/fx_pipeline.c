@@ -0,0 +1,246 @@
+/*
+ * FX Shader Runtime - Pipeline State Objects
+ * Immutable program + blend/depth/raster bundles, deduplicated and diffed on apply
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+
+#define FX_PIPELINE_INITIAL_BUCKETS 64
+
+struct FXPipeline {
+    FXPipelineDesc desc;
+    unsigned int hash;
+    int refcount;
+    struct FXPipeline* next;    // Table hash chain
+};
+
+// Chained hash table of live pipelines. GL thread only.
+static struct {
+    FXPipeline** buckets;
+    unsigned int bucket_count;  // Always a power of two
+    FXPipelineStats stats;
+} g_pipelines;
+
+// The GL state the last applies left behind. Unknown state is -1 for the
+// toggles and GL_NONE for the enums, which never match a wanted value, so the
+// first apply after startup or fx_pipeline_state_reset() sets everything.
+typedef struct FXGLState {
+    GLint program;              // fx_use(), queues and batches report theirs
+    int blend;
+    GLenum blend_src;
+    GLenum blend_dst;
+    int depth_test;
+    GLenum depth_func;
+    int depth_write;
+    int cull;
+    GLenum cull_face;
+} FXGLState;
+
+static const FXGLState g_unknown_state = { -1, -1, GL_NONE, GL_NONE, -1, GL_NONE, -1, -1, GL_NONE };
+static FXGLState g_state = { -1, -1, GL_NONE, GL_NONE, -1, GL_NONE, -1, -1, GL_NONE };
+
+static unsigned int hash_u32(unsigned int hash, unsigned int value) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int desc_hash(const FXPipelineDesc* desc) {
+    unsigned int hash = 2166136261u;
+    hash = hash_u32(hash, (unsigned int)(size_t)desc->shader);
+    hash = hash_u32(hash, (unsigned int)desc->blend);
+    hash = hash_u32(hash, (unsigned int)desc->depth_test);
+    hash = hash_u32(hash, desc->depth_write ? 1u : 0u);
+    hash = hash_u32(hash, (unsigned int)desc->cull);
+    return hash;
+}
+
+static int desc_equal(const FXPipelineDesc* a, const FXPipelineDesc* b) {
+    return a->shader == b->shader && a->blend == b->blend && a->depth_test == b->depth_test &&
+           !a->depth_write == !b->depth_write && a->cull == b->cull;
+}
+
+static void table_grow(void) {
+    unsigned int new_count = g_pipelines.bucket_count ? g_pipelines.bucket_count * 2 : FX_PIPELINE_INITIAL_BUCKETS;
+    FXPipeline** new_buckets = (FXPipeline**)calloc(new_count, sizeof(FXPipeline*));
+    if (!new_buckets) return;
+
+    for (unsigned int i = 0; i < g_pipelines.bucket_count; i++) {
+        FXPipeline* p = g_pipelines.buckets[i];
+        while (p) {
+            FXPipeline* next = p->next;
+            unsigned int b = p->hash & (new_count - 1);
+            p->next = new_buckets[b];
+            new_buckets[b] = p;
+            p = next;
+        }
+    }
+    free(g_pipelines.buckets);
+    g_pipelines.buckets = new_buckets;
+    g_pipelines.bucket_count = new_count;
+}
+
+FXPipeline* fx_pipeline_create(const FXPipelineDesc* desc) {
+    if (!desc || !desc->shader) return NULL;
+    if (desc->blend < FX_BLEND_OPAQUE || desc->blend > FX_BLEND_ADDITIVE ||
+        desc->depth_test < FX_DEPTH_OFF || desc->depth_test > FX_DEPTH_ALWAYS ||
+        desc->cull < FX_CULL_NONE || desc->cull > FX_CULL_FRONT) {
+        fprintf(stderr, "Invalid pipeline state for %s\n", desc->shader->name);
+        return NULL;
+    }
+
+    unsigned int hash = desc_hash(desc);
+    if (g_pipelines.bucket_count) {
+        for (FXPipeline* p = g_pipelines.buckets[hash & (g_pipelines.bucket_count - 1)]; p; p = p->next) {
+            if (p->hash == hash && desc_equal(&p->desc, desc)) {
+                p->refcount++;
+                g_pipelines.stats.dedup_hits++;
+                return p;
+            }
+        }
+    }
+
+    FXPipeline* p = (FXPipeline*)calloc(1, sizeof(FXPipeline));
+    if (!p) return NULL;
+    p->desc = *desc;
+    p->desc.depth_write = desc->depth_write ? 1 : 0;
+    p->hash = hash;
+    p->refcount = 1;
+
+    if ((unsigned int)g_pipelines.stats.pipelines >= g_pipelines.bucket_count) table_grow();
+    if (!g_pipelines.bucket_count) {
+        free(p);
+        return NULL;
+    }
+    unsigned int b = hash & (g_pipelines.bucket_count - 1);
+    p->next = g_pipelines.buckets[b];
+    g_pipelines.buckets[b] = p;
+    g_pipelines.stats.pipelines++;
+    return p;
+}
+
+void fx_pipeline_release(FXPipeline* pipeline) {
+    if (!pipeline || --pipeline->refcount > 0) return;
+    FXPipeline** link = &g_pipelines.buckets[pipeline->hash & (g_pipelines.bucket_count - 1)];
+    while (*link && *link != pipeline) link = &(*link)->next;
+    if (*link) *link = pipeline->next;
+    g_pipelines.stats.pipelines--;
+    free(pipeline);
+}
+
+const FXPipelineDesc* fx_pipeline_desc(const FXPipeline* pipeline) {
+    return pipeline ? &pipeline->desc : NULL;
+}
+
+// Each piece of state costs one GL call when it changes and none otherwise
+static void set_capability(GLenum cap, int* current, int wanted) {
+    if (*current == wanted) {
+        g_pipelines.stats.changes_avoided++;
+        return;
+    }
+    if (wanted) glEnable(cap);
+    else glDisable(cap);
+    *current = wanted;
+    g_pipelines.stats.state_changes++;
+}
+
+static int set_value(GLenum* current, GLenum wanted) {
+    if (*current == wanted) {
+        g_pipelines.stats.changes_avoided++;
+        return 0;
+    }
+    *current = wanted;
+    g_pipelines.stats.state_changes++;
+    return 1;
+}
+
+void fx_pipeline_apply(const FXPipeline* pipeline) {
+    if (!pipeline) return;
+    const FXPipelineDesc* desc = &pipeline->desc;
+    g_pipelines.stats.applies++;
+
+    // Reads the program at apply time, so a live reload is picked up
+    GLuint program = desc->shader->program;
+    if (g_state.program == (GLint)program) {
+        g_pipelines.stats.changes_avoided++;
+    } else {
+        glUseProgram(program);
+        fx_program_bound(desc->shader);
+        g_pipelines.stats.state_changes++;
+    }
+
+    // Factors only matter while blending is on; an opaque pipeline leaves
+    // them as they are
+    set_capability(GL_BLEND, &g_state.blend, desc->blend != FX_BLEND_OPAQUE);
+    if (desc->blend != FX_BLEND_OPAQUE) {
+        GLenum src = GL_ONE, dst = GL_ONE;
+        switch (desc->blend) {
+            case FX_BLEND_ALPHA:         src = GL_SRC_ALPHA; dst = GL_ONE_MINUS_SRC_ALPHA; break;
+            case FX_BLEND_PREMULTIPLIED: dst = GL_ONE_MINUS_SRC_ALPHA; break;
+            default: break;
+        }
+        if (g_state.blend_src != src || g_state.blend_dst != dst) {
+            glBlendFunc(src, dst);
+            g_state.blend_src = src;
+            g_state.blend_dst = dst;
+            g_pipelines.stats.state_changes++;
+        } else {
+            g_pipelines.stats.changes_avoided++;
+        }
+    }
+
+    set_capability(GL_DEPTH_TEST, &g_state.depth_test, desc->depth_test != FX_DEPTH_OFF);
+    if (desc->depth_test != FX_DEPTH_OFF) {
+        static const GLenum funcs[] = { GL_NONE, GL_LESS, GL_LEQUAL, GL_EQUAL, GL_ALWAYS };
+        GLenum func = funcs[desc->depth_test];
+        if (set_value(&g_state.depth_func, func)) glDepthFunc(func);
+    }
+    // The mask also governs glClear, so it is kept exact even with the test off
+    int depth_write = desc->depth_write ? 1 : 0;
+    if (g_state.depth_write != depth_write) {
+        glDepthMask(depth_write ? GL_TRUE : GL_FALSE);
+        g_state.depth_write = depth_write;
+        g_pipelines.stats.state_changes++;
+    } else {
+        g_pipelines.stats.changes_avoided++;
+    }
+
+    set_capability(GL_CULL_FACE, &g_state.cull, desc->cull != FX_CULL_NONE);
+    if (desc->cull != FX_CULL_NONE) {
+        GLenum face = desc->cull == FX_CULL_FRONT ? GL_FRONT : GL_BACK;
+        if (set_value(&g_state.cull_face, face)) glCullFace(face);
+    }
+}
+
+void fx_pipeline_program_changed(GLuint program) {
+    g_state.program = (GLint)program;
+}
+
+GLuint fx_pipeline_current_program(void) {
+    if (g_state.program < 0) {
+        GLint program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        g_state.program = program;
+    }
+    return (GLuint)g_state.program;
+}
+
+void fx_pipeline_state_reset(void) {
+    g_state = g_unknown_state;
+}
+
+void fx_pipeline_stats(FXPipelineStats* stats) {
+    if (stats) *stats = g_pipelines.stats;
+}
+
+void fx_pipeline_stats_reset(void) {
+    int pipelines = g_pipelines.stats.pipelines;
+    memset(&g_pipelines.stats, 0, sizeof(g_pipelines.stats));
+    g_pipelines.stats.pipelines = pipelines;
+}
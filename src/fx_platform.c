@@ -0,0 +1,176 @@
+/*
+ * FX Platform Layer Implementation
+ * Threads, locks, atomics, timers and mapped files for the runtime - Win32 and POSIX
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "fx_platform.h"
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// The native thread entry points have different signatures, so every thread
+// starts in a small trampoline that unpacks the caller's proc and argument.
+typedef struct {
+    FXThreadProc proc;
+    void* arg;
+} FXThreadStart;
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+    FXThreadStart start = *(FXThreadStart*)param;
+    free(param);
+    start.proc(start.arg);
+    return 0;
+}
+
+int fx_thread_start(FXThread* thread, FXThreadProc proc, void* arg) {
+    FXThreadStart* start = (FXThreadStart*)malloc(sizeof(FXThreadStart));
+    if (!start) return 0;
+    start->proc = proc;
+    start->arg = arg;
+    *thread = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+    if (!*thread) {
+        free(start);
+        return 0;
+    }
+    return 1;
+}
+
+void fx_thread_join(FXThread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+int fx_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+void fx_mutex_init(FXMutex* mutex) { InitializeCriticalSection(mutex); }
+void fx_mutex_destroy(FXMutex* mutex) { DeleteCriticalSection(mutex); }
+void fx_mutex_lock(FXMutex* mutex) { EnterCriticalSection(mutex); }
+void fx_mutex_unlock(FXMutex* mutex) { LeaveCriticalSection(mutex); }
+
+void fx_cond_init(FXCond* cond) { InitializeConditionVariable(cond); }
+void fx_cond_destroy(FXCond* cond) { (void)cond; }
+void fx_cond_wait(FXCond* cond, FXMutex* mutex) { SleepConditionVariableCS(cond, mutex, INFINITE); }
+void fx_cond_signal(FXCond* cond) { WakeConditionVariable(cond); }
+void fx_cond_broadcast(FXCond* cond) { WakeAllConditionVariable(cond); }
+
+uint64_t fx_time_ns(void) {
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (!frequency.QuadPart) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    // Split to avoid overflowing 64 bits on long uptimes
+    uint64_t seconds = (uint64_t)(counter.QuadPart / frequency.QuadPart);
+    uint64_t remainder = (uint64_t)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000000ull + remainder * 1000000000ull / (uint64_t)frequency.QuadPart;
+}
+
+void* fx_map_file(const char* path, size_t* size) {
+    // FILE_SHARE_DELETE lets fxc rename a new file over one we have mapped
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER file_size;
+    void* data = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapping) {
+            data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+    if (data) *size = (size_t)file_size.QuadPart;
+    return data;
+}
+
+void fx_unmap_file(void* data, size_t size) {
+    (void)size;
+    if (data) UnmapViewOfFile(data);
+}
+
+#else
+
+static void* thread_entry(void* param) {
+    FXThreadStart start = *(FXThreadStart*)param;
+    free(param);
+    start.proc(start.arg);
+    return NULL;
+}
+
+int fx_thread_start(FXThread* thread, FXThreadProc proc, void* arg) {
+    FXThreadStart* start = (FXThreadStart*)malloc(sizeof(FXThreadStart));
+    if (!start) return 0;
+    start->proc = proc;
+    start->arg = arg;
+    if (pthread_create(thread, NULL, thread_entry, start) != 0) {
+        free(start);
+        return 0;
+    }
+    return 1;
+}
+
+void fx_thread_join(FXThread thread) {
+    pthread_join(thread, NULL);
+}
+
+int fx_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+void fx_mutex_init(FXMutex* mutex) { pthread_mutex_init(mutex, NULL); }
+void fx_mutex_destroy(FXMutex* mutex) { pthread_mutex_destroy(mutex); }
+void fx_mutex_lock(FXMutex* mutex) { pthread_mutex_lock(mutex); }
+void fx_mutex_unlock(FXMutex* mutex) { pthread_mutex_unlock(mutex); }
+
+void fx_cond_init(FXCond* cond) { pthread_cond_init(cond, NULL); }
+void fx_cond_destroy(FXCond* cond) { pthread_cond_destroy(cond); }
+void fx_cond_wait(FXCond* cond, FXMutex* mutex) { pthread_cond_wait(cond, mutex); }
+void fx_cond_signal(FXCond* cond) { pthread_cond_signal(cond); }
+void fx_cond_broadcast(FXCond* cond) { pthread_cond_broadcast(cond); }
+
+uint64_t fx_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void* fx_map_file(const char* path, size_t* size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    void* data = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) data = NULL;
+    }
+    close(fd);
+    if (data) *size = (size_t)st.st_size;
+    return data;
+}
+
+void fx_unmap_file(void* data, size_t size) {
+    if (data) munmap(data, size);
+}
+
+#endif
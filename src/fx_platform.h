@@ -0,0 +1,65 @@
+/*
+ * FX Platform Layer
+ * Threads, locks, atomics, timers and mapped files for the runtime - Win32 and POSIX
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifndef FX_PLATFORM_H
+#define FX_PLATFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE FXThread;
+typedef CRITICAL_SECTION FXMutex;
+typedef CONDITION_VARIABLE FXCond;
+#else
+#include <pthread.h>
+typedef pthread_t FXThread;
+typedef pthread_mutex_t FXMutex;
+typedef pthread_cond_t FXCond;
+#endif
+
+typedef void (*FXThreadProc)(void* arg);
+
+// Threads
+int fx_thread_start(FXThread* thread, FXThreadProc proc, void* arg);
+void fx_thread_join(FXThread thread);
+int fx_cpu_count(void);
+
+// Locks and condition variables
+void fx_mutex_init(FXMutex* mutex);
+void fx_mutex_destroy(FXMutex* mutex);
+void fx_mutex_lock(FXMutex* mutex);
+void fx_mutex_unlock(FXMutex* mutex);
+void fx_cond_init(FXCond* cond);
+void fx_cond_destroy(FXCond* cond);
+void fx_cond_wait(FXCond* cond, FXMutex* mutex);
+void fx_cond_signal(FXCond* cond);
+void fx_cond_broadcast(FXCond* cond);
+
+// Monotonic clock in nanoseconds
+uint64_t fx_time_ns(void);
+
+// Memory-mapped files
+// A private copy-on-write view: writes stay in this process, never reach the
+// file, and only the pages written get copied. NULL for missing or empty files.
+void* fx_map_file(const char* path, size_t* size);
+void fx_unmap_file(void* data, size_t size);
+
+// Atomics (GCC/Clang builtins, available on MinGW and Linux alike)
+#define fx_atomic_load(ptr)          __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define fx_atomic_store(ptr, value)  __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define fx_atomic_add(ptr, value)    __atomic_add_fetch((ptr), (value), __ATOMIC_ACQ_REL)
+#define fx_atomic_sub(ptr, value)    __atomic_sub_fetch((ptr), (value), __ATOMIC_ACQ_REL)
+#define fx_atomic_exchange(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_ACQ_REL)
+// On failure *expected is updated to the current value
+#define fx_atomic_compare_exchange(ptr, expected, desired) \
+    __atomic_compare_exchange_n((ptr), (expected), (desired), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+#endif // FX_PLATFORM_H
@@ -0,0 +1,189 @@
+/*
+ * FX GL Call Profiler
+ * Timing wrappers generated from the loader's entry point list, thread-local counters
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_profile.h"
+#include "fx_platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef FXGL_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define FXGL_PROFILE_TICKS() __rdtsc()
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define FXGL_PROFILE_TICKS() __rdtsc()
+#else
+#define FXGL_PROFILE_TICKS() fx_time_ns()
+#endif
+
+#define FXGL_PROFILE_MAX_THREADS 64
+
+enum {
+#define FXGL_PROFILE_INDEX(ret, name, params, args) FXGL_PROFILE_##name,
+    FXGL_ENTRY_POINTS(FXGL_PROFILE_INDEX)
+#undef FXGL_PROFILE_INDEX
+    FXGL_PROFILE_COUNT
+};
+
+static const char* g_entry_names[FXGL_PROFILE_COUNT] = {
+#define FXGL_PROFILE_NAME(ret, name, params, args) #name,
+    FXGL_ENTRY_POINTS(FXGL_PROFILE_NAME)
+#undef FXGL_PROFILE_NAME
+};
+
+// Everything a profiled thread touches per call is its own
+typedef struct FXGLProfileThread {
+    FXGLDispatch* target;       // The table the wrappers forward to
+    FXGLDispatch wrappers;
+    uint64_t calls[FXGL_PROFILE_COUNT];
+    uint64_t ticks[FXGL_PROFILE_COUNT];
+} FXGLProfileThread;
+
+static FXGL_THREAD_LOCAL FXGLProfileThread t_profile;
+
+// Threads still profiling, and what ended ones left behind
+static struct {
+    FXGLProfileThread* threads[FXGL_PROFILE_MAX_THREADS];
+    uint64_t calls[FXGL_PROFILE_COUNT];
+    uint64_t ticks[FXGL_PROFILE_COUNT];
+    FXGLDispatch* root;         // The first table wrapped
+    uint64_t start_ticks;       // Tick rate calibration
+    uint64_t start_ns;
+} g_profile;
+
+// A thread given a copy of another thread's wrappers (a table shared into a
+// new context) has no target of its own: its calls pass through uncounted
+#define FXGL_PROFILE_WRAPPER(ret, name, params, args) \
+    static ret APIENTRY fxgl_profile_##name params { \
+        FXGLProfileThread* thread = &t_profile; \
+        if (!thread->target) { \
+            FXGL_VOID_##ret(g_profile.root->proc_##name args; return;, return g_profile.root->proc_##name args;) \
+        } \
+        uint64_t start = FXGL_PROFILE_TICKS(); \
+        FXGL_VOID_##ret(, ret result =) thread->target->proc_##name args; \
+        thread->ticks[FXGL_PROFILE_##name] += FXGL_PROFILE_TICKS() - start; \
+        thread->calls[FXGL_PROFILE_##name]++; \
+        FXGL_VOID_##ret(, return result;) \
+    }
+FXGL_ENTRY_POINTS(FXGL_PROFILE_WRAPPER)
+#undef FXGL_PROFILE_WRAPPER
+
+int fxgl_profile_begin(void) {
+    FXGLProfileThread* thread = &t_profile;
+    if (thread->target) {
+        fprintf(stderr, "This thread is already profiling GL calls\n");
+        return 0;
+    }
+    int slot = -1;
+    for (int i = 0; i < FXGL_PROFILE_MAX_THREADS && slot < 0; i++) {
+        FXGLProfileThread* expected = NULL;
+        if (fx_atomic_compare_exchange(&g_profile.threads[i], &expected, thread)) slot = i;
+    }
+    if (slot < 0) {
+        fprintf(stderr, "GL profiler: more than %d threads\n", FXGL_PROFILE_MAX_THREADS);
+        return 0;
+    }
+    // A trampoline patches the table of the thread calling it, which would
+    // put the driver's function over a wrapper
+    fxgl_resolve_all();
+
+    FXGLDispatch* root = NULL;
+    if (fx_atomic_compare_exchange(&g_profile.root, &root, fxgl_dispatch)) {
+        g_profile.start_ns = fx_time_ns();
+        g_profile.start_ticks = FXGL_PROFILE_TICKS();
+    }
+    memset(thread->calls, 0, sizeof(thread->calls));
+    memset(thread->ticks, 0, sizeof(thread->ticks));
+    thread->target = fxgl_dispatch;
+    // Entry points this table lacks stay NULL, so callers still see them missing
+#define FXGL_PROFILE_INSTALL(ret, name, params, args) \
+    thread->wrappers.proc_##name = thread->target->proc_##name ? fxgl_profile_##name : NULL;
+    FXGL_ENTRY_POINTS(FXGL_PROFILE_INSTALL)
+#undef FXGL_PROFILE_INSTALL
+    thread->wrappers.caps = thread->target->caps;
+    fxgl_make_current(&thread->wrappers);
+    return 1;
+}
+
+void fxgl_profile_end(void) {
+    FXGLProfileThread* thread = &t_profile;
+    if (!thread->target) return;
+    if (fxgl_dispatch == &thread->wrappers) fxgl_make_current(thread->target);
+    for (int i = 0; i < FXGL_PROFILE_COUNT; i++) {
+        if (!thread->calls[i]) continue;
+        fx_atomic_add(&g_profile.calls[i], thread->calls[i]);
+        fx_atomic_add(&g_profile.ticks[i], thread->ticks[i]);
+    }
+    for (int i = 0; i < FXGL_PROFILE_MAX_THREADS; i++) {
+        FXGLProfileThread* expected = thread;
+        if (fx_atomic_compare_exchange(&g_profile.threads[i], &expected, NULL)) break;
+    }
+    thread->target = NULL;
+}
+
+static int by_ns(const void* a, const void* b) {
+    uint64_t x = ((const FXGLProfileEntry*)a)->ns, y = ((const FXGLProfileEntry*)b)->ns;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+int fxgl_profile_report(FXGLProfileEntry* entries, int max_entries) {
+    uint64_t calls[FXGL_PROFILE_COUNT], ticks[FXGL_PROFILE_COUNT];
+    for (int i = 0; i < FXGL_PROFILE_COUNT; i++) {
+        calls[i] = fx_atomic_load(&g_profile.calls[i]);
+        ticks[i] = fx_atomic_load(&g_profile.ticks[i]);
+    }
+    for (int t = 0; t < FXGL_PROFILE_MAX_THREADS; t++) {
+        FXGLProfileThread* thread = fx_atomic_load(&g_profile.threads[t]);
+        if (!thread) continue;
+        for (int i = 0; i < FXGL_PROFILE_COUNT; i++) {
+            calls[i] += thread->calls[i];
+            ticks[i] += thread->ticks[i];
+        }
+    }
+
+    // Ticks to nanoseconds at the rate measured since the first begin
+    double ns_per_tick = 1.0;
+    uint64_t elapsed_ticks = FXGL_PROFILE_TICKS() - g_profile.start_ticks;
+    if (g_profile.root && elapsed_ticks) {
+        ns_per_tick = (double)(fx_time_ns() - g_profile.start_ns) / (double)elapsed_ticks;
+    }
+
+    FXGLProfileEntry sorted[FXGL_PROFILE_COUNT];
+    int count = 0;
+    for (int i = 0; i < FXGL_PROFILE_COUNT; i++) {
+        if (!calls[i]) continue;
+        sorted[count].name = g_entry_names[i];
+        sorted[count].calls = calls[i];
+        sorted[count].ns = (uint64_t)(ticks[i] * ns_per_tick);
+        count++;
+    }
+    qsort(sorted, count, sizeof(FXGLProfileEntry), by_ns);
+    for (int i = 0; i < count && i < max_entries; i++) entries[i] = sorted[i];
+    return count;
+}
+
+#else // FXGL_PROFILE
+
+int fxgl_profile_begin(void) {
+    fprintf(stderr, "GL profiler not built in; compile fx_profile.c with -DFXGL_PROFILE\n");
+    return 0;
+}
+
+void fxgl_profile_end(void) {
+}
+
+int fxgl_profile_report(FXGLProfileEntry* entries, int max_entries) {
+    (void)entries;
+    (void)max_entries;
+    return 0;
+}
+
+#endif // FXGL_PROFILE
@@ -0,0 +1,37 @@
+/*
+ * FX GL Call Profiler
+ * Per-entry-point call counts and CPU time, from wrappers generated off the loader's list
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifndef FX_PROFILE_H
+#define FX_PROFILE_H
+
+#include "fx_gl.h"
+
+// The wrappers are only compiled with -DFXGL_PROFILE on fx_profile.c. Without
+// it fxgl_profile_begin() returns 0, and either way nothing sits between the
+// runtime and the driver until a thread begins profiling.
+
+typedef struct FXGLProfileEntry {
+    const char* name;           // The entry point
+    uint64_t calls;
+    uint64_t ns;                // CPU time in the driver, timer reads included
+} FXGLProfileEntry;
+
+// Swaps this thread's table for one of wrappers that time each call and
+// forward it; counters are per thread, so threads never contend. End it on
+// the same thread, before the thread exits, with the same table current.
+// Returns 0 if this build has no profiler or the thread is already profiled.
+int fxgl_profile_begin(void);
+void fxgl_profile_end(void);
+
+// The entry points with calls, most total time first: fills up to max_entries
+// and returns how many there are. Ended threads count exactly; threads still
+// profiling are read as they run.
+int fxgl_profile_report(FXGLProfileEntry* entries, int max_entries);
+
+#endif // FX_PROFILE_H
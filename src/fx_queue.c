@@ -0,0 +1,326 @@
+/*
+ * FX Shader Runtime - Render Queue
+ * Sort-key draw packets recorded from any thread, radix-sorted and replayed
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+#include "fx_platform.h"
+
+#define FX_QUEUE_SHADOW_LOCATIONS 64    // Uniform locations tracked for redundant sets
+#define FX_QUEUE_PREFETCH 8             // Packets fetched ahead during replay
+
+// One uniform value in a bucket's payload, followed by its floats
+typedef struct FXUniformCommand {
+    GLint location;
+    uint16_t type;          // FXReflectType
+    uint16_t float_count;
+} FXUniformCommand;
+
+typedef struct FXDrawPacket {
+    uint64_t key;
+    FXDrawCall draw;
+    uint32_t payload_offset;    // Uniform commands for this draw, in the bucket payload
+    uint32_t payload_size;
+} FXDrawPacket;
+
+// Each recording thread owns one bucket outright, so recording takes no locks
+// and no atomics. Padded so neighbouring buckets don't share a cache line.
+typedef struct FXQueueBucket {
+    FXDrawPacket* packets;
+    uint32_t count;
+    uint32_t capacity;
+    unsigned char* payload;
+    size_t payload_size;
+    size_t payload_capacity;
+    char padding[64];
+} FXQueueBucket;
+
+typedef struct FXSortEntry {
+    uint64_t key;
+    uint32_t bucket;
+    uint32_t index;
+} FXSortEntry;
+
+struct FXRenderQueue {
+    FXQueueBucket* buckets;
+    int bucket_count;
+    FXSortEntry* entries;       // Sort arrays, kept between frames
+    FXSortEntry* scratch;
+    uint32_t entry_capacity;
+};
+
+uint64_t fx_sort_key(const FXShader* shader, uint32_t material, float depth) {
+    if (depth < 0.0f) depth = 0.0f;
+    if (depth > 1.0f) depth = 1.0f;
+    uint64_t slot = shader ? (shader->slot & 0xFFFF) : 0;
+    uint64_t depth_bits = (uint64_t)(depth * 16777215.0f);
+    return (slot << 48) | ((uint64_t)(material & 0xFFFFFF) << 24) | depth_bits;
+}
+
+FXRenderQueue* fx_queue_create(int thread_count) {
+    if (thread_count < 1) thread_count = 1;
+    FXRenderQueue* queue = (FXRenderQueue*)calloc(1, sizeof(FXRenderQueue));
+    if (!queue) return NULL;
+    queue->buckets = (FXQueueBucket*)calloc(thread_count, sizeof(FXQueueBucket));
+    if (!queue->buckets) {
+        free(queue);
+        return NULL;
+    }
+    queue->bucket_count = thread_count;
+    return queue;
+}
+
+void fx_queue_destroy(FXRenderQueue* queue) {
+    if (!queue) return;
+    for (int i = 0; i < queue->bucket_count; i++) {
+        free(queue->buckets[i].packets);
+        free(queue->buckets[i].payload);
+    }
+    free(queue->buckets);
+    free(queue->entries);
+    free(queue->scratch);
+    free(queue);
+}
+
+void fx_queue_draw(FXRenderQueue* queue, int thread, uint64_t key, const FXDrawCall* draw) {
+    if (!queue || !draw || thread < 0 || thread >= queue->bucket_count) return;
+    FXQueueBucket* bucket = &queue->buckets[thread];
+    if (bucket->count == bucket->capacity) {
+        uint32_t capacity = bucket->capacity ? bucket->capacity * 2 : 1024;
+        FXDrawPacket* packets = (FXDrawPacket*)realloc(bucket->packets, capacity * sizeof(FXDrawPacket));
+        if (!packets) return;
+        bucket->packets = packets;
+        bucket->capacity = capacity;
+    }
+    FXDrawPacket* packet = &bucket->packets[bucket->count++];
+    packet->key = key;
+    packet->draw = *draw;
+    packet->payload_offset = (uint32_t)bucket->payload_size;
+    packet->payload_size = 0;
+}
+
+// Values are 1, 3, 4 or 16 floats. A copy of constant size compiles to a few
+// moves; one of variable size was a rep movsq, whose startup cost was most of
+// what recording a uniform took.
+static void copy_floats(void* dst, const void* src, int count) {
+    switch (count) {
+        case 1:  memcpy(dst, src, 1 * sizeof(float)); break;
+        case 3:  memcpy(dst, src, 3 * sizeof(float)); break;
+        case 4:  memcpy(dst, src, 4 * sizeof(float)); break;
+        case 16: memcpy(dst, src, 16 * sizeof(float)); break;
+        default: memcpy(dst, src, count * sizeof(float)); break;
+    }
+}
+
+// Appends a uniform command to the thread's most recent packet
+static void queue_uniform(FXRenderQueue* queue, int thread, const char* name,
+                          FXReflectType type, const float* values, int float_count) {
+    if (!queue || thread < 0 || thread >= queue->bucket_count) return;
+    FXQueueBucket* bucket = &queue->buckets[thread];
+    if (!bucket->count) return;
+    FXDrawPacket* packet = &bucket->packets[bucket->count - 1];
+
+    // Resolved now, from the reflection table; no GL calls on recording threads
+    FXShader* shader = packet->draw.shader;
+    FXReflectRecord* record = shader && shader->reflection.header
+        ? fx_reflect_find(shader->reflection.header, shader->uniforms, shader->uniform_count, name)
+        : NULL;
+    if (!record || record->location < 0 || record->type != type) return;
+
+    size_t size = sizeof(FXUniformCommand) + float_count * sizeof(float);
+    if (bucket->payload_size + size > bucket->payload_capacity) {
+        size_t capacity = bucket->payload_capacity ? bucket->payload_capacity * 2 : 64 * 1024;
+        while (capacity < bucket->payload_size + size) capacity *= 2;
+        unsigned char* payload = (unsigned char*)realloc(bucket->payload, capacity);
+        if (!payload) return;
+        bucket->payload = payload;
+        bucket->payload_capacity = capacity;
+    }
+    FXUniformCommand command;
+    command.location = record->location;
+    command.type = (uint16_t)type;
+    command.float_count = (uint16_t)float_count;
+    memcpy(bucket->payload + bucket->payload_size, &command, sizeof(command));
+    copy_floats(bucket->payload + bucket->payload_size + sizeof(command), values, float_count);
+    bucket->payload_size += size;
+    packet->payload_size += (uint32_t)size;
+}
+
+void fx_queue_uniform_float(FXRenderQueue* queue, int thread, const char* name, float value) {
+    queue_uniform(queue, thread, name, FX_TYPE_FLOAT, &value, 1);
+}
+
+void fx_queue_uniform_vec3(FXRenderQueue* queue, int thread, const char* name, float x, float y, float z) {
+    float values[3] = { x, y, z };
+    queue_uniform(queue, thread, name, FX_TYPE_VEC3, values, 3);
+}
+
+void fx_queue_uniform_vec4(FXRenderQueue* queue, int thread, const char* name, float x, float y, float z, float w) {
+    float values[4] = { x, y, z, w };
+    queue_uniform(queue, thread, name, FX_TYPE_VEC4, values, 4);
+}
+
+void fx_queue_uniform_mat4(FXRenderQueue* queue, int thread, const char* name, const float* matrix) {
+    queue_uniform(queue, thread, name, FX_TYPE_MAT4, matrix, 16);
+}
+
+// LSD radix sort, one byte per pass. One read of the keys counts all eight
+// bytes; passes where every key has the same byte are skipped, which with
+// typical keys (few shaders, coarse depth) is most.
+static FXSortEntry* radix_sort(FXSortEntry* entries, FXSortEntry* scratch, uint32_t count) {
+    uint32_t histograms[8][256] = {{0}};
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t key = entries[i].key;
+        for (int pass = 0; pass < 8; pass++) histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+    }
+
+    for (int pass = 0; pass < 8; pass++) {
+        int shift = pass * 8;
+        uint32_t* histogram = histograms[pass];
+        if (histogram[(entries[0].key >> shift) & 0xFF] == count) continue;
+
+        uint32_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            uint32_t n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            scratch[histogram[(entries[i].key >> shift) & 0xFF]++] = entries[i];
+        }
+        FXSortEntry* swap = entries;
+        entries = scratch;
+        scratch = swap;
+    }
+    return entries;
+}
+
+static void apply_uniform(const FXUniformCommand* command, const float* values) {
+    switch (command->type) {
+        case FX_TYPE_FLOAT: glUniform1f(command->location, values[0]); break;
+        case FX_TYPE_VEC3:  glUniform3f(command->location, values[0], values[1], values[2]); break;
+        case FX_TYPE_VEC4:  glUniform4f(command->location, values[0], values[1], values[2], values[3]); break;
+        case FX_TYPE_MAT4:  glUniformMatrix4fv(command->location, 1, GL_FALSE, values); break;
+        default: break;
+    }
+}
+
+static void replay(FXRenderQueue* queue, const FXSortEntry* entries, uint32_t count, FXQueueStats* stats) {
+    GLuint program = 0;
+    int have_program = 0;
+    const FXShader* layout_shader = NULL;
+    GLuint vertex_buffer = 0, index_buffer = 0;
+    int have_vertex_array = 0;
+    // Last value written to each location of the bound program
+    const unsigned char* shadow[FX_QUEUE_SHADOW_LOCATIONS];
+
+    for (uint32_t i = 0; i < count; i++) {
+        // Sorted order walks the buckets at random; fetch a few packets ahead
+        if (i + FX_QUEUE_PREFETCH < count) {
+            const FXQueueBucket* ahead = &queue->buckets[entries[i + FX_QUEUE_PREFETCH].bucket];
+            const FXDrawPacket* next = &ahead->packets[entries[i + FX_QUEUE_PREFETCH].index];
+            __builtin_prefetch(next);
+            __builtin_prefetch(ahead->payload + next->payload_offset);
+        }
+        FXQueueBucket* bucket = &queue->buckets[entries[i].bucket];
+        const FXDrawPacket* packet = &bucket->packets[entries[i].index];
+        const FXDrawCall* draw = &packet->draw;
+        FXShader* shader = draw->shader;
+        if (!shader) continue;
+
+        if (!have_program || shader->program != program) {
+            glUseProgram(shader->program);
+            program = shader->program;
+            have_program = 1;
+            fx_program_bound(shader);
+            memset(shadow, 0, sizeof(shadow));
+            stats->program_binds++;
+        }
+
+        int same_layout = layout_shader && fx_vertex_layout_equal(&layout_shader->layout, &shader->layout);
+        if (!have_vertex_array || !same_layout || draw->vertex_buffer != vertex_buffer ||
+            draw->index_buffer != index_buffer) {
+            fx_bind_vertex_buffers(shader, draw->vertex_buffer, draw->index_buffer);
+            layout_shader = shader;
+            vertex_buffer = draw->vertex_buffer;
+            index_buffer = draw->index_buffer;
+            have_vertex_array = 1;
+            stats->vertex_array_binds++;
+        }
+
+        const unsigned char* cursor = bucket->payload + packet->payload_offset;
+        const unsigned char* end = cursor + packet->payload_size;
+        while (cursor < end) {
+            FXUniformCommand command;
+            memcpy(&command, cursor, sizeof(command));
+            const unsigned char* data = cursor + sizeof(command);
+            size_t bytes = command.float_count * sizeof(float);
+            cursor = data + bytes;
+
+            int tracked = command.location < FX_QUEUE_SHADOW_LOCATIONS;
+            if (tracked && shadow[command.location] && memcmp(shadow[command.location], data, bytes) == 0) {
+                stats->uniforms_skipped++;
+                continue;
+            }
+            float values[16];
+            copy_floats(values, data, command.float_count);
+            apply_uniform(&command, values);
+            if (tracked) shadow[command.location] = data;
+            stats->uniform_sets++;
+        }
+
+        if (draw->index_buffer && draw->base_vertex) {
+            glDrawElementsBaseVertex(draw->mode, draw->count, draw->index_type, (const void*)draw->first,
+                                     draw->base_vertex);
+        } else if (draw->index_buffer) {
+            glDrawElements(draw->mode, draw->count, draw->index_type, (const void*)draw->first);
+        } else {
+            glDrawArrays(draw->mode, (GLint)draw->first, draw->count);
+        }
+        stats->draws++;
+    }
+}
+
+void fx_queue_submit(FXRenderQueue* queue, FXQueueStats* stats) {
+    FXQueueStats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (!queue) return;
+
+    uint32_t count = 0;
+    for (int b = 0; b < queue->bucket_count; b++) count += queue->buckets[b].count;
+    if (count > queue->entry_capacity) {
+        FXSortEntry* entries = (FXSortEntry*)realloc(queue->entries, count * sizeof(FXSortEntry));
+        FXSortEntry* scratch = (FXSortEntry*)realloc(queue->scratch, count * sizeof(FXSortEntry));
+        if (entries) queue->entries = entries;
+        if (scratch) queue->scratch = scratch;
+        if (!entries || !scratch) return;
+        queue->entry_capacity = count;
+    }
+
+    uint64_t start = fx_time_ns();
+    uint32_t n = 0;
+    for (int b = 0; b < queue->bucket_count; b++) {
+        for (uint32_t i = 0; i < queue->buckets[b].count; i++, n++) {
+            queue->entries[n].key = queue->buckets[b].packets[i].key;
+            queue->entries[n].bucket = (uint32_t)b;
+            queue->entries[n].index = i;
+        }
+    }
+    const FXSortEntry* sorted = count ? radix_sort(queue->entries, queue->scratch, count) : queue->entries;
+    stats->sort_ns = fx_time_ns() - start;
+
+    replay(queue, sorted, count, stats);
+    FX_STAT_ADD(uniform_uploads, stats->uniform_sets);
+    if (fx_gpu_timing_enabled) fx_gpu_timing_end();    // Idle time after the last draw is nobody's
+    stats->replay_ns = fx_time_ns() - start - stats->sort_ns;
+
+    for (int b = 0; b < queue->bucket_count; b++) {
+        queue->buckets[b].count = 0;
+        queue->buckets[b].payload_size = 0;
+    }
+}
@@ -0,0 +1,351 @@
+/*
+ * FX Reflection Format Implementation
+ * Builds, validates and searches binary .meta blobs
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_reflect.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* g_type_names[] = {
+    "?", "float", "vec2", "vec3", "vec4", "mat4", "sampler2D", "samplerCube",
+};
+
+unsigned int fx_hash_name(const char* name) {
+    unsigned int hash = 2166136261u;
+    for (const unsigned char* c = (const unsigned char*)name; *c; c++) {
+        hash ^= *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+FXReflectType fx_reflect_type(const char* type_name) {
+    for (int i = 1; i < (int)(sizeof(g_type_names) / sizeof(g_type_names[0])); i++) {
+        if (strcmp(g_type_names[i], type_name) == 0) return (FXReflectType)i;
+    }
+    return FX_TYPE_UNKNOWN;
+}
+
+const char* fx_reflect_type_name(FXReflectType type) {
+    if ((int)type < 0 || (int)type >= (int)(sizeof(g_type_names) / sizeof(g_type_names[0]))) return "?";
+    return g_type_names[type];
+}
+
+static const char* g_format_names[FX_FORMAT_COUNT] = {
+    "float", "half", "snorm16", "unorm16", "snorm8", "unorm8", "snorm10_10_10_2", "unorm10_10_10_2",
+};
+
+int fx_reflect_components(FXReflectType type) {
+    switch (type) {
+        case FX_TYPE_FLOAT: return 1;
+        case FX_TYPE_VEC2:  return 2;
+        case FX_TYPE_VEC3:  return 3;
+        case FX_TYPE_VEC4:  return 4;
+        case FX_TYPE_MAT4:  return 16;
+        default:            return 0;
+    }
+}
+
+int fx_reflect_format(const char* format_name) {
+    for (int i = 0; i < FX_FORMAT_COUNT; i++) {
+        if (strcmp(g_format_names[i], format_name) == 0) return i;
+    }
+    return -1;
+}
+
+const char* fx_reflect_format_name(FXVertexFormat format) {
+    if ((int)format < 0 || format >= FX_FORMAT_COUNT) return "?";
+    return g_format_names[format];
+}
+
+unsigned int fx_reflect_attrib_size(FXReflectType type, FXVertexFormat format) {
+    int components = fx_reflect_components(type);
+    if (!components) return 0;
+    if (format == FX_FORMAT_FLOAT) return (unsigned int)components * 4;
+    if (type == FX_TYPE_MAT4) return 0;     // Matrices stay float
+
+    unsigned int size = 0;
+    switch (format) {
+        case FX_FORMAT_HALF:
+        case FX_FORMAT_SNORM16:
+        case FX_FORMAT_UNORM16: size = (unsigned int)components * 2; break;
+        case FX_FORMAT_SNORM8:
+        case FX_FORMAT_UNORM8:  size = (unsigned int)components; break;
+        case FX_FORMAT_SNORM10_10_10_2:
+        case FX_FORMAT_UNORM10_10_10_2:
+            if (components < 3) return 0;
+            size = 4;
+            break;
+        default: return 0;
+    }
+    return (size + 3) & ~3u;
+}
+
+static int is_sampler(FXReflectType type) {
+    return type == FX_TYPE_SAMPLER2D || type == FX_TYPE_SAMPLERCUBE;
+}
+
+// Size and std140 base alignment of one element
+static void type_layout(FXReflectType type, uint32_t* size, uint32_t* align) {
+    switch (type) {
+        case FX_TYPE_FLOAT: *size = 4;  *align = 4;  break;
+        case FX_TYPE_VEC2:  *size = 8;  *align = 8;  break;
+        case FX_TYPE_VEC3:  *size = 12; *align = 16; break;
+        case FX_TYPE_VEC4:  *size = 16; *align = 16; break;
+        case FX_TYPE_MAT4:  *size = 64; *align = 16; break;
+        default:            *size = 0;  *align = 1;  break;
+    }
+}
+
+// Appends s to the string table and returns its offset
+static uint32_t add_string(char* table, uint32_t* cursor, const char* s) {
+    uint32_t offset = *cursor;
+    size_t length = strlen(s) + 1;
+    memcpy(table + offset, s, length);
+    *cursor += (uint32_t)length;
+    return offset;
+}
+
+void* fx_reflect_build(const char* shader_name, const char* source_path, uint32_t flags,
+                       const FXReflectEntry* uniforms, int uniform_count,
+                       const FXReflectEntry* inputs, int input_count, size_t* size) {
+    // String table: leading empty string, then every name in record order
+    size_t strings_size = 1 + strlen(shader_name ? shader_name : "") + 1;
+    if (source_path) strings_size += strlen(source_path) + 1;
+    for (int i = 0; i < uniform_count; i++) strings_size += strlen(uniforms[i].name) + 1;
+    for (int i = 0; i < input_count; i++) strings_size += strlen(inputs[i].name) + 1;
+
+    size_t records = sizeof(FXReflectHeader);
+    size_t strings = records + (size_t)(uniform_count + input_count) * sizeof(FXReflectRecord);
+    size_t total = strings + strings_size;
+    unsigned char* blob = (unsigned char*)calloc(1, total);
+    if (!blob) return NULL;
+
+    FXReflectHeader* header = (FXReflectHeader*)blob;
+    header->magic = FX_REFLECT_MAGIC;
+    header->version = FX_REFLECT_VERSION;
+    header->record_size = sizeof(FXReflectRecord);
+    header->size = (uint32_t)total;
+    header->flags = flags;
+    header->uniform_count = (uint32_t)uniform_count;
+    header->input_count = (uint32_t)input_count;
+    header->records = (uint32_t)records;
+    header->strings = (uint32_t)strings;
+    header->strings_size = (uint32_t)strings_size;
+
+    char* table = (char*)blob + strings;
+    uint32_t cursor = 1;
+
+    header->shader_name = add_string(table, &cursor, shader_name ? shader_name : "");
+    header->source_path = source_path ? add_string(table, &cursor, source_path) : 0;
+
+    FXReflectRecord* record = (FXReflectRecord*)(blob + records);
+    uint32_t offset = 0;
+    int32_t unit = 0;
+    uint32_t draw_offset = 0;
+    for (int i = 0; i < uniform_count; i++, record++) {
+        FXReflectType type = fx_reflect_type(uniforms[i].type);
+        record->name_hash = fx_hash_name(uniforms[i].name);
+        record->name = add_string(table, &cursor, uniforms[i].name);
+        record->type = (uint8_t)type;
+        record->array_size = 1;
+        record->location = (flags & FX_REFLECT_ASSIGNED) ? i : -1;
+        record->binding = -1;
+        if (is_sampler(type)) {
+            // Samplers live outside any block; each gets the next unit
+            record->binding = unit++;
+        } else if (uniforms[i].divisor) {
+            // Per-draw values: members of FXDrawData in the draw buffer on
+            // gl43, plain uniforms on gl33
+            uint32_t type_size, align;
+            type_layout(type, &type_size, &align);
+            draw_offset = (draw_offset + align - 1) & ~(align - 1);
+            record->offset = draw_offset;
+            record->divisor = 1;
+            if (flags & FX_REFLECT_GL43) record->location = -1;
+            draw_offset += type_size;
+        } else {
+            uint32_t type_size, align;
+            type_layout(type, &type_size, &align);
+            offset = (offset + align - 1) & ~(align - 1);
+            record->offset = offset;
+            offset += type_size;
+        }
+    }
+
+    // Inputs pack tightly, in declaration order, as one interleaved vertex;
+    // instance inputs the same way in a stream of their own
+    offset = 0;
+    uint32_t instance_offset = 0;
+    int32_t slot = 0;
+    for (int i = 0; i < input_count; i++, record++) {
+        FXReflectType type = fx_reflect_type(inputs[i].type);
+        int format = inputs[i].format ? fx_reflect_format(inputs[i].format) : FX_FORMAT_FLOAT;
+        if (format < 0 || !fx_reflect_attrib_size(type, (FXVertexFormat)format)) format = FX_FORMAT_FLOAT;
+        uint32_t type_size = fx_reflect_attrib_size(type, (FXVertexFormat)format);
+        record->name_hash = fx_hash_name(inputs[i].name);
+        record->name = add_string(table, &cursor, inputs[i].name);
+        record->type = (uint8_t)type;
+        record->format = (uint8_t)format;
+        record->array_size = 1;
+        record->location = (flags & FX_REFLECT_ASSIGNED) ? slot : -1;
+        record->binding = i;
+        if (inputs[i].divisor) {
+            record->divisor = 1;
+            record->offset = instance_offset;
+            instance_offset += type_size;
+        } else {
+            record->offset = offset;
+            offset += type_size;
+        }
+        slot += type == FX_TYPE_MAT4 ? 4 : 1;
+    }
+
+    if (size) *size = total;
+    return blob;
+}
+
+uint32_t fx_reflect_draw_stride(const FXReflectHeader* header) {
+    if (!header) return 0;
+    const FXReflectRecord* uniforms = fx_reflect_uniforms((FXReflectHeader*)header);
+    uint32_t size = 0, struct_align = 1;
+    for (uint32_t i = 0; i < header->uniform_count; i++) {
+        if (!uniforms[i].divisor) continue;
+        uint32_t type_size, align;
+        type_layout((FXReflectType)uniforms[i].type, &type_size, &align);
+        if (uniforms[i].offset + type_size > size) size = uniforms[i].offset + type_size;
+        if (align > struct_align) struct_align = align;
+    }
+    return (size + struct_align - 1) & ~(struct_align - 1);
+}
+
+// Splits the next whitespace-separated word off *cursor, terminating it in place
+static char* next_word(char** cursor) {
+    char* c = *cursor;
+    while (*c == ' ' || *c == '\t' || *c == '\r') c++;
+    if (!*c) return NULL;
+    char* word = c;
+    while (*c && *c != ' ' && *c != '\t' && *c != '\r') c++;
+    if (*c) *c++ = '\0';
+    *cursor = c;
+    return word;
+}
+
+void* fx_reflect_parse_text(const char* text, size_t length, size_t* size) {
+    // Work on a terminated copy that the entries can point into
+    char* copy = (char*)malloc(length + 1);
+    if (!copy) return NULL;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+
+    int uniform_capacity = 0, input_capacity = 0;
+    for (const char* line = copy; line; line = strchr(line, '\n')) {
+        if (*line == '\n') line++;
+        if (strncmp(line, "uniform ", 8) == 0 || strncmp(line, "per_draw ", 9) == 0) uniform_capacity++;
+        else if (strncmp(line, "input ", 6) == 0 || strncmp(line, "instance ", 9) == 0) input_capacity++;
+    }
+
+    FXReflectEntry* uniforms = (FXReflectEntry*)calloc(uniform_capacity + 1, sizeof(FXReflectEntry));
+    FXReflectEntry* inputs = (FXReflectEntry*)calloc(input_capacity + 1, sizeof(FXReflectEntry));
+    int uniform_count = 0, input_count = 0;
+    const char* shader_name = NULL;
+    const char* source_path = NULL;
+    uint32_t flags = 0;
+    void* blob = NULL;
+    if (!uniforms || !inputs) goto done;
+
+    char* line = copy;
+    while (line) {
+        char* end = strchr(line, '\n');
+        if (end) *end = '\0';
+        char* cursor = line;
+        char* key = next_word(&cursor);
+        if (key && (strcmp(key, "uniform") == 0 || strcmp(key, "per_draw") == 0) &&
+            uniform_count < uniform_capacity) {
+            uniforms[uniform_count].divisor = strcmp(key, "per_draw") == 0;
+            uniforms[uniform_count].type = next_word(&cursor);
+            uniforms[uniform_count].name = next_word(&cursor);
+            if (uniforms[uniform_count].name) uniform_count++;
+        } else if (key && (strcmp(key, "input") == 0 || strcmp(key, "instance") == 0) &&
+                   input_count < input_capacity) {
+            inputs[input_count].divisor = strcmp(key, "instance") == 0;
+            inputs[input_count].type = next_word(&cursor);
+            inputs[input_count].name = next_word(&cursor);
+            inputs[input_count].format = next_word(&cursor);
+            if (inputs[input_count].name) input_count++;
+        } else if (key && strcmp(key, "target") == 0) {
+            // Only fxc output that names its target has assigned locations
+            const char* target = next_word(&cursor);
+            if (target && strcmp(target, "gl33") == 0) flags = FX_REFLECT_ASSIGNED;
+            if (target && strcmp(target, "gl43") == 0) flags = FX_REFLECT_ASSIGNED | FX_REFLECT_GL43;
+        } else if (key && strcmp(key, "shader") == 0) {
+            shader_name = next_word(&cursor);
+        } else if (key && strcmp(key, "source") == 0) {
+            // Paths may contain spaces: take the rest of the line
+            while (*cursor == ' ') cursor++;
+            char* cr = strchr(cursor, '\r');
+            if (cr) *cr = '\0';
+            source_path = *cursor ? cursor : NULL;
+        }
+        line = end ? end + 1 : NULL;
+    }
+    blob = fx_reflect_build(shader_name, source_path, flags, uniforms, uniform_count, inputs, input_count, size);
+
+done:
+    free(uniforms);
+    free(inputs);
+    free(copy);
+    return blob;
+}
+
+FXReflectHeader* fx_reflect_validate(void* data, size_t size) {
+    if (!data || size < sizeof(FXReflectHeader)) return NULL;
+    FXReflectHeader* header = (FXReflectHeader*)data;
+    if (header->magic != FX_REFLECT_MAGIC || header->version != FX_REFLECT_VERSION) return NULL;
+    if (header->record_size != sizeof(FXReflectRecord) || header->size > size) return NULL;
+
+    uint64_t record_count = (uint64_t)header->uniform_count + header->input_count;
+    uint64_t records_end = header->records + record_count * sizeof(FXReflectRecord);
+    if (header->records < sizeof(FXReflectHeader) || records_end > header->strings) return NULL;
+    if ((uint64_t)header->strings + header->strings_size > header->size) return NULL;
+
+    // Every string must start inside the table, and the table must end in a
+    // terminator, so no lookup can run off the end
+    const char* table = (const char*)data + header->strings;
+    if (header->strings_size == 0 || table[header->strings_size - 1] != '\0') return NULL;
+    if (header->shader_name >= header->strings_size || header->source_path >= header->strings_size) return NULL;
+    const FXReflectRecord* records = (const FXReflectRecord*)((const char*)data + header->records);
+    for (uint64_t i = 0; i < record_count; i++) {
+        if (records[i].name >= header->strings_size || records[i].format >= FX_FORMAT_COUNT ||
+            records[i].divisor > 1) return NULL;
+    }
+    return header;
+}
+
+const char* fx_reflect_string(const FXReflectHeader* header, uint32_t offset) {
+    return (const char*)header + header->strings + offset;
+}
+
+FXReflectRecord* fx_reflect_uniforms(FXReflectHeader* header) {
+    return (FXReflectRecord*)((char*)header + header->records);
+}
+
+FXReflectRecord* fx_reflect_inputs(FXReflectHeader* header) {
+    return fx_reflect_uniforms(header) + header->uniform_count;
+}
+
+FXReflectRecord* fx_reflect_find(const FXReflectHeader* header, FXReflectRecord* records,
+                                 int count, const char* name) {
+    unsigned int hash = fx_hash_name(name);
+    for (int i = 0; i < count; i++) {
+        if (records[i].name_hash == hash && strcmp(fx_reflect_string(header, records[i].name), name) == 0) {
+            return &records[i];
+        }
+    }
+    return NULL;
+}
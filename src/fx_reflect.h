@@ -0,0 +1,140 @@
+/*
+ * FX Reflection Format
+ * Versioned binary .meta layout shared by the compiler and the runtime
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifndef FX_REFLECT_H
+#define FX_REFLECT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A .meta file is one blob, mapped by the runtime and used in place:
+//
+//   FXReflectHeader | uniform records | input records | string table
+//
+// Offsets are in bytes from the start of the blob, little-endian. String
+// offsets point into the string table, which starts with an empty string so
+// that 0 means "none". The runtime writes resolved locations straight into
+// the records of its private copy.
+
+#define FX_REFLECT_MAGIC   0x46525846u  // "FXRF"
+#define FX_REFLECT_VERSION 4
+
+// Header flags
+#define FX_REFLECT_ASSIGNED 0x1u    // fxc assigned every location and binding
+#define FX_REFLECT_GL43     0x2u    // ...and the GLSL declares them all with layout()
+
+// Shader storage binding of the per-draw buffer (FXDrawBuffer) on gl43
+#define FX_DRAW_BUFFER_BINDING 0
+
+typedef enum {
+    FX_TYPE_UNKNOWN = 0,
+    FX_TYPE_FLOAT,
+    FX_TYPE_VEC2,
+    FX_TYPE_VEC3,
+    FX_TYPE_VEC4,
+    FX_TYPE_MAT4,
+    FX_TYPE_SAMPLER2D,
+    FX_TYPE_SAMPLERCUBE,
+} FXReflectType;
+
+// Storage format of a vertex attribute, from 'packed(...)' in the .fx
+typedef enum {
+    FX_FORMAT_FLOAT = 0,            // 32-bit float per component (no annotation)
+    FX_FORMAT_HALF,                 // 16-bit float
+    FX_FORMAT_SNORM16,              // Signed short, [-1, 1]
+    FX_FORMAT_UNORM16,              // Unsigned short, [0, 1]
+    FX_FORMAT_SNORM8,               // Signed byte, [-1, 1]
+    FX_FORMAT_UNORM8,               // Unsigned byte, [0, 1]
+    FX_FORMAT_SNORM10_10_10_2,      // One 32-bit word, vec3/vec4 only
+    FX_FORMAT_UNORM10_10_10_2,
+    FX_FORMAT_COUNT
+} FXVertexFormat;
+
+typedef struct FXReflectHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;       // sizeof(FXReflectRecord) at write time
+    uint32_t size;              // Whole blob
+    uint32_t flags;             // FX_REFLECT_*
+    uint32_t uniform_count;
+    uint32_t input_count;
+    uint32_t records;           // Offset of the first uniform record; inputs follow
+    uint32_t strings;           // Offset of the string table
+    uint32_t strings_size;
+    uint32_t shader_name;       // String offset
+    uint32_t source_path;       // String offset of the .fx, 0 if unknown
+} FXReflectHeader;
+
+typedef struct FXReflectRecord {
+    uint32_t name_hash;         // fx_hash_name(name)
+    uint32_t name;              // String offset
+    uint8_t type;               // FXReflectType
+    uint8_t format;             // FXVertexFormat; inputs only
+    uint16_t array_size;        // 1 for plain variables
+    uint32_t offset;            // Uniforms: std140 offset, or std430 in FXDrawData if per-draw;
+                                // inputs: offset in an interleaved vertex
+    int32_t location;           // Assigned by fxc, else -1 until the runtime resolves it
+    int32_t binding;            // Uniforms: texture unit of a sampler; inputs: attribute index; else -1
+    uint32_t divisor;           // Inputs: 0 per vertex, 1 per instance ('instance' in the .fx);
+                                // uniforms: 1 per draw ('per_draw'), no location on gl43
+} FXReflectRecord;
+
+// Variable as the compiler sees it, e.g. { "mat4", "modelViewProj", NULL }
+typedef struct FXReflectEntry {
+    const char* type;
+    const char* name;
+    const char* format;         // packed() format of an input; NULL for float
+    int divisor;                // 1 for an 'instance' input or a 'per_draw' uniform
+} FXReflectEntry;
+
+// FNV-1a; also keys the shader registry
+unsigned int fx_hash_name(const char* name);
+
+FXReflectType fx_reflect_type(const char* type_name);
+const char* fx_reflect_type_name(FXReflectType type);
+int fx_reflect_components(FXReflectType type);     // Floats in one value: 1 for float, 16 for mat4
+
+// Returns the FXVertexFormat for a packed() name, or -1
+int fx_reflect_format(const char* format_name);
+const char* fx_reflect_format_name(FXVertexFormat format);
+
+// Bytes an input takes in an interleaved vertex, padded to 4 so every
+// attribute stays aligned; 0 if the type can't be stored in that format
+unsigned int fx_reflect_attrib_size(FXReflectType type, FXVertexFormat format);
+
+// Builds a blob with malloc(). With FX_REFLECT_ASSIGNED, uniforms get
+// locations in declaration order and inputs consecutive attribute slots (four
+// for a mat4); otherwise locations are left at -1. Per-vertex and per-instance
+// inputs are laid out as two separate interleaved streams. NULL when out of
+// memory.
+void* fx_reflect_build(const char* shader_name, const char* source_path, uint32_t flags,
+                       const FXReflectEntry* uniforms, int uniform_count,
+                       const FXReflectEntry* inputs, int input_count, size_t* size);
+
+// Bytes per draw in the per-draw buffer (std430 array stride of FXDrawData),
+// 0 if the shader has no per_draw uniforms
+uint32_t fx_reflect_draw_stride(const FXReflectHeader* header);
+
+// Builds a blob from the text form written by 'fxc --meta=text'
+void* fx_reflect_parse_text(const char* text, size_t length, size_t* size);
+
+// Checks magic, version and that every offset stays inside the blob.
+// Returns the header, or NULL if data is not a usable blob.
+FXReflectHeader* fx_reflect_validate(void* data, size_t size);
+
+// Accessors for a validated blob
+const char* fx_reflect_string(const FXReflectHeader* header, uint32_t offset);
+FXReflectRecord* fx_reflect_uniforms(FXReflectHeader* header);
+FXReflectRecord* fx_reflect_inputs(FXReflectHeader* header);
+
+// Hash-first search of count records; NULL if name is not there
+FXReflectRecord* fx_reflect_find(const FXReflectHeader* header, FXReflectRecord* records,
+                                 int count, const char* name);
+
+#endif // FX_REFLECT_H
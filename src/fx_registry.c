@@ -0,0 +1,121 @@
+/*
+ * FX Shader Runtime - Shader Registry
+ * Name-hashed table of resident shaders with reference counting
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+
+#define FX_REGISTRY_INITIAL_BUCKETS 64
+
+// Chained hash table; chains run through FXShader::next. Only touched from the
+// GL thread (fx_load, fx_poll, fx_cleanup), so there is no locking.
+static struct {
+    FXShader** buckets;
+    unsigned int bucket_count;  // Always a power of two
+    int live_shaders;
+    int live_references;
+    unsigned long long lookups;
+    unsigned long long dedup_hits;
+    unsigned long long bytes_saved;
+    unsigned int* free_slots;   // Slots of freed shaders, handed out again first
+    int free_slot_count;
+    int free_slot_capacity;
+    unsigned int next_slot;     // Slot 0 is never used
+} g_registry;
+
+static void registry_grow(void) {
+    unsigned int new_count = g_registry.bucket_count ? g_registry.bucket_count * 2 : FX_REGISTRY_INITIAL_BUCKETS;
+    FXShader** new_buckets = (FXShader**)calloc(new_count, sizeof(FXShader*));
+    if (!new_buckets) return;
+
+    for (unsigned int i = 0; i < g_registry.bucket_count; i++) {
+        FXShader* s = g_registry.buckets[i];
+        while (s) {
+            FXShader* next = s->next;
+            unsigned int b = s->name_hash & (new_count - 1);
+            s->next = new_buckets[b];
+            new_buckets[b] = s;
+            s = next;
+        }
+    }
+    free(g_registry.buckets);
+    g_registry.buckets = new_buckets;
+    g_registry.bucket_count = new_count;
+}
+
+FXShader* fx_registry_find(const char* name) {
+    if (!g_registry.bucket_count) return NULL;
+
+    unsigned int hash = fx_hash_name(name);
+    for (FXShader* s = g_registry.buckets[hash & (g_registry.bucket_count - 1)]; s; s = s->next) {
+        if (s->name_hash == hash && strcmp(s->name, name) == 0) return s;
+    }
+    return NULL;
+}
+
+FXShader* fx_registry_acquire(const char* name) {
+    g_registry.lookups++;
+    FXShader* s = fx_registry_find(name);
+    if (s) {
+        s->refcount++;
+        g_registry.live_references++;
+        g_registry.dedup_hits++;
+        g_registry.bytes_saved += s->footprint;
+    }
+    return s;
+}
+
+void fx_registry_insert(FXShader* shader) {
+    shader->name_hash = fx_hash_name(shader->name);
+    shader->slot = g_registry.free_slot_count ? g_registry.free_slots[--g_registry.free_slot_count]
+                                              : ++g_registry.next_slot;
+    shader->refcount = 1;
+    g_registry.live_references++;
+
+    if ((unsigned int)g_registry.live_shaders >= g_registry.bucket_count) {
+        registry_grow();
+        if (!g_registry.bucket_count) return;   // Still usable, just not shared
+    }
+    unsigned int b = shader->name_hash & (g_registry.bucket_count - 1);
+    shader->next = g_registry.buckets[b];
+    g_registry.buckets[b] = shader;
+    g_registry.live_shaders++;
+}
+
+int fx_registry_release(FXShader* shader) {
+    g_registry.live_references--;
+    if (--shader->refcount > 0) return 0;
+
+    if (g_registry.bucket_count) {
+        FXShader** link = &g_registry.buckets[shader->name_hash & (g_registry.bucket_count - 1)];
+        while (*link && *link != shader) link = &(*link)->next;
+        if (*link) {
+            *link = shader->next;
+            g_registry.live_shaders--;
+        }
+    }
+    shader->next = NULL;
+
+    if (g_registry.free_slot_count == g_registry.free_slot_capacity) {
+        int capacity = g_registry.free_slot_capacity ? g_registry.free_slot_capacity * 2 : 64;
+        unsigned int* slots = (unsigned int*)realloc(g_registry.free_slots, capacity * sizeof(unsigned int));
+        if (!slots) return 1;   // The slot is just not reused
+        g_registry.free_slots = slots;
+        g_registry.free_slot_capacity = capacity;
+    }
+    g_registry.free_slots[g_registry.free_slot_count++] = shader->slot;
+    return 1;
+}
+
+void fx_registry_stats(FXRegistryStats* stats) {
+    if (!stats) return;
+    stats->live_shaders = g_registry.live_shaders;
+    stats->live_references = g_registry.live_references;
+    stats->lookups = g_registry.lookups;
+    stats->dedup_hits = g_registry.dedup_hits;
+    stats->bytes_saved = g_registry.bytes_saved;
+}
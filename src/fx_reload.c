@@ -0,0 +1,393 @@
+/*
+ * FX Shader Runtime - Live Reload
+ * inotify watcher over the files behind each loaded shader, swapped in by fx_poll()
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifdef __linux__
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "fx_internal.h"
+#include "fx_platform.h"
+
+int fx_reload_pending = 0;
+
+#ifdef __linux__
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+
+#define FX_RELOAD_DEFAULT_DEBOUNCE_MS 150
+#define FX_RELOAD_MAX_FILES 4   // .vert.glsl, .frag.glsl, .meta, .fx
+
+typedef struct {
+    int dir;        // Index into g_reload.dirs
+    char* base;     // File name inside that directory
+} FXWatchFile;
+
+typedef struct FXWatchEntry {
+    char* shader_name;
+    char* source_path;
+    char* source_shader;    // Program name inside the .fx
+    FXCTarget target;       // What an edited .fx is recompiled for, from the metadata
+    FXWatchFile files[FX_RELOAD_MAX_FILES];
+    int file_count;
+    int source_index;       // Which file is the .fx, -1 if none
+    uint64_t dirty_since;   // Time of the latest event, 0 when clean
+    int source_dirty;       // The .fx changed: recompile it rather than read outputs
+    struct FXWatchEntry* next;
+} FXWatchEntry;
+
+typedef struct {
+    int wd;
+    char* path;
+} FXWatchDir;
+
+// Editors tend to save by writing a temp file and renaming it over the
+// original, which kills per-file watches, so we watch directories instead.
+static struct {
+    int running;
+    int inotify_fd;
+    int wake_pipe[2];
+    FXThread thread;
+    uint64_t debounce_ns;
+
+    FXMutex lock;           // Guards entries and dirs
+    FXWatchEntry* entries;
+    FXWatchDir* dirs;
+    int dir_count;
+    int dir_capacity;
+
+    FXMutex ready_lock;     // Guards the ready queue
+    FXLoadJob* ready_head;
+    FXLoadJob* ready_tail;
+} g_reload;
+
+static int watch_dir(const char* path) {
+    for (int i = 0; i < g_reload.dir_count; i++) {
+        if (strcmp(g_reload.dirs[i].path, path) == 0) return i;
+    }
+    int wd = inotify_add_watch(g_reload.inotify_fd, path, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+        fprintf(stderr, "Could not watch directory: %s\n", path);
+        return -1;
+    }
+    if (g_reload.dir_count == g_reload.dir_capacity) {
+        int capacity = g_reload.dir_capacity ? g_reload.dir_capacity * 2 : 8;
+        FXWatchDir* dirs = (FXWatchDir*)realloc(g_reload.dirs, capacity * sizeof(FXWatchDir));
+        if (!dirs) return -1;
+        g_reload.dirs = dirs;
+        g_reload.dir_capacity = capacity;
+    }
+    g_reload.dirs[g_reload.dir_count].wd = wd;
+    g_reload.dirs[g_reload.dir_count].path = strdup(path);
+    return g_reload.dir_count++;
+}
+
+static void add_file(FXWatchEntry* entry, const char* path) {
+    char dir[256];
+    const char* slash = strrchr(path, '/');
+    const char* base = slash ? slash + 1 : path;
+    if (slash) {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+        if (!dir[0]) strcpy(dir, "/");
+    } else {
+        strcpy(dir, ".");
+    }
+
+    int index = watch_dir(dir);
+    if (index < 0) return;
+    entry->files[entry->file_count].dir = index;
+    entry->files[entry->file_count].base = strdup(base);
+    entry->file_count++;
+}
+
+static void free_entry(FXWatchEntry* entry) {
+    for (int i = 0; i < entry->file_count; i++) free(entry->files[i].base);
+    free(entry->shader_name);
+    free(entry->source_path);
+    free(entry->source_shader);
+    free(entry);
+}
+
+static void mark_dirty(const struct inotify_event* event, uint64_t now) {
+    int dir = -1;
+    for (int i = 0; i < g_reload.dir_count; i++) {
+        if (g_reload.dirs[i].wd == event->wd) { dir = i; break; }
+    }
+    if (dir < 0) return;
+
+    for (FXWatchEntry* e = g_reload.entries; e; e = e->next) {
+        for (int i = 0; i < e->file_count; i++) {
+            if (e->files[i].dir == dir && strcmp(e->files[i].base, event->name) == 0) {
+                e->dirty_since = now;
+                if (i == e->source_index) e->source_dirty = 1;
+            }
+        }
+    }
+}
+
+// Reads the shader's outputs, or recompiles its .fx when source_path is set
+static void reload_shader(const char* shader_name, const char* source_path, const char* source_shader,
+                          FXCTarget target) {
+    FXLoadJob* job = fx_load_job_create(shader_name);
+    if (!job) return;
+    job->target = target;
+    int ok = source_path ? fx_load_job_compile_file(job, source_path, source_shader, NULL, 0)
+                         : fx_load_job_read(job);
+    if (!ok) {
+        fx_load_job_free(job);
+        return;
+    }
+
+    fx_mutex_lock(&g_reload.ready_lock);
+    if (g_reload.ready_tail) g_reload.ready_tail->next = job;
+    else g_reload.ready_head = job;
+    g_reload.ready_tail = job;
+    fx_atomic_add(&fx_reload_pending, 1);
+    fx_mutex_unlock(&g_reload.ready_lock);
+}
+
+static void watcher_main(void* arg) {
+    (void)arg;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+        // Sleep until an event arrives or the earliest debounce window closes
+        int timeout = -1;
+        uint64_t now = fx_time_ns();
+        fx_mutex_lock(&g_reload.lock);
+        for (FXWatchEntry* e = g_reload.entries; e; e = e->next) {
+            if (!e->dirty_since) continue;
+            uint64_t due = e->dirty_since + g_reload.debounce_ns;
+            int ms = due > now ? (int)((due - now) / 1000000) + 1 : 0;
+            if (timeout < 0 || ms < timeout) timeout = ms;
+        }
+        fx_mutex_unlock(&g_reload.lock);
+
+        struct pollfd fds[2] = {
+            { g_reload.inotify_fd, POLLIN, 0 },
+            { g_reload.wake_pipe[0], POLLIN, 0 },
+        };
+        if (poll(fds, 2, timeout) < 0) continue;
+        if (fds[1].revents) return;
+
+        now = fx_time_ns();
+        if (fds[0].revents & POLLIN) {
+            ssize_t length = read(g_reload.inotify_fd, buffer, sizeof(buffer));
+            fx_mutex_lock(&g_reload.lock);
+            for (ssize_t offset = 0; offset < length;) {
+                const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+                if (event->len) mark_dirty(event, now);
+                offset += sizeof(struct inotify_event) + event->len;
+            }
+            fx_mutex_unlock(&g_reload.lock);
+        }
+
+        // Pick up one settled entry at a time; the lock is not held while we
+        // compile or read files
+        for (;;) {
+            char* shader_name = NULL;
+            char* source_path = NULL;
+            char* source_shader = NULL;
+            FXCTarget target = FXC_TARGET_GL33;
+            fx_mutex_lock(&g_reload.lock);
+            for (FXWatchEntry* e = g_reload.entries; e; e = e->next) {
+                if (e->dirty_since && now - e->dirty_since >= g_reload.debounce_ns) {
+                    shader_name = strdup(e->shader_name);
+                    if (e->source_dirty && e->source_path) {
+                        source_path = strdup(e->source_path);
+                        if (e->source_shader) source_shader = strdup(e->source_shader);
+                        target = e->target;
+                    }
+                    e->dirty_since = 0;
+                    e->source_dirty = 0;
+                    break;
+                }
+            }
+            fx_mutex_unlock(&g_reload.lock);
+            if (!shader_name) break;
+
+            reload_shader(shader_name, source_path, source_shader, target);
+            free(shader_name);
+            free(source_path);
+            free(source_shader);
+        }
+    }
+}
+
+int fx_reload_init(int debounce_ms) {
+    if (g_reload.running) return 1;
+
+    g_reload.inotify_fd = inotify_init1(IN_CLOEXEC);
+    if (g_reload.inotify_fd < 0) {
+        fprintf(stderr, "Could not initialize inotify\n");
+        return 0;
+    }
+    if (pipe(g_reload.wake_pipe) != 0) {
+        close(g_reload.inotify_fd);
+        return 0;
+    }
+
+    fx_mutex_init(&g_reload.lock);
+    fx_mutex_init(&g_reload.ready_lock);
+    g_reload.debounce_ns = (uint64_t)(debounce_ms > 0 ? debounce_ms : FX_RELOAD_DEFAULT_DEBOUNCE_MS) * 1000000ull;
+
+    if (!fx_thread_start(&g_reload.thread, watcher_main, NULL)) {
+        fprintf(stderr, "Could not start the live reload thread\n");
+        close(g_reload.wake_pipe[0]);
+        close(g_reload.wake_pipe[1]);
+        close(g_reload.inotify_fd);
+        fx_mutex_destroy(&g_reload.lock);
+        fx_mutex_destroy(&g_reload.ready_lock);
+        return 0;
+    }
+
+    g_reload.running = 1;
+    return 1;
+}
+
+void fx_reload_shutdown(void) {
+    if (!g_reload.running) return;
+
+    char wake = 1;
+    if (write(g_reload.wake_pipe[1], &wake, 1) != 1) {
+        fprintf(stderr, "Could not wake the live reload thread\n");
+    }
+    fx_thread_join(g_reload.thread);
+    close(g_reload.wake_pipe[0]);
+    close(g_reload.wake_pipe[1]);
+    close(g_reload.inotify_fd);
+
+    while (g_reload.entries) {
+        FXWatchEntry* next = g_reload.entries->next;
+        free_entry(g_reload.entries);
+        g_reload.entries = next;
+    }
+    for (int i = 0; i < g_reload.dir_count; i++) free(g_reload.dirs[i].path);
+    free(g_reload.dirs);
+    g_reload.dirs = NULL;
+    g_reload.dir_count = g_reload.dir_capacity = 0;
+
+    while (g_reload.ready_head) {
+        FXLoadJob* next = g_reload.ready_head->next;
+        fx_load_job_free(g_reload.ready_head);
+        g_reload.ready_head = next;
+    }
+    g_reload.ready_tail = NULL;
+    fx_atomic_store(&fx_reload_pending, 0);
+
+    fx_mutex_destroy(&g_reload.lock);
+    fx_mutex_destroy(&g_reload.ready_lock);
+    g_reload.running = 0;
+}
+
+void fx_reload_watch(const char* shader_name, const char* source_path, const char* source_shader, FXCTarget target) {
+    if (!g_reload.running) return;
+
+    fx_mutex_lock(&g_reload.lock);
+    for (FXWatchEntry* e = g_reload.entries; e; e = e->next) {
+        if (strcmp(e->shader_name, shader_name) == 0) {
+            fx_mutex_unlock(&g_reload.lock);
+            return;
+        }
+    }
+
+    FXWatchEntry* entry = (FXWatchEntry*)calloc(1, sizeof(FXWatchEntry));
+    if (entry) {
+        char path[256];
+        entry->shader_name = strdup(shader_name);
+        entry->source_index = -1;
+        entry->target = target;
+        snprintf(path, sizeof(path), "%s.vert.glsl", shader_name);
+        add_file(entry, path);
+        snprintf(path, sizeof(path), "%s.frag.glsl", shader_name);
+        add_file(entry, path);
+        snprintf(path, sizeof(path), "%s.meta", shader_name);
+        add_file(entry, path);
+        if (source_path) {
+            entry->source_path = strdup(source_path);
+            entry->source_shader = source_shader ? strdup(source_shader) : NULL;
+            entry->source_index = entry->file_count;
+            add_file(entry, source_path);
+        }
+        entry->next = g_reload.entries;
+        g_reload.entries = entry;
+    }
+    fx_mutex_unlock(&g_reload.lock);
+}
+
+void fx_reload_unwatch(const char* shader_name) {
+    if (!g_reload.running) return;
+
+    fx_mutex_lock(&g_reload.lock);
+    for (FXWatchEntry** link = &g_reload.entries; *link; link = &(*link)->next) {
+        if (strcmp((*link)->shader_name, shader_name) == 0) {
+            FXWatchEntry* entry = *link;
+            *link = entry->next;
+            free_entry(entry);
+            break;
+        }
+    }
+    fx_mutex_unlock(&g_reload.lock);
+}
+
+// Outputs re-read from disk may come from an fxc run with another --target
+static void set_target(const char* shader_name, FXCTarget target) {
+    fx_mutex_lock(&g_reload.lock);
+    for (FXWatchEntry* e = g_reload.entries; e; e = e->next) {
+        if (strcmp(e->shader_name, shader_name) == 0) {
+            e->target = target;
+            break;
+        }
+    }
+    fx_mutex_unlock(&g_reload.lock);
+}
+
+int fx_reload_apply(void) {
+    fx_mutex_lock(&g_reload.ready_lock);
+    FXLoadJob* job = g_reload.ready_head;
+    g_reload.ready_head = g_reload.ready_tail = NULL;
+    fx_atomic_store(&fx_reload_pending, 0);
+    fx_mutex_unlock(&g_reload.ready_lock);
+
+    // Runs between frames on the GL thread, so nothing can observe a shader
+    // half swapped
+    int swapped = 0;
+    while (job) {
+        FXLoadJob* next = job->next;
+        FXShader* shader = fx_registry_find(job->name);
+        if (shader && fx_load_job_swap(job, shader)) {
+            set_target(shader->name, fx_reflection_target(&shader->reflection));
+            swapped++;
+        }
+        fx_load_job_free(job);
+        job = next;
+    }
+    return swapped;
+}
+
+#else
+
+int fx_reload_init(int debounce_ms) {
+    (void)debounce_ms;
+    fprintf(stderr, "Live reload is only available on Linux (inotify)\n");
+    return 0;
+}
+
+void fx_reload_shutdown(void) {}
+void fx_reload_watch(const char* shader_name, const char* source_path, const char* source_shader, FXCTarget target) {
+    (void)shader_name;
+    (void)source_path;
+    (void)source_shader;
+    (void)target;
+}
+void fx_reload_unwatch(const char* shader_name) { (void)shader_name; }
+int fx_reload_apply(void) { return 0; }
+
+#endif
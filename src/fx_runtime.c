@@ -7,9 +7,16 @@
  * MIT License - see LICENSE file for details
  */
 
-#include "fx_runtime.h"
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L     // strdup
+#endif
+
+#include "fx_internal.h"
+#include "fx_platform.h"
+#include "fxc.h"
 
 static char* read_file(const char* path) {
+    FX_STAT_TIMER(start);
     FILE* f = fopen(path, "rb");
     if (!f) return NULL;
     fseek(f, 0, SEEK_END);
@@ -19,16 +26,23 @@ static char* read_file(const char* path) {
     fread(data, 1, size, f);
     data[size] = '\0';
     fclose(f);
+    FX_STAT_ADD_ATOMIC(file_reads, 1);
+    FX_STAT_ADD_ATOMIC(file_read_bytes, size);
+    FX_STAT_ELAPSED_ATOMIC(file_read_ns, start);
     return data;
 }
 
 static GLuint compile_shader(const char* source, GLenum type) {
+    FX_STAT_TIMER(start);
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, NULL);
     glCompileShader(shader);
     
+    // The status query is where the driver waits for the compile
     GLint success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    FX_STAT_ADD_ATOMIC(shader_compiles, 1);
+    FX_STAT_ELAPSED_ATOMIC(compile_ns, start);
     if (!success) {
         GLchar info_log[512];
         glGetShaderInfoLog(shader, 512, NULL, info_log);
@@ -39,14 +53,26 @@ static GLuint compile_shader(const char* source, GLenum type) {
     return shader;
 }
 
-static GLuint link_program(GLuint vertex, GLuint fragment) {
+static GLuint link_program(GLuint vertex, GLuint fragment, FXReflectHeader* reflection) {
+    FX_STAT_TIMER(start);
     GLuint program = glCreateProgram();
     glAttachShader(program, vertex);
     glAttachShader(program, fragment);
+    
+    // 3.3 targets leave attribute locations to us; they have to be bound
+    // before linking to take effect
+    if (reflection && (reflection->flags & FX_REFLECT_ASSIGNED) && !(reflection->flags & FX_REFLECT_GL43)) {
+        FXReflectRecord* inputs = fx_reflect_inputs(reflection);
+        for (uint32_t i = 0; i < reflection->input_count; i++) {
+            glBindAttribLocation(program, (GLuint)inputs[i].location, fx_reflect_string(reflection, inputs[i].name));
+        }
+    }
     glLinkProgram(program);
     
     GLint success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
+    FX_STAT_ADD_ATOMIC(program_links, 1);
+    FX_STAT_ELAPSED_ATOMIC(link_ns, start);
     if (!success) {
         GLchar info_log[512];
         glGetProgramInfoLog(program, 512, NULL, info_log);
@@ -60,133 +86,447 @@ static GLuint link_program(GLuint vertex, GLuint fragment) {
     return program;
 }
 
-static void parse_metadata(const char* meta_path, FXShader* shader) {
-    char* meta_data = read_file(meta_path);
-    if (!meta_data) return;
-    
-    char* line = strtok(meta_data, "\n");
-    while (line) {
-        if (strncmp(line, "uniform ", 8) == 0) {
-            char type[32], name[64];
-            if (sscanf(line + 8, "%31s %63s", type, name) == 2) {
-                FXUniform* uniform = (FXUniform*)calloc(1, sizeof(FXUniform));
-                uniform->name = strdup(name);
-                uniform->location = glGetUniformLocation(shader->program, name);
-                uniform->next = shader->uniforms;
-                shader->uniforms = uniform;
-            }
-        } else if (strncmp(line, "input ", 6) == 0) {
-            char type[32], name[64];
-            if (sscanf(line + 6, "%31s %63s", type, name) == 2) {
-                FXInput* input = (FXInput*)calloc(1, sizeof(FXInput));
-                input->name = strdup(name);
-                input->location = glGetAttribLocation(shader->program, name);
-                input->next = shader->inputs;
-                shader->inputs = input;
+// Takes ownership of a heap blob; rejects anything that isn't a valid one
+static int adopt_reflection(FXReflection* reflection, void* blob, size_t size) {
+    reflection->header = fx_reflect_validate(blob, size);
+    if (!reflection->header) {
+        free(blob);
+        return 0;
+    }
+    reflection->size = size;
+    reflection->mapped = 0;
+    return 1;
+}
+
+// Maps the .meta and uses it in place. A text .meta (fxc --meta=text) takes
+// the slow path through a parse into a heap blob. No GL calls, so this is safe
+// to run on a loader worker thread.
+static int load_reflection(FXReflection* reflection, const char* meta_path) {
+    FX_STAT_TIMER(start);
+    size_t size = 0;
+    void* data = fx_map_file(meta_path, &size);
+    if (!data) return 0;
+    FX_STAT_ADD_ATOMIC(metadata_loads, 1);
+    
+    reflection->header = fx_reflect_validate(data, size);
+    if (reflection->header) {
+        reflection->size = size;
+        reflection->mapped = 1;
+        FX_STAT_ELAPSED_ATOMIC(metadata_ns, start);
+        return 1;
+    }
+    
+    int ok = 0;
+    if (size < 4 || memcmp(data, "FXRF", 4) != 0) {
+        size_t blob_size = 0;
+        void* blob = fx_reflect_parse_text((const char*)data, size, &blob_size);
+        ok = blob && adopt_reflection(reflection, blob, blob_size);
+    }
+    if (!ok) fprintf(stderr, "Invalid shader metadata: %s\n", meta_path);
+    fx_unmap_file(data, size);
+    FX_STAT_ELAPSED_ATOMIC(metadata_ns, start);
+    return ok;
+}
+
+// The target the metadata was compiled for, so an in-process recompile of the
+// same .fx keeps it
+FXCTarget fx_reflection_target(const FXReflection* reflection) {
+    const FXReflectHeader* header = reflection->header;
+    return header && (header->flags & FX_REFLECT_GL43) ? FXC_TARGET_GL43 : FXC_TARGET_GL33;
+}
+
+static void free_reflection(FXReflection* reflection) {
+    if (!reflection->header) return;
+    if (reflection->mapped) fx_unmap_file(reflection->header, reflection->size);
+    else free(reflection->header);
+    memset(reflection, 0, sizeof(*reflection));
+}
+
+// Points the shader's tables at the records inside its reflection blob
+static void bind_reflection(FXShader* shader) {
+    FXReflectHeader* header = shader->reflection.header;
+    shader->uniforms = header ? fx_reflect_uniforms(header) : NULL;
+    shader->uniform_count = header ? (int)header->uniform_count : 0;
+    shader->inputs = header ? fx_reflect_inputs(header) : NULL;
+    shader->input_count = header ? (int)header->input_count : 0;
+    
+    if (!fx_vertex_layout(shader, &shader->layout)) memset(&shader->layout, 0, sizeof(shader->layout));
+}
+
+// Locations fxc assigned are used as is; only metadata without them (old or
+// hand-written .meta files, or 3.3 drivers lacking explicit uniform locations)
+// falls back to asking GL.
+static void resolve_locations(GLuint program, FXReflection* reflection) {
+    FXReflectHeader* header = reflection->header;
+    if (!header) return;
+    int assigned = (header->flags & FX_REFLECT_ASSIGNED) != 0;
+    int gl43 = (header->flags & FX_REFLECT_GL43) != 0;
+    
+    FXReflectRecord* uniforms = fx_reflect_uniforms(header);
+    if (!assigned || (!gl43 && !fxgl_caps()->explicit_uniform_location)) {
+        for (uint32_t i = 0; i < header->uniform_count; i++) {
+            uniforms[i].location = glGetUniformLocation(program, fx_reflect_string(header, uniforms[i].name));
+        }
+    }
+    if (!assigned) {
+        FXReflectRecord* inputs = fx_reflect_inputs(header);
+        for (uint32_t i = 0; i < header->input_count; i++) {
+            inputs[i].location = glGetAttribLocation(program, fx_reflect_string(header, inputs[i].name));
+        }
+    }
+    
+    // 4.3 code declares sampler units with layout(binding); 3.3 needs them set
+    if (!gl43 && fxgl_caps()->separate_programs) {
+        for (uint32_t i = 0; i < header->uniform_count; i++) {
+            if (uniforms[i].binding < 0 || uniforms[i].location < 0) continue;
+            glProgramUniform1i(program, uniforms[i].location, uniforms[i].binding);
+        }
+    } else if (!gl43) {
+        GLint current = 0;
+        int bound = 0;
+        for (uint32_t i = 0; i < header->uniform_count; i++) {
+            if (uniforms[i].binding < 0 || uniforms[i].location < 0) continue;
+            if (!bound) {
+                glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+                glUseProgram(program);
+                bound = 1;
             }
+            glUniform1i(uniforms[i].location, uniforms[i].binding);
         }
-        line = strtok(NULL, "\n");
+        if (bound) glUseProgram((GLuint)current);
     }
-    free(meta_data);
 }
 
-FXShader* fx_load(const char* shader_name) {
+FXLoadJob* fx_load_job_create(const char* shader_name) {
+    FXLoadJob* job = (FXLoadJob*)calloc(1, sizeof(FXLoadJob));
+    if (!job) return NULL;
+    job->name = strdup(shader_name);
+    return job;
+}
+
+int fx_load_job_read(FXLoadJob* job) {
     char vert_path[256], frag_path[256], meta_path[256];
-    snprintf(vert_path, sizeof(vert_path), "%s.vert.glsl", shader_name);
-    snprintf(frag_path, sizeof(frag_path), "%s.frag.glsl", shader_name);
-    snprintf(meta_path, sizeof(meta_path), "%s.meta", shader_name);
+    snprintf(vert_path, sizeof(vert_path), "%s.vert.glsl", job->name);
+    snprintf(frag_path, sizeof(frag_path), "%s.frag.glsl", job->name);
+    snprintf(meta_path, sizeof(meta_path), "%s.meta", job->name);
     
-    char* vert_source = read_file(vert_path);
-    char* frag_source = read_file(frag_path);
-    if (!vert_source || !frag_source) {
+    job->vert_source = read_file(vert_path);
+    job->frag_source = read_file(frag_path);
+    if (!job->vert_source || !job->frag_source) {
         fprintf(stderr, "Could not load shader: %s or %s\n", vert_path, frag_path);
-        if (vert_source) free(vert_source);
-        if (frag_source) free(frag_source);
-        return NULL;
+        return 0;
     }
     
-    GLuint vertex_shader = compile_shader(vert_source, GL_VERTEX_SHADER);
-    GLuint fragment_shader = compile_shader(frag_source, GL_FRAGMENT_SHADER);
+    // The .meta is optional; without it the setters query GL directly
+    load_reflection(&job->reflection, meta_path);
+    return 1;
+}
+
+static GLuint build_program(FXLoadJob* job) {
+    if (!job->vert_source || !job->frag_source) return 0;
+    
+    // gl43 code indexes its per_draw values with gl_DrawIDARB and requires the
+    // extension; without it the link fails with nothing to say why
+    FXReflectHeader* header = job->reflection.header;
+    if (header && (header->flags & FX_REFLECT_GL43) && fx_reflect_draw_stride(header) &&
+        !fxgl_caps()->shader_draw_parameters) {
+        fprintf(stderr, "%s has per_draw values, which on the gl43 target need GL 4.6 or "
+                "GL_ARB_shader_draw_parameters; compile it for gl33\n", job->name);
+        return 0;
+    }
     
-    free(vert_source);
-    free(frag_source);
+    GLuint vertex_shader = compile_shader(job->vert_source, GL_VERTEX_SHADER);
+    GLuint fragment_shader = compile_shader(job->frag_source, GL_FRAGMENT_SHADER);
     
     if (!vertex_shader || !fragment_shader) {
-        return NULL;
+        // Don't leak the stage that did compile; reloads retry this often
+        if (vertex_shader) glDeleteShader(vertex_shader);
+        if (fragment_shader) glDeleteShader(fragment_shader);
+        return 0;
     }
     
-    GLuint program = link_program(vertex_shader, fragment_shader);
-    if (!program) {
-        return NULL;
+    return link_program(vertex_shader, fragment_shader, job->reflection.header);
+}
+
+int fx_load_job_compile(FXLoadJob* job, const char* src, size_t length, const char* source_path,
+                        const char* program, char* output_name, size_t output_size) {
+    FXCOptions options = {0};
+    options.source_path = source_path;
+    options.target = job->target;
+    FXCResult result;
+    FX_STAT_TIMER(start);
+    FXCStatus status = fxc_compile_source(src, length, &options, &result);
+    FX_STAT_ADD_ATOMIC(fxc_compiles, 1);
+    FX_STAT_ELAPSED_ATOMIC(fxc_ns, start);
+    if (status != FXC_OK) {
+        fprintf(stderr, "Could not compile %s: line %d: %s\n",
+                source_path ? source_path : job->name, result.error_line, result.error);
+        fxc_result_free(&result);
+        return 0;
     }
     
+    // Pick the requested program, or the first one in the file
+    const FXCShaderOutput* out = NULL;
+    for (int i = 0; i < result.shader_count && !out; i++) {
+        if (!program || strcmp(result.shaders[i].name, program) == 0) out = &result.shaders[i];
+    }
+    if (!out || !out->vertex_glsl || !out->fragment_glsl) {
+        fprintf(stderr, "No vertex + fragment program %s in %s\n",
+                program ? program : "", source_path ? source_path : job->name);
+        fxc_result_free(&result);
+        return 0;
+    }
+    
+    if (output_name && source_path) {
+        fxc_output_path(source_path, out, output_name, output_size);
+    }
+    job->vert_source = strdup(out->vertex_glsl);
+    job->frag_source = strdup(out->fragment_glsl);
+    void* blob = malloc(out->metadata_size);
+    if (blob) {
+        memcpy(blob, out->metadata, out->metadata_size);
+        adopt_reflection(&job->reflection, blob, out->metadata_size);
+    }
+    fxc_result_free(&result);
+    return job->vert_source && job->frag_source;
+}
+
+int fx_load_job_compile_file(FXLoadJob* job, const char* fx_path, const char* program,
+                             char* output_name, size_t output_size) {
+    char* src = read_file(fx_path);
+    if (!src) {
+        fprintf(stderr, "Could not load shader source: %s\n", fx_path);
+        return 0;
+    }
+    int ok = fx_load_job_compile(job, src, strlen(src), fx_path, program, output_name, output_size);
+    free(src);
+    return ok;
+}
+
+GLuint fx_load_job_build(FXLoadJob* job) {
+    GLuint program = build_program(job);
+    if (program) resolve_locations(program, &job->reflection);
+    return program;
+}
+
+FXShader* fx_load_job_adopt(FXLoadJob* job, GLuint program) {
     FXShader* shader = (FXShader*)calloc(1, sizeof(FXShader));
-    shader->name = strdup(shader_name);
+    shader->name = strdup(job->name);
+    shader->program = program;
+    
+    // The reflection blob moves into the shader
+    shader->reflection = job->reflection;
+    memset(&job->reflection, 0, sizeof(job->reflection));
+    bind_reflection(shader);
+    
+    // What a duplicate load would have cost: sources, tables and the shader
+    shader->footprint = sizeof(FXShader) + strlen(job->vert_source) + strlen(job->frag_source) +
+                        shader->reflection.size;
+    fx_registry_insert(shader);
+    FX_STAT_ADD(shader_loads, 1);
+    
+    const char* source_path = NULL;
+    const char* source_shader = NULL;
+    FXReflectHeader* header = shader->reflection.header;
+    if (header && header->source_path) {
+        source_path = fx_reflect_string(header, header->source_path);
+        source_shader = fx_reflect_string(header, header->shader_name);
+    }
+    fx_reload_watch(shader->name, source_path, source_shader, fx_reflection_target(&shader->reflection));
+    
+    return shader;
+}
+
+FXShader* fx_load_job_finish(FXLoadJob* job) {
+    GLuint program = fx_load_job_build(job);
+    return program ? fx_load_job_adopt(job, program) : NULL;
+}
+
+int fx_load_job_swap(FXLoadJob* job, FXShader* shader) {
+    GLuint program = build_program(job);
+    if (!program) {
+        fprintf(stderr, "Reload of %s failed, keeping the previous program\n", job->name);
+        return 0;
+    }
+    resolve_locations(program, &job->reflection);
+    
+    GLuint current = fx_pipeline_current_program();
+    
+    // Swap program and tables in one go; the old ones leave with the job
+    GLuint old_program = shader->program;
+    FXReflection old_reflection = shader->reflection;
     shader->program = program;
+    shader->reflection = job->reflection;
+    job->reflection = old_reflection;
+    bind_reflection(shader);
+    
+    // The tracker must not keep the old name: GL hands it out again, and a
+    // shader that gets it would have its bind skipped as redundant
+    if (current == old_program) {
+        glUseProgram(program);
+        fx_program_bound(shader);
+    }
+    glDeleteProgram(old_program);
+    FX_STAT_ADD(shader_reloads, 1);
+    return 1;
+}
+
+void fx_load_job_free(FXLoadJob* job) {
+    if (!job) return;
+    free(job->name);
+    free(job->vert_source);
+    free(job->frag_source);
+    free_reflection(&job->reflection);
+    free(job);
+}
+
+FXShader* fx_load(const char* shader_name) {
+    FXShader* shader = fx_registry_acquire(shader_name);
+    if (shader) return shader;
+    
+    FXLoadJob* job = fx_load_job_create(shader_name);
+    if (!job) return NULL;
+    
+    if (fx_load_job_read(job)) {
+        shader = fx_load_job_finish(job);
+    }
+    fx_load_job_free(job);
+    return shader;
+}
+
+FXShader* fx_load_fx(const char* fx_path) {
+    // An unnamed program lives under the path minus its extension, the same
+    // name fxc writes its files to, so this and fx_load() share one program
+    char name[256];
+    FXCShaderOutput unnamed = {0};
+    fxc_output_path(fx_path, &unnamed, name, sizeof(name));
+    FXShader* shader = fx_registry_acquire(name);
+    if (shader) return shader;
+    
+    FXLoadJob* job = fx_load_job_create(name);
+    if (!job) return NULL;
+    
+    if (fx_load_job_compile_file(job, fx_path, NULL, name, sizeof(name))) {
+        // A 'shader name {}' block gets a different name; it may be resident
+        if (strcmp(job->name, name) != 0) {
+            free(job->name);
+            job->name = strdup(name);
+            shader = fx_registry_acquire(name);
+        }
+        if (!shader) shader = fx_load_job_finish(job);
+    }
+    fx_load_job_free(job);
+    return shader;
+}
+
+FXShader* fx_load_source(const char* shader_name, const char* source, size_t length) {
+    return fx_load_source_target(shader_name, source, length, FXC_TARGET_GL33);
+}
+
+FXShader* fx_load_source_target(const char* shader_name, const char* source, size_t length, FXCTarget target) {
+    FXShader* shader = fx_registry_acquire(shader_name);
+    if (shader) return shader;
     
-    parse_metadata(meta_path, shader);
+    FXLoadJob* job = fx_load_job_create(shader_name);
+    if (!job) return NULL;
+    job->target = target;
     
+    if (fx_load_job_compile(job, source, length, NULL, NULL, NULL, 0)) {
+        shader = fx_load_job_finish(job);
+    }
+    fx_load_job_free(job);
     return shader;
 }
 
+// Hash lookup in the reflection table; shaders without a .meta fall back to GL
+static GLint uniform_location(FXShader* shader, const char* name) {
+    if (!shader->reflection.header) return glGetUniformLocation(shader->program, name);
+    FXReflectRecord* record = fx_reflect_find(shader->reflection.header, shader->uniforms,
+                                              shader->uniform_count, name);
+    return record ? record->location : -1;
+}
+
 void fx_use(FXShader* shader) {
     if (shader) {
         glUseProgram(shader->program);
+        fx_program_bound(shader);
     }
 }
 
+void fx_program_bound(FXShader* shader) {
+    FX_STAT_ADD(program_binds, 1);
+    fx_pipeline_program_changed(shader->program);
+    if (fx_gpu_timing_enabled) fx_gpu_timing_switch(shader);
+    if (fx_perf_warnings_enabled) fx_perf_warnings_shader = shader;
+}
+
+// Writes go to the shader's own program, bound or not: directly through
+// glProgramUniform* where the loader found it, otherwise by binding the
+// program for the write and putting the current one back
+static void write_uniform(FXShader* shader, FXReflectType type, GLint location, const float* v) {
+    GLuint program = shader->program;
+    if (fxgl_caps()->separate_programs) {
+        switch (type) {
+            case FX_TYPE_FLOAT: glProgramUniform1f(program, location, v[0]); break;
+            case FX_TYPE_VEC3:  glProgramUniform3f(program, location, v[0], v[1], v[2]); break;
+            case FX_TYPE_VEC4:  glProgramUniform4f(program, location, v[0], v[1], v[2], v[3]); break;
+            case FX_TYPE_MAT4:  glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, v); break;
+            default: break;
+        }
+        FX_STAT_ADD(uniform_uploads, 1);
+        return;
+    }
+    
+    // The tracked program, not a glGet: that would stall a threaded driver on
+    // every write. A raw glUseProgram needs fx_pipeline_state_reset() first.
+    GLuint current = fx_pipeline_current_program();
+    if (current != program) glUseProgram(program);
+    switch (type) {
+        case FX_TYPE_FLOAT: glUniform1f(location, v[0]); break;
+        case FX_TYPE_VEC3:  glUniform3f(location, v[0], v[1], v[2]); break;
+        case FX_TYPE_VEC4:  glUniform4f(location, v[0], v[1], v[2], v[3]); break;
+        case FX_TYPE_MAT4:  glUniformMatrix4fv(location, 1, GL_FALSE, v); break;
+        default: break;
+    }
+    if (current != program) glUseProgram(current);
+    FX_STAT_ADD(uniform_uploads, 1);
+}
+
 void fx_set_uniform_float(FXShader* shader, const char* name, float value) {
     if (!shader) return;
-    GLint location = glGetUniformLocation(shader->program, name);
-    if (location != -1) {
-        glUniform1f(location, value);
-    }
+    GLint location = uniform_location(shader, name);
+    if (location != -1) write_uniform(shader, FX_TYPE_FLOAT, location, &value);
 }
 
 void fx_set_uniform_vec3(FXShader* shader, const char* name, float x, float y, float z) {
     if (!shader) return;
-    GLint location = glGetUniformLocation(shader->program, name);
-    if (location != -1) {
-        glUniform3f(location, x, y, z);
-    }
+    GLint location = uniform_location(shader, name);
+    float v[3] = { x, y, z };
+    if (location != -1) write_uniform(shader, FX_TYPE_VEC3, location, v);
 }
 
 void fx_set_uniform_vec4(FXShader* shader, const char* name, float x, float y, float z, float w) {
     if (!shader) return;
-    GLint location = glGetUniformLocation(shader->program, name);
-    if (location != -1) {
-        glUniform4f(location, x, y, z, w);
-    }
+    GLint location = uniform_location(shader, name);
+    float v[4] = { x, y, z, w };
+    if (location != -1) write_uniform(shader, FX_TYPE_VEC4, location, v);
 }
 
 void fx_set_uniform_mat4(FXShader* shader, const char* name, const float* matrix) {
     if (!shader) return;
-    GLint location = glGetUniformLocation(shader->program, name);
-    if (location != -1) {
-        glUniformMatrix4fv(location, 1, GL_FALSE, matrix);
-    }
+    GLint location = uniform_location(shader, name);
+    if (location != -1) write_uniform(shader, FX_TYPE_MAT4, location, matrix);
 }
 
 void fx_cleanup(FXShader* shader) {
     if (!shader) return;
     
-    // Clean up uniforms
-    FXUniform* u = shader->uniforms;
-    while (u) {
-        FXUniform* next = u->next;
-        free((void*)u->name);
-        free(u);
-        u = next;
-    }
+    // Other owners still hold references to this program
+    if (!fx_registry_release(shader)) return;
+    fx_reload_unwatch(shader->name);
+    if (fx_perf_warnings_shader == shader) fx_perf_warnings_shader = NULL;
     
-    // Clean up inputs
-    FXInput* i = shader->inputs;
-    while (i) {
-        FXInput* next = i->next;
-        free((void*)i->name);
-        free(i);
-        i = next;
-    }
+    free_reflection(&shader->reflection);
     
     glDeleteProgram(shader->program);
     free((void*)shader->name);
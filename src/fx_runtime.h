@@ -11,45 +11,392 @@
 #define FX_RUNTIME_H
 
 #include "fx_gl.h"
+#include "fx_reflect.h"
+#include "fxc.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct FXUniform {
-    const char* name;
-    GLint location;
-    GLenum type;
-    struct FXUniform* next;
-} FXUniform;
+// A .meta blob: mapped from disk, or built in memory when compiling .fx text
+typedef struct FXReflection {
+    FXReflectHeader* header;    // NULL when the shader has no metadata
+    size_t size;
+    int mapped;                 // Unmap rather than free
+} FXReflection;
 
-typedef struct FXInput {
-    const char* name;
-    GLint location;
+#define FX_MAX_VERTEX_ATTRIBS 16
+
+typedef struct FXVertexAttrib {
+    GLuint location;
+    GLint components;
     GLenum type;
-    struct FXInput* next;
-} FXInput;
+    GLboolean normalized;
+    GLuint offset;
+    GLuint divisor;             // 1 for 'instance' inputs, read from the instance buffer
+} FXVertexAttrib;
+
+// One interleaved vertex: the shader's inputs in declaration order, each in
+// its packed() format. Instance inputs interleave the same way in a second
+// stream of instance_stride bytes per instance.
+typedef struct FXVertexLayout {
+    unsigned int hash;          // Over locations, formats and offsets only
+    GLsizei stride;
+    GLsizei instance_stride;    // 0 when the shader has no instance inputs
+    int attrib_count;
+    FXVertexAttrib attribs[FX_MAX_VERTEX_ATTRIBS];
+} FXVertexLayout;
 
 typedef struct FXShader {
     const char* name;
     GLuint program;
-    FXUniform* uniforms;
-    FXInput* inputs;
-    struct FXShader* next;
+    FXReflectRecord* uniforms;  // Records inside the reflection blob, with
+    int uniform_count;          // locations resolved at load
+    FXReflectRecord* inputs;
+    int input_count;
+    FXReflection reflection;
+    FXVertexLayout layout;      // Of the inputs, worked out at load
+    struct FXShader* next;      // Registry hash chain
+    unsigned int name_hash;
+    unsigned int slot;          // Small registry index, reused once the shader is
+                                // freed; fx_sort_key() keys on it, not on the program
+    int refcount;               // fx_load() references; program dies at zero
+    size_t footprint;           // Estimated bytes one copy of this shader costs
 } FXShader;
 
+typedef struct FXRegistryStats {
+    int live_shaders;               // Distinct programs in the registry
+    int live_references;            // Sum of all refcounts
+    unsigned long long lookups;     // fx_load()/fx_load_async() requests
+    unsigned long long dedup_hits;  // Requests served by an existing program
+    unsigned long long bytes_saved; // Estimated memory not spent on duplicates
+} FXRegistryStats;
+
+typedef struct FXVertexCacheStats {
+    int vertex_arrays;              // VAOs alive in the cache
+    unsigned long long hits;        // Binds served by an existing VAO
+    unsigned long long misses;      // VAOs created
+    size_t instance_buffer_bytes;   // Current size of the shared instance buffer
+    unsigned long long instance_uploads;
+} FXVertexCacheStats;
+
+// One draw as recorded into a render queue
+typedef struct FXDrawCall {
+    FXShader* shader;
+    GLuint vertex_buffer;
+    GLuint index_buffer;        // 0 draws with glDrawArrays
+    GLenum mode;                // GL_TRIANGLES, ...
+    GLenum index_type;          // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLsizei count;
+    size_t first;               // First vertex, or byte offset into the index buffer
+    GLint base_vertex;          // Added to every index of an indexed draw
+} FXDrawCall;
+
+typedef struct FXRenderQueue FXRenderQueue;
+
+typedef struct FXQueueStats {
+    int draws;
+    int program_binds;              // glUseProgram calls
+    int vertex_array_binds;         // fx_bind_vertex_buffers calls
+    int uniform_sets;               // glUniform* calls
+    int uniforms_skipped;           // Recorded values already current
+    unsigned long long sort_ns;
+    unsigned long long replay_ns;
+} FXQueueStats;
+
+#define FX_MAX_TEXTURE_UNITS 32    // Units above this are bound uncached
+
+typedef struct FXTextureStats {
+    unsigned long long binds;           // glBindTexture calls
+    unsigned long long binds_skipped;   // Texture already bound on its unit
+    unsigned long long unit_switches;   // glActiveTexture calls
+} FXTextureStats;
+
+typedef struct FXPipeline FXPipeline;
+
+typedef enum FXBlendMode {
+    FX_BLEND_OPAQUE,            // Blending off
+    FX_BLEND_ALPHA,             // src * a + dst * (1 - a)
+    FX_BLEND_PREMULTIPLIED,     // src + dst * (1 - a)
+    FX_BLEND_ADDITIVE           // src + dst
+} FXBlendMode;
+
+typedef enum FXDepthTest {
+    FX_DEPTH_OFF,
+    FX_DEPTH_LESS,
+    FX_DEPTH_LEQUAL,
+    FX_DEPTH_EQUAL,
+    FX_DEPTH_ALWAYS             // Test on, so depth_write still writes
+} FXDepthTest;
+
+typedef enum FXCullMode {
+    FX_CULL_NONE,
+    FX_CULL_BACK,
+    FX_CULL_FRONT
+} FXCullMode;
+
+// Zero-initialized: opaque, no depth test or writes, no culling
+typedef struct FXPipelineDesc {
+    FXShader* shader;
+    FXBlendMode blend;
+    FXDepthTest depth_test;
+    int depth_write;
+    FXCullMode cull;
+} FXPipelineDesc;
+
+typedef struct FXPipelineStats {
+    int pipelines;                      // Distinct pipelines alive
+    unsigned long long dedup_hits;      // Creates served by an existing pipeline
+    unsigned long long applies;
+    unsigned long long state_changes;   // GL calls issued by applies
+    unsigned long long changes_avoided; // State already current, no call made
+} FXPipelineStats;
+
+typedef struct FXGpuTiming {
+    const char* shader;         // Valid until GPU timing is disabled
+    int frames;                 // Frames in the window that used the shader
+    double min_ms;              // Per-frame GPU time over the window
+    double avg_ms;
+    double max_ms;
+} FXGpuTiming;
+
+// Runtime counters, one list for the struct and the JSON dump. Times are in
+// nanoseconds; file reads are .glsl and .fx sources, metadata loads the .meta
+// map and check; fxc compiles are .fx sources compiled in process; perf
+// warnings are driver performance messages, repeats included.
+#define FX_STATS_COUNTERS(X) \
+    X(program_binds)        \
+    X(uniform_uploads)      \
+    X(shader_loads)         \
+    X(shader_reloads)       \
+    X(shader_compiles)      \
+    X(compile_ns)           \
+    X(program_links)        \
+    X(link_ns)              \
+    X(fxc_compiles)         \
+    X(fxc_ns)               \
+    X(metadata_loads)       \
+    X(metadata_ns)          \
+    X(file_reads)           \
+    X(file_read_bytes)      \
+    X(file_read_ns)         \
+    X(perf_warnings)
+
+typedef struct FXStatsCounters {
+#define FX_STATS_FIELD(name) uint64_t name;
+    FX_STATS_COUNTERS(FX_STATS_FIELD)
+#undef FX_STATS_FIELD
+} FXStatsCounters;
+
+typedef struct FXStats {
+    FXStatsCounters frame;          // The last frame closed by fx_stats_frame()
+    FXStatsCounters total;          // Since startup, including the open frame
+    uint64_t frames;
+} FXStats;
+
+typedef struct FXPerfWarning {
+    unsigned int id;                // The driver's message ID
+    const char* shader;             // Bound by the runtime when reported, "" if none
+    const char* message;            // As first reported
+    unsigned long long count;       // Reports of this ID while this shader was bound
+} FXPerfWarning;
+
+typedef struct FXDrawBatch FXDrawBatch;
+
+typedef struct FXBatchStats {
+    int draws;
+    int groups;                     // Distinct (program, buffers, mode) sets
+    int multi_draws;                // glMultiDraw*Indirect calls
+    int single_draws;               // Draws of shaders without a gl43 draw buffer
+} FXBatchStats;
+
+// Called on the GL thread from fx_poll(); shader is NULL if the load failed
+typedef void (*FXLoadCallback)(FXShader* shader, void* user);
+
 // Core functions
 FXShader* fx_load(const char* shader_name);
+FXShader* fx_load_fx(const char* fx_path);      // Compiles the .fx in process, no fxc run
+FXShader* fx_load_source(const char* shader_name, const char* source, size_t length);   // gl33
+FXShader* fx_load_source_target(const char* shader_name, const char* source, size_t length, FXCTarget target);
 void fx_use(FXShader* shader);
+// Setters write to the shader's program whether or not it is bound; the
+// current program is left as it was. Before GL 4.1 that is the program the
+// runtime last bound, so call fx_pipeline_state_reset() after a raw
+// glUseProgram.
 void fx_set_uniform_float(FXShader* shader, const char* name, float value);
 void fx_set_uniform_vec3(FXShader* shader, const char* name, float x, float y, float z);
 void fx_set_uniform_vec4(FXShader* shader, const char* name, float x, float y, float z, float w);
 void fx_set_uniform_mat4(FXShader* shader, const char* name, const float* matrix);
 void fx_cleanup(FXShader* shader);
 
-// Helper functions
-static char* read_file(const char* path);
-static GLuint compile_shader(const char* source, GLenum type);
-static GLuint link_program(GLuint vertex, GLuint fragment);
-static void parse_metadata(const char* meta_path, FXShader* shader);
+// Asynchronous loading
+// File reads and metadata parsing run on a worker pool; compile and link are
+// queued back to the GL thread and drained by fx_poll() under a time budget.
+// fx_load_async() starts the pool with defaults if fx_async_init() was not called.
+int fx_async_init(int worker_count, double budget_ms);
+void fx_async_shutdown(void);
+void fx_load_async(const char* shader_name, FXLoadCallback callback, void* user);
+int fx_poll(void);
+
+// Background compilation (opt-in)
+// A thread with its own context, sharing objects with the one current on the
+// calling thread, takes over compile and link for fx_load_async(); fx_poll()
+// hands each program over once a fence says the compile thread is done with
+// it, without ever waiting. Needs EGL with surfaceless contexts; returns 0
+// (loads keep compiling in fx_poll()) where that is missing. Loads in flight
+// at stop are finished on the GL thread and still call back.
+int fx_compile_thread_start(void);
+void fx_compile_thread_stop(void);
+
+// Shader registry
+// Loads are deduplicated by name: every fx_load() of a resident shader returns
+// the same FXShader with its refcount bumped. GL thread only.
+void fx_registry_stats(FXRegistryStats* stats);
+
+// Vertex layouts
+// fx_bind_vertex_buffers() binds a VAO for the shader's input layout over one
+// interleaved vertex buffer (and optional index buffer), creating it on first
+// use. VAOs are cached per (layout, buffers), so shaders with the same inputs
+// share them and a rebind is one glBindVertexArray. Call
+// fx_release_vertex_buffer() before deleting a buffer. GL thread only.
+//
+// Shaders with 'instance' inputs read them from one instance buffer the
+// runtime owns: fx_bind_instances() streams instance_count instances of
+// instance_stride bytes into it (growing it as needed) and binds the VAO, so a
+// batch is then a single glDrawElementsInstanced/glDrawArraysInstanced.
+int fx_vertex_layout(const FXShader* shader, FXVertexLayout* layout);
+GLuint fx_bind_vertex_buffers(FXShader* shader, GLuint vertex_buffer, GLuint index_buffer);
+GLuint fx_bind_instances(FXShader* shader, GLuint vertex_buffer, GLuint index_buffer,
+                         const void* instances, int instance_count);
+void fx_release_vertex_buffer(GLuint buffer);
+void fx_vertex_cache_clear(void);
+void fx_vertex_cache_stats(FXVertexCacheStats* stats);
+
+// Textures
+// fxc gives every sampler a fixed texture unit in declaration order and
+// stores it in the .meta (layout(binding) on gl43, set once at load on gl33),
+// so binding a texture never touches uniforms. fx_texture_handle() resolves a
+// sampler name once (0 if the shader has no such sampler); the handle stays
+// valid across reloads. fx_bind_texture() binds to the sampler's unit as
+// GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP, skipping the glActiveTexture and
+// glBindTexture calls whose state is already current. Call
+// fx_release_texture() before deleting a texture, and fx_texture_cache_reset()
+// after binding textures by hand. GL thread only.
+unsigned int fx_texture_handle(FXShader* shader, const char* name);
+int fx_texture_unit(FXShader* shader, unsigned int handle);
+void fx_bind_texture(FXShader* shader, unsigned int handle, GLuint texture);
+void fx_release_texture(GLuint texture);
+void fx_texture_cache_reset(void);
+void fx_texture_cache_stats(FXTextureStats* stats);
+
+// Pipeline state objects
+// An immutable bundle of a shader and its fixed-function state. Creating one
+// that matches a live pipeline returns that pipeline with a new reference.
+// fx_pipeline_apply() diffs against the state earlier applies (and fx_use(),
+// queues and batches, for the program) left behind and issues only the GL
+// calls that change something. Call fx_pipeline_state_reset() after touching
+// the program, blend, depth or cull state by hand, and release a shader's pipelines before
+// its last fx_cleanup(). The stats are cumulative; read them and call
+// fx_pipeline_stats_reset() once a frame for per-frame figures. GL thread only.
+FXPipeline* fx_pipeline_create(const FXPipelineDesc* desc);
+void fx_pipeline_release(FXPipeline* pipeline);
+const FXPipelineDesc* fx_pipeline_desc(const FXPipeline* pipeline);
+void fx_pipeline_apply(const FXPipeline* pipeline);
+void fx_pipeline_state_reset(void);
+void fx_pipeline_stats(FXPipelineStats* stats);
+void fx_pipeline_stats_reset(void);
+
+// GPU timing (opt-in)
+// While enabled, every program bind the runtime makes (fx_use(), pipeline
+// applies, queue and batch submits) ends the open GL_TIME_ELAPSED query and
+// starts one for the new shader, so each interval covers one shader's draws.
+// An interval also ends at fx_gpu_timing_end(), at the end of a queue or
+// batch submit, and at fx_gpu_timing_frame(), which is called once per frame.
+// Query objects cycle through a ring and are read back 3 frames later; results
+// not ready by then are dropped, so timing never stalls the pipeline.
+// fx_gpu_timings() reports each shader's per-frame GPU time over the last 64
+// frames it was used in, and returns how many shaders have results (more than
+// max_timings means the list was cut). GL thread only.
+int fx_gpu_timing_enable(int enable);
+void fx_gpu_timing_frame(void);
+void fx_gpu_timing_end(void);
+int fx_gpu_timings(FXGpuTiming* timings, int max_timings);
+
+// Driver performance warnings (opt-in, KHR_debug or GL 4.3)
+// Installs a debug callback that keeps only GL_DEBUG_TYPE_PERFORMANCE
+// messages: shader recompiles on state changes, buffer stalls, fallbacks to
+// slow paths. Output is made synchronous, so each message is attributed to
+// the shader the runtime last bound (fx_use(), pipelines, queues, batches).
+// Every report counts in the perf_warnings stat; fx_perf_warnings() lists
+// them once per message ID and shader, with a count, and returns how many
+// there are. Enabling returns 0 where the driver has no KHR_debug; disabling
+// forgets the list and puts back the callback and the output and synchronous
+// enables as enabling found them. Where debug output was already on, the
+// app's callback keeps getting every message and its filters are kept, with
+// performance messages switched on (and left on); where it was off, the
+// filters go back to the KHR_debug defaults. GL thread only.
+int fx_perf_warnings_enable(int enable);
+int fx_perf_warnings(FXPerfWarning* warnings, int max_warnings);
+
+// Statistics
+// Always compiled in unless FX_NO_STATS is defined, which removes every
+// counter and timer from the runtime (these calls then report zeros). Counting
+// is a plain add on the GL thread and a relaxed atomic add for work that runs
+// on loader threads. fx_stats_frame() closes a frame; call it once per frame.
+// fx_stats_json() writes the stats as one JSON object and returns its length,
+// like snprintf (a return >= size means the buffer was too small).
+void fx_stats_get(FXStats* stats);
+void fx_stats_frame(void);
+int fx_stats_json(char* buffer, size_t size);
+
+// Render queue
+// Draws are recorded with a 64-bit sort key into one bucket per recording
+// thread (thread is 0..thread_count-1, one index per thread), so recording
+// from several threads needs no locks. Uniform calls attach to the thread's
+// last draw and are resolved through the shader's .meta; shaders without one
+// can't take queued uniforms. fx_queue_submit() runs on the GL thread once
+// recording is done: it radix-sorts every packet by key, replays them skipping
+// program, VAO and uniform changes that are already current, and empties the
+// queue. The key from fx_sort_key() orders by shader (16 bits of its registry
+// slot, which unlike the GL program name stays put across reloads), then
+// material (24 bits, e.g. a texture or buffer id), then depth in [0, 1] front
+// to back. Uniform calls whose type doesn't match the shader's are dropped.
+uint64_t fx_sort_key(const FXShader* shader, uint32_t material, float depth);
+FXRenderQueue* fx_queue_create(int thread_count);
+void fx_queue_destroy(FXRenderQueue* queue);
+void fx_queue_draw(FXRenderQueue* queue, int thread, uint64_t key, const FXDrawCall* draw);
+void fx_queue_uniform_float(FXRenderQueue* queue, int thread, const char* name, float value);
+void fx_queue_uniform_vec3(FXRenderQueue* queue, int thread, const char* name, float x, float y, float z);
+void fx_queue_uniform_vec4(FXRenderQueue* queue, int thread, const char* name, float x, float y, float z, float w);
+void fx_queue_uniform_mat4(FXRenderQueue* queue, int thread, const char* name, const float* matrix);
+void fx_queue_submit(FXRenderQueue* queue, FXQueueStats* stats);
+
+// Multi-draw batches (GL 4.3)
+// Draws are grouped by program, buffers and primitive type. For shaders
+// compiled with --target=gl43, each group becomes one glMultiDraw*Indirect
+// over a GL_DRAW_INDIRECT_BUFFER, and its per_draw values go into the
+// FXDrawData shader storage buffer, read through gl_DrawID: submission costs
+// O(groups) GL calls instead of O(draws). Other shaders fall back to one draw
+// (and one set of per_draw uniforms) each. gl43 shaders with per_draw values
+// need GL 4.6 or ARB_shader_draw_parameters and fail to load without it.
+// fx_batch_draw() returns the new draw's zeroed FXDrawData
+// (fx_reflect_draw_stride() bytes, laid out as the per_draw records' offsets
+// say), or NULL; the setters fill it by name.
+// GL thread only; submit empties the batch.
+FXDrawBatch* fx_batch_create(void);
+void fx_batch_destroy(FXDrawBatch* batch);
+void* fx_batch_draw(FXDrawBatch* batch, const FXDrawCall* draw);
+void fx_batch_set_float(FXDrawBatch* batch, const char* name, float value);
+void fx_batch_set_vec3(FXDrawBatch* batch, const char* name, float x, float y, float z);
+void fx_batch_set_vec4(FXDrawBatch* batch, const char* name, float x, float y, float z, float w);
+void fx_batch_set_mat4(FXDrawBatch* batch, const char* name, const float* matrix);
+void fx_batch_submit(FXDrawBatch* batch, FXBatchStats* stats);
+
+// Live reload (Linux inotify)
+// Shaders loaded after fx_reload_init() have their .vert.glsl, .frag.glsl, .meta
+// and source .fx watched. Edits are debounced, re-read (an edited .fx is
+// recompiled in process) on the watcher thread and swapped in by fx_poll(); a
+// failed compile keeps the previous program.
+int fx_reload_init(int debounce_ms);
+void fx_reload_shutdown(void);
 
 #endif // FX_RUNTIME_H 
\ No newline at end of file
@@ -0,0 +1,99 @@
+/*
+ * FX Shader Runtime - Statistics
+ * Per-frame and cumulative runtime counters with a JSON dump
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+#include <stdarg.h>
+
+#define FX_STATS_COUNT (sizeof(FXStatsCounters) / sizeof(uint64_t))
+
+#ifndef FX_NO_STATS
+
+// Counters only ever grow; a frame is the difference between two snapshots
+FXStatsCounters fx_stats_counters;
+
+static struct {
+    FXStatsCounters frame_start;
+    FXStatsCounters last_frame;
+    uint64_t frames;
+} g_stats;
+
+// Loader threads add to some counters while this reads them
+static void snapshot(FXStatsCounters* out) {
+    const uint64_t* from = (const uint64_t*)&fx_stats_counters;
+    uint64_t* to = (uint64_t*)out;
+    for (size_t i = 0; i < FX_STATS_COUNT; i++) to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+}
+
+void fx_stats_get(FXStats* stats) {
+    if (!stats) return;
+    snapshot(&stats->total);
+    stats->frame = g_stats.last_frame;
+    stats->frames = g_stats.frames;
+}
+
+void fx_stats_frame(void) {
+    FXStatsCounters now;
+    snapshot(&now);
+    const uint64_t* end = (const uint64_t*)&now;
+    const uint64_t* start = (const uint64_t*)&g_stats.frame_start;
+    uint64_t* frame = (uint64_t*)&g_stats.last_frame;
+    for (size_t i = 0; i < FX_STATS_COUNT; i++) frame[i] = end[i] - start[i];
+    g_stats.frame_start = now;
+    g_stats.frames++;
+}
+
+#else
+
+void fx_stats_get(FXStats* stats) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+}
+
+void fx_stats_frame(void) {
+}
+
+#endif // FX_NO_STATS
+
+// snprintf semantics over several writes: length keeps counting past the end
+typedef struct FXJsonWriter {
+    char* buffer;
+    size_t size;
+    size_t length;
+} FXJsonWriter;
+
+static void json_printf(FXJsonWriter* w, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = w->length < w->size ? vsnprintf(w->buffer + w->length, w->size - w->length, format, args)
+                                : vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (n > 0) w->length += (size_t)n;
+}
+
+static void write_counters(FXJsonWriter* w, const char* name, const FXStatsCounters* c) {
+    json_printf(w, "\"%s\":{", name);
+    const char* separator = "";
+#define FX_STATS_JSON(field) \
+    json_printf(w, "%s\"" #field "\":%llu", separator, (unsigned long long)c->field); \
+    separator = ",";
+    FX_STATS_COUNTERS(FX_STATS_JSON)
+#undef FX_STATS_JSON
+    json_printf(w, "}");
+}
+
+int fx_stats_json(char* buffer, size_t size) {
+    FXJsonWriter w = { buffer, buffer ? size : 0, 0 };
+    FXStats stats;
+    fx_stats_get(&stats);
+    json_printf(&w, "{\"frames\":%llu,", (unsigned long long)stats.frames);
+    write_counters(&w, "frame", &stats.frame);
+    json_printf(&w, ",");
+    write_counters(&w, "total", &stats.total);
+    json_printf(&w, "}");
+    return (int)w.length;
+}
@@ -0,0 +1,92 @@
+/*
+ * FX Shader Runtime - Texture Binding
+ * Sampler units from shader metadata, with a per-unit bound-texture cache
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+
+#define FX_TEXTURE_TARGETS 2    // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP
+
+// What the runtime last bound on each unit, per target. A unit's entry is only
+// trusted while its bit is set in known; nothing is known at startup or after
+// fx_texture_cache_reset(), so the first bind always reaches GL. GL thread only.
+static struct {
+    GLuint textures[FX_MAX_TEXTURE_UNITS][FX_TEXTURE_TARGETS];
+    uint32_t known[FX_TEXTURE_TARGETS];
+    GLint active_unit;          // -1 when unknown
+    FXTextureStats stats;
+} g_texture_cache = { { { 0 } }, { 0, 0 }, -1, { 0, 0, 0 } };
+
+// Samplers are found by name hash, which survives a reload that renumbers units
+static const FXReflectRecord* find_sampler(const FXShader* shader, unsigned int handle) {
+    for (int i = 0; i < shader->uniform_count; i++) {
+        const FXReflectRecord* record = &shader->uniforms[i];
+        if (record->name_hash == handle && record->binding >= 0) return record;
+    }
+    return NULL;
+}
+
+unsigned int fx_texture_handle(FXShader* shader, const char* name) {
+    if (!shader || !shader->reflection.header) return 0;
+    FXReflectRecord* record = fx_reflect_find(shader->reflection.header, shader->uniforms,
+                                              shader->uniform_count, name);
+    if (!record || record->binding < 0) return 0;
+    return record->name_hash;
+}
+
+int fx_texture_unit(FXShader* shader, unsigned int handle) {
+    if (!shader || !handle) return -1;
+    const FXReflectRecord* record = find_sampler(shader, handle);
+    return record ? record->binding : -1;
+}
+
+void fx_bind_texture(FXShader* shader, unsigned int handle, GLuint texture) {
+    if (!shader || !handle) return;
+    const FXReflectRecord* record = find_sampler(shader, handle);
+    if (!record) return;
+
+    GLint unit = record->binding;
+    int slot = record->type == FX_TYPE_SAMPLERCUBE ? 1 : 0;
+    GLenum target = slot ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    if (unit < FX_MAX_TEXTURE_UNITS) {
+        uint32_t bit = 1u << unit;
+        if ((g_texture_cache.known[slot] & bit) && g_texture_cache.textures[unit][slot] == texture) {
+            g_texture_cache.stats.binds_skipped++;
+            return;
+        }
+        g_texture_cache.textures[unit][slot] = texture;
+        g_texture_cache.known[slot] |= bit;
+    }
+
+    if (g_texture_cache.active_unit != unit) {
+        glActiveTexture(GL_TEXTURE0 + (GLenum)unit);
+        g_texture_cache.active_unit = unit;
+        g_texture_cache.stats.unit_switches++;
+    }
+    glBindTexture(target, texture);
+    g_texture_cache.stats.binds++;
+}
+
+void fx_release_texture(GLuint texture) {
+    // Deleting a bound texture rebinds 0 in GL; the name may come back from
+    // glGenTextures, so a stale entry would skip a bind that is needed
+    for (int unit = 0; unit < FX_MAX_TEXTURE_UNITS; unit++) {
+        for (int slot = 0; slot < FX_TEXTURE_TARGETS; slot++) {
+            if (g_texture_cache.textures[unit][slot] == texture) g_texture_cache.textures[unit][slot] = 0;
+        }
+    }
+}
+
+void fx_texture_cache_reset(void) {
+    g_texture_cache.known[0] = 0;
+    g_texture_cache.known[1] = 0;
+    g_texture_cache.active_unit = -1;
+}
+
+void fx_texture_cache_stats(FXTextureStats* stats) {
+    if (stats) *stats = g_texture_cache.stats;
+}
@@ -0,0 +1,193 @@
+/*
+ * FX Shader Runtime - GPU Timing
+ * Per-shader GL_TIME_ELAPSED intervals read back through a ring of query frames
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+
+#define FX_GPU_TIMING_LATENCY 3     // Frames between issuing a query and reading it
+#define FX_GPU_TIMING_SLOTS (FX_GPU_TIMING_LATENCY + 1)
+#define FX_GPU_TIMING_WINDOW 64     // Frames of history per shader
+#define FX_GPU_TIMING_NAME 64
+
+// The queries one frame issued, in order, with the shader each one timed.
+// Query objects stay with their slot and are reused every time it comes round.
+typedef struct FXTimerFrame {
+    GLuint* queries;
+    int* timers;
+    int count;
+    int capacity;
+} FXTimerFrame;
+
+typedef struct FXShaderTimer {
+    unsigned int name_hash;
+    char name[FX_GPU_TIMING_NAME];
+    uint64_t frame_ns;          // Sum of this shader's intervals in the frame being resolved
+    int used;
+    float window_ms[FX_GPU_TIMING_WINDOW];
+    int window_count;
+    int window_next;
+} FXShaderTimer;
+
+int fx_gpu_timing_enabled = 0;
+
+// GL thread only. At most one GL_TIME_ELAPSED query is open at a time.
+static struct {
+    FXTimerFrame frames[FX_GPU_TIMING_SLOTS];
+    int frame;
+    int open_timer;             // -1 when no interval is open
+    FXShaderTimer* timers;
+    int timer_count;
+    int timer_capacity;
+    int last_timer;
+} g_timing = { { { NULL, NULL, 0, 0 } }, 0, -1, NULL, 0, 0, -1 };
+
+static int find_timer(const FXShader* shader) {
+    unsigned int hash = shader->name_hash ? shader->name_hash : fx_hash_name(shader->name);
+    // Draws come in runs of one shader; the last match is usually the answer
+    if (g_timing.last_timer >= 0 && g_timing.timers[g_timing.last_timer].name_hash == hash) {
+        return g_timing.last_timer;
+    }
+    for (int i = 0; i < g_timing.timer_count; i++) {
+        if (g_timing.timers[i].name_hash == hash) return g_timing.last_timer = i;
+    }
+
+    if (g_timing.timer_count == g_timing.timer_capacity) {
+        int capacity = g_timing.timer_capacity ? g_timing.timer_capacity * 2 : 32;
+        FXShaderTimer* timers = (FXShaderTimer*)realloc(g_timing.timers, capacity * sizeof(FXShaderTimer));
+        if (!timers) return -1;
+        g_timing.timers = timers;
+        g_timing.timer_capacity = capacity;
+    }
+    FXShaderTimer* timer = &g_timing.timers[g_timing.timer_count];
+    memset(timer, 0, sizeof(*timer));
+    timer->name_hash = hash;
+    snprintf(timer->name, sizeof(timer->name), "%s", shader->name);
+    return g_timing.last_timer = g_timing.timer_count++;
+}
+
+static void begin_interval(int timer) {
+    FXTimerFrame* frame = &g_timing.frames[g_timing.frame];
+    if (frame->count == frame->capacity) {
+        int capacity = frame->capacity ? frame->capacity * 2 : 64;
+        GLuint* queries = (GLuint*)realloc(frame->queries, capacity * sizeof(GLuint));
+        if (!queries) return;
+        frame->queries = queries;
+        int* timers = (int*)realloc(frame->timers, capacity * sizeof(int));
+        if (!timers) return;
+        frame->timers = timers;
+        glGenQueries(capacity - frame->capacity, frame->queries + frame->capacity);
+        frame->capacity = capacity;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, frame->queries[frame->count]);
+    frame->timers[frame->count++] = timer;
+    g_timing.open_timer = timer;
+}
+
+void fx_gpu_timing_end(void) {
+    if (g_timing.open_timer < 0) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    g_timing.open_timer = -1;
+}
+
+void fx_gpu_timing_switch(FXShader* shader) {
+    int timer = find_timer(shader);
+    if (timer == g_timing.open_timer) return;
+    fx_gpu_timing_end();
+    if (timer >= 0) begin_interval(timer);
+}
+
+// Reads a frame issued FX_GPU_TIMING_LATENCY frames ago. Results still in
+// flight by then are dropped rather than waited for.
+static void resolve_frame(FXTimerFrame* frame) {
+    if (!frame->count) return;
+    for (int i = frame->count - 1; i >= 0; i--) {
+        GLint available = 0;
+        glGetQueryObjectiv(frame->queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            frame->count = 0;
+            return;
+        }
+    }
+
+    for (int i = 0; i < frame->count; i++) {
+        uint64_t ns = 0;
+        glGetQueryObjectui64v(frame->queries[i], GL_QUERY_RESULT, &ns);
+        FXShaderTimer* timer = &g_timing.timers[frame->timers[i]];
+        timer->frame_ns += ns;
+        timer->used = 1;
+    }
+    frame->count = 0;
+
+    for (int i = 0; i < g_timing.timer_count; i++) {
+        FXShaderTimer* timer = &g_timing.timers[i];
+        if (!timer->used) continue;
+        timer->window_ms[timer->window_next] = (float)((double)timer->frame_ns / 1e6);
+        timer->window_next = (timer->window_next + 1) % FX_GPU_TIMING_WINDOW;
+        if (timer->window_count < FX_GPU_TIMING_WINDOW) timer->window_count++;
+        timer->frame_ns = 0;
+        timer->used = 0;
+    }
+}
+
+void fx_gpu_timing_frame(void) {
+    if (!fx_gpu_timing_enabled) return;
+    fx_gpu_timing_end();
+    g_timing.frame = (g_timing.frame + 1) % FX_GPU_TIMING_SLOTS;
+    resolve_frame(&g_timing.frames[g_timing.frame]);
+}
+
+int fx_gpu_timing_enable(int enable) {
+    if (enable) {
+        // The query entry points are core slots, never NULL; the caps say
+        // whether the context behind them has GL_TIME_ELAPSED
+        if (!fxgl_caps()->timer_query) {
+            fprintf(stderr, "GPU timing needs timer queries (GL 3.3 or ARB_timer_query)\n");
+            return 0;
+        }
+        fx_gpu_timing_enabled = 1;
+        return 1;
+    }
+
+    fx_gpu_timing_end();
+    for (int i = 0; i < FX_GPU_TIMING_SLOTS; i++) {
+        FXTimerFrame* frame = &g_timing.frames[i];
+        if (frame->capacity) glDeleteQueries(frame->capacity, frame->queries);
+        free(frame->queries);
+        free(frame->timers);
+    }
+    free(g_timing.timers);
+    memset(&g_timing, 0, sizeof(g_timing));
+    g_timing.open_timer = -1;
+    g_timing.last_timer = -1;
+    fx_gpu_timing_enabled = 0;
+    return 1;
+}
+
+int fx_gpu_timings(FXGpuTiming* timings, int max_timings) {
+    int count = 0;
+    for (int i = 0; i < g_timing.timer_count; i++) {
+        const FXShaderTimer* timer = &g_timing.timers[i];
+        if (!timer->window_count) continue;
+        if (timings && count < max_timings) {
+            FXGpuTiming* t = &timings[count];
+            t->shader = timer->name;
+            t->frames = timer->window_count;
+            t->min_ms = t->max_ms = timer->window_ms[0];
+            double sum = 0.0;
+            for (int w = 0; w < timer->window_count; w++) {
+                double ms = timer->window_ms[w];
+                if (ms < t->min_ms) t->min_ms = ms;
+                if (ms > t->max_ms) t->max_ms = ms;
+                sum += ms;
+            }
+            t->avg_ms = sum / timer->window_count;
+        }
+        count++;
+    }
+    return count;
+}
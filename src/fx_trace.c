@@ -0,0 +1,616 @@
+/*
+ * FX GL Call Trace
+ * Recording shims and replay generated from the loader's entry point list
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_trace.h"
+#include "fx_platform.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FXTRACE_BUFFER_SIZE (1u << 20)
+#define FXTRACE_NULL        UINT64_MAX      // Payload length of a NULL pointer
+#define FXTRACE_ALIGN(size) (((size) + 7) & ~(uint64_t)7)
+
+// Walking an entry's parameter or argument list. FXTRACE_IS_VOID(params) is
+// 1 for (void), which has no arguments to walk, and 0 otherwise.
+#define FXTRACE_CAT(a, b) FXTRACE_CAT_(a, b)
+#define FXTRACE_CAT_(a, b) a##b
+#define FXTRACE_UNPAREN(...) __VA_ARGS__
+#define FXTRACE_HEAD(...) FXTRACE_HEAD_(__VA_ARGS__, ~)
+#define FXTRACE_HEAD_(first, ...) first
+#define FXTRACE_REST(...) FXTRACE_REST_(__VA_ARGS__)
+#define FXTRACE_REST_(first, ...) __VA_ARGS__
+#define FXTRACE_SECOND(...) FXTRACE_SECOND_(__VA_ARGS__)
+#define FXTRACE_SECOND_(first, second, ...) second
+#define FXTRACE_VOID_void ~, 1
+#define FXTRACE_IS_VOID(params) FXTRACE_SECOND(FXTRACE_CAT(FXTRACE_VOID_, FXTRACE_HEAD params), 0, ~)
+
+#define FXTRACE_COUNT(...) FXTRACE_COUNT_(__VA_ARGS__, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, ~)
+#define FXTRACE_COUNT_(x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, n, ...) n
+#define FXTRACE_EACH(m, ...) FXTRACE_CAT(FXTRACE_EACH_, FXTRACE_COUNT(__VA_ARGS__))(m, __VA_ARGS__)
+#define FXTRACE_EACH_1(m, x) m(x)
+#define FXTRACE_EACH_2(m, x, ...) m(x) FXTRACE_EACH_1(m, __VA_ARGS__)
+#define FXTRACE_EACH_3(m, x, ...) m(x) FXTRACE_EACH_2(m, __VA_ARGS__)
+#define FXTRACE_EACH_4(m, x, ...) m(x) FXTRACE_EACH_3(m, __VA_ARGS__)
+#define FXTRACE_EACH_5(m, x, ...) m(x) FXTRACE_EACH_4(m, __VA_ARGS__)
+#define FXTRACE_EACH_6(m, x, ...) m(x) FXTRACE_EACH_5(m, __VA_ARGS__)
+#define FXTRACE_EACH_7(m, x, ...) m(x) FXTRACE_EACH_6(m, __VA_ARGS__)
+#define FXTRACE_EACH_8(m, x, ...) m(x) FXTRACE_EACH_7(m, __VA_ARGS__)
+#define FXTRACE_EACH_9(m, x, ...) m(x) FXTRACE_EACH_8(m, __VA_ARGS__)
+#define FXTRACE_EACH_10(m, x, ...) m(x) FXTRACE_EACH_9(m, __VA_ARGS__)
+
+// An entry's arguments as a struct (FXTraceArgs_glBufferData, ...): one field
+// per parameter, named after it, plus the result. Records store it as is.
+#define FXTRACE_FIELD(decl) decl;
+#define FXTRACE_FIELDS_1(params) char none;
+#define FXTRACE_FIELDS_0(params) FXTRACE_EACH(FXTRACE_FIELD, FXTRACE_UNPAREN params)
+#define FXTRACE_ARGS_STRUCT(ret, name, params, args) \
+    typedef struct FXTraceArgs_##name { \
+        FXTRACE_CAT(FXTRACE_FIELDS_, FXTRACE_IS_VOID(params))(params) \
+        FXGL_VOID_##ret(, ret result;) \
+    } FXTraceArgs_##name;
+FXGL_ENTRY_POINTS(FXTRACE_ARGS_STRUCT)
+#undef FXTRACE_ARGS_STRUCT
+
+static const uint32_t g_args_sizes[FXGL_TRACE_OP_COUNT] = {
+#define FXTRACE_ARGS_SIZE(ret, name, params, args) (uint32_t)sizeof(FXTraceArgs_##name),
+    FXGL_ENTRY_POINTS(FXTRACE_ARGS_SIZE)
+#undef FXTRACE_ARGS_SIZE
+};
+
+static const char* g_op_names[FXGL_TRACE_OP_COUNT] = {
+#define FXTRACE_OP_NAME(ret, name, params, args) #name,
+    FXGL_ENTRY_POINTS(FXTRACE_OP_NAME)
+#undef FXTRACE_OP_NAME
+};
+
+// Only one trace runs at a time, recorded by the thread that began it
+static struct {
+    FILE* file;
+    unsigned char* buffer;
+    size_t used;
+    int failed;
+    FXGLDispatch* target;       // The table the shims forward to
+    FXGLDispatch shims;
+    const void** payload_data;  // The record being written
+    uint64_t* payload_size;
+    int payload_count;
+    int payload_capacity;
+} g_trace;
+
+static void flush(void) {
+    if (g_trace.used && !g_trace.failed && fwrite(g_trace.buffer, 1, g_trace.used, g_trace.file) != g_trace.used) {
+        fprintf(stderr, "GL trace write failed; the rest of the capture is dropped\n");
+        g_trace.failed = 1;
+    }
+    g_trace.used = 0;
+}
+
+static void put(const void* data, size_t size) {
+    if (g_trace.used + size > FXTRACE_BUFFER_SIZE) flush();
+    if (size > FXTRACE_BUFFER_SIZE) {
+        if (!g_trace.failed && fwrite(data, 1, size, g_trace.file) != size) g_trace.failed = 1;
+        return;
+    }
+    memcpy(g_trace.buffer + g_trace.used, data, size);
+    g_trace.used += size;
+}
+
+static void put_padding(uint64_t size) {
+    static const unsigned char zeros[8];
+    put(zeros, (size_t)(FXTRACE_ALIGN(size) - size));
+}
+
+static void payload(const void* data, uint64_t size) {
+    if (g_trace.payload_count == g_trace.payload_capacity) {
+        int capacity = g_trace.payload_capacity ? g_trace.payload_capacity * 2 : 16;
+        const void** new_data = (const void**)realloc((void*)g_trace.payload_data, capacity * sizeof(void*));
+        if (new_data) g_trace.payload_data = new_data;
+        uint64_t* new_size = (uint64_t*)realloc(g_trace.payload_size, capacity * sizeof(uint64_t));
+        if (new_size) g_trace.payload_size = new_size;
+        if (!new_data || !new_size) return;
+        g_trace.payload_capacity = capacity;
+    }
+    g_trace.payload_data[g_trace.payload_count] = data;
+    g_trace.payload_size[g_trace.payload_count] = data ? size : FXTRACE_NULL;
+    g_trace.payload_count++;
+}
+
+static void payload_names(GLsizei n, const GLuint* names) {
+    payload(names, n > 0 ? (uint64_t)n * sizeof(GLuint) : 0);
+}
+
+static void payload_string(const char* s) {
+    payload(s, s ? strlen(s) + 1 : 0);
+}
+
+#define TRACE_ARGS(name) const FXTraceArgs_##name* a = (const FXTraceArgs_##name*)args
+
+// What each call's pointer arguments point at. Outputs (glGet*, info logs)
+// aren't kept, except the names glGen* handed out, which replay checks.
+static void capture_payloads(FXGLTraceOp op, const void* args) {
+    switch (op) {
+        case FXGL_TRACE_glGenVertexArrays: { TRACE_ARGS(glGenVertexArrays); payload_names(a->n, a->arrays); break; }
+        case FXGL_TRACE_glDeleteVertexArrays: { TRACE_ARGS(glDeleteVertexArrays); payload_names(a->n, a->arrays); break; }
+        case FXGL_TRACE_glGenBuffers: { TRACE_ARGS(glGenBuffers); payload_names(a->n, a->buffers); break; }
+        case FXGL_TRACE_glDeleteBuffers: { TRACE_ARGS(glDeleteBuffers); payload_names(a->n, a->buffers); break; }
+        case FXGL_TRACE_glGenQueries: { TRACE_ARGS(glGenQueries); payload_names(a->n, a->ids); break; }
+        case FXGL_TRACE_glDeleteQueries: { TRACE_ARGS(glDeleteQueries); payload_names(a->n, a->ids); break; }
+        case FXGL_TRACE_glBufferData: { TRACE_ARGS(glBufferData); payload(a->data, (uint64_t)a->size); break; }
+        case FXGL_TRACE_glBufferSubData: { TRACE_ARGS(glBufferSubData); payload(a->data, (uint64_t)a->size); break; }
+        case FXGL_TRACE_glShaderSource: {
+            TRACE_ARGS(glShaderSource);
+            for (GLsizei i = 0; i < a->count; i++) {
+                const char* s = a->strings[i];
+                payload(s, a->lengths && a->lengths[i] >= 0 ? (uint64_t)a->lengths[i] : strlen(s));
+            }
+            break;
+        }
+        case FXGL_TRACE_glGetUniformLocation: { TRACE_ARGS(glGetUniformLocation); payload_string(a->name); break; }
+        case FXGL_TRACE_glGetAttribLocation: { TRACE_ARGS(glGetAttribLocation); payload_string(a->name); break; }
+        case FXGL_TRACE_glBindAttribLocation: { TRACE_ARGS(glBindAttribLocation); payload_string(a->name); break; }
+        case FXGL_TRACE_glUniformMatrix4fv: {
+            TRACE_ARGS(glUniformMatrix4fv);
+            payload(a->value, a->count > 0 ? (uint64_t)a->count * 16 * sizeof(float) : 0);
+            break;
+        }
+        case FXGL_TRACE_glProgramUniformMatrix4fv: {
+            TRACE_ARGS(glProgramUniformMatrix4fv);
+            payload(a->value, a->count > 0 ? (uint64_t)a->count * 16 * sizeof(float) : 0);
+            break;
+        }
+        case FXGL_TRACE_glDebugMessageControl: { TRACE_ARGS(glDebugMessageControl); payload_names(a->count, a->ids); break; }
+        default: break;
+    }
+}
+
+static void write_record(FXGLTraceOp op, const void* args, uint32_t args_size) {
+    g_trace.payload_count = 0;
+    capture_payloads(op, args);
+
+    uint64_t size = FXTRACE_ALIGN(args_size);
+    for (int i = 0; i < g_trace.payload_count; i++) {
+        uint64_t length = g_trace.payload_size[i];
+        size += sizeof(uint64_t) + (length == FXTRACE_NULL ? 0 : FXTRACE_ALIGN(length));
+    }
+    if (size > UINT32_MAX) {
+        fprintf(stderr, "GL trace: %s call too large to record, skipped\n", g_op_names[op]);
+        return;
+    }
+
+    uint32_t header[2] = { (uint32_t)op, (uint32_t)size };
+    put(header, sizeof(header));
+    put(args, args_size);
+    put_padding(args_size);
+    for (int i = 0; i < g_trace.payload_count; i++) {
+        uint64_t length = g_trace.payload_size[i];
+        put(&length, sizeof(length));
+        if (length == FXTRACE_NULL) continue;
+        put(g_trace.payload_data[i], (size_t)length);
+        put_padding(length);
+    }
+}
+
+// The shims call the real function first, so outputs are there to record.
+// Only the thread that began the trace records: a table copied from the
+// shims for another context just forwards.
+#define FXTRACE_STORE(arg) record.arg = arg;
+#define FXTRACE_STORE_ARGS_1(args)
+#define FXTRACE_STORE_ARGS_0(args) FXTRACE_EACH(FXTRACE_STORE, FXTRACE_UNPAREN args)
+#define FXTRACE_SHIM(ret, name, params, args) \
+    static ret APIENTRY fxgl_trace_##name params { \
+        FXGL_VOID_##ret(, ret result =) g_trace.target->proc_##name args; \
+        if (fxgl_dispatch == &g_trace.shims) { \
+            FXTraceArgs_##name record; \
+            memset(&record, 0, sizeof(record)); \
+            FXTRACE_CAT(FXTRACE_STORE_ARGS_, FXTRACE_IS_VOID(params))(args) \
+            FXGL_VOID_##ret(, record.result = result;) \
+            write_record(FXGL_TRACE_##name, &record, (uint32_t)sizeof(record)); \
+        } \
+        FXGL_VOID_##ret(, return result;) \
+    }
+FXGL_ENTRY_POINTS(FXTRACE_SHIM)
+#undef FXTRACE_SHIM
+
+int fxgl_trace_begin(const char* path) {
+    if (g_trace.file) {
+        fprintf(stderr, "A GL trace is already running\n");
+        return 0;
+    }
+    // A trampoline patches the table of the thread calling it, which would
+    // put the driver's function over a shim
+    fxgl_resolve_all();
+
+    if (!g_trace.buffer) g_trace.buffer = (unsigned char*)malloc(FXTRACE_BUFFER_SIZE);
+    if (!g_trace.buffer) return 0;
+    g_trace.file = fopen(path, "wb");
+    if (!g_trace.file) {
+        fprintf(stderr, "Could not create GL trace %s\n", path);
+        return 0;
+    }
+    g_trace.used = 0;
+    g_trace.failed = 0;
+
+    FXGLTraceHeader header = { FXGL_TRACE_MAGIC, FXGL_TRACE_VERSION, (uint32_t)sizeof(void*), FXGL_TRACE_OP_COUNT };
+    put(&header, sizeof(header));
+    for (int op = 0; op < FXGL_TRACE_OP_COUNT; op++) {
+        uint32_t entry[2] = { g_args_sizes[op], (uint32_t)strlen(g_op_names[op]) };
+        put(entry, sizeof(entry));
+        put(g_op_names[op], entry[1]);
+        put_padding(entry[1]);
+    }
+
+    // Entry points this table lacks stay NULL, so callers still see them missing
+    g_trace.target = fxgl_dispatch;
+#define FXTRACE_INSTALL(ret, name, params, args) \
+    g_trace.shims.proc_##name = g_trace.target->proc_##name ? fxgl_trace_##name : NULL;
+    FXGL_ENTRY_POINTS(FXTRACE_INSTALL)
+#undef FXTRACE_INSTALL
+    g_trace.shims.caps = g_trace.target->caps;
+    fxgl_make_current(&g_trace.shims);
+    return 1;
+}
+
+void fxgl_trace_end(void) {
+    if (!g_trace.file) return;
+    if (fxgl_dispatch == &g_trace.shims) fxgl_make_current(g_trace.target);
+    flush();
+    if (fclose(g_trace.file) != 0) g_trace.failed = 1;
+    if (g_trace.failed) fprintf(stderr, "GL trace is incomplete\n");
+    g_trace.file = NULL;
+}
+
+const char* fxgl_trace_op_name(FXGLTraceOp op) {
+    return op >= 0 && op < FXGL_TRACE_OP_COUNT ? g_op_names[op] : "";
+}
+
+// Replay
+
+typedef struct FXTraceSync {
+    GLsync captured;
+    GLsync replayed;
+} FXTraceSync;
+
+typedef struct FXReplay {
+    FXGLReplayStats* stats;
+    const unsigned char* cursor;    // Payloads of the record being replayed
+    const unsigned char* end;
+    int truncated;
+    const GLuint* expected;         // Names glGen* gave out at capture
+    unsigned char* scratch;         // Outputs nothing reads
+    size_t scratch_size;
+    FXTraceSync* syncs;
+    int sync_count;
+    int sync_capacity;
+} FXReplay;
+
+static const void* next_payload(FXReplay* replay, uint64_t* size) {
+    uint64_t length;
+    *size = 0;
+    if (replay->end - replay->cursor < (ptrdiff_t)sizeof(length)) {
+        replay->truncated = 1;
+        return NULL;
+    }
+    memcpy(&length, replay->cursor, sizeof(length));
+    replay->cursor += sizeof(length);
+    if (length == FXTRACE_NULL) return NULL;
+    if (FXTRACE_ALIGN(length) > (uint64_t)(replay->end - replay->cursor)) {
+        replay->truncated = 1;
+        return NULL;
+    }
+    const void* data = replay->cursor;
+    replay->cursor += FXTRACE_ALIGN(length);
+    *size = length;
+    return data;
+}
+
+static const void* next_data(FXReplay* replay) {
+    uint64_t size;
+    return next_payload(replay, &size);
+}
+
+// One block per call; what it held before is gone
+static void* scratch(FXReplay* replay, size_t size) {
+    if (size < 64) size = 64;
+    if (size > replay->scratch_size) {
+        unsigned char* grown = (unsigned char*)realloc(replay->scratch, size);
+        if (!grown) return NULL;
+        replay->scratch = grown;
+        replay->scratch_size = size;
+    }
+    return replay->scratch;
+}
+
+static GLsync replayed_sync(FXReplay* replay, GLsync captured) {
+    for (int i = 0; i < replay->sync_count; i++) {
+        if (replay->syncs[i].captured == captured) return replay->syncs[i].replayed;
+    }
+    return NULL;
+}
+
+static void add_sync(FXReplay* replay, GLsync captured, GLsync replayed) {
+    if (replay->sync_count == replay->sync_capacity) {
+        int capacity = replay->sync_capacity ? replay->sync_capacity * 2 : 16;
+        FXTraceSync* grown = (FXTraceSync*)realloc(replay->syncs, capacity * sizeof(FXTraceSync));
+        if (!grown) return;
+        replay->syncs = grown;
+        replay->sync_capacity = capacity;
+    }
+    replay->syncs[replay->sync_count].captured = captured;
+    replay->syncs[replay->sync_count].replayed = replayed;
+    replay->sync_count++;
+}
+
+static void remove_sync(FXReplay* replay, GLsync replayed) {
+    for (int i = 0; i < replay->sync_count; i++) {
+        if (replay->syncs[i].replayed == replayed) {
+            replay->syncs[i] = replay->syncs[--replay->sync_count];
+            return;
+        }
+    }
+}
+
+#define REPLAY_ARGS(name) FXTraceArgs_##name* a = (FXTraceArgs_##name*)args
+
+static GLuint* replay_gen(FXReplay* replay, GLsizei n) {
+    replay->expected = (const GLuint*)next_data(replay);
+    return (GLuint*)scratch(replay, n > 0 ? (size_t)n * sizeof(GLuint) : 0);
+}
+
+// Points the captured pointer arguments at their payloads, or at scratch
+// memory for outputs. Returns 0 if the record is cut short.
+static int replay_prepare(FXReplay* replay, FXGLTraceOp op, void* args) {
+    replay->expected = NULL;
+    switch (op) {
+        case FXGL_TRACE_glGenVertexArrays: { REPLAY_ARGS(glGenVertexArrays); a->arrays = replay_gen(replay, a->n); break; }
+        case FXGL_TRACE_glGenBuffers: { REPLAY_ARGS(glGenBuffers); a->buffers = replay_gen(replay, a->n); break; }
+        case FXGL_TRACE_glGenQueries: { REPLAY_ARGS(glGenQueries); a->ids = replay_gen(replay, a->n); break; }
+        case FXGL_TRACE_glDeleteVertexArrays: {
+            REPLAY_ARGS(glDeleteVertexArrays);
+            a->arrays = (const GLuint*)next_data(replay);
+            break;
+        }
+        case FXGL_TRACE_glDeleteBuffers: { REPLAY_ARGS(glDeleteBuffers); a->buffers = (const GLuint*)next_data(replay); break; }
+        case FXGL_TRACE_glDeleteQueries: { REPLAY_ARGS(glDeleteQueries); a->ids = (const GLuint*)next_data(replay); break; }
+        case FXGL_TRACE_glBufferData: { REPLAY_ARGS(glBufferData); a->data = next_data(replay); break; }
+        case FXGL_TRACE_glBufferSubData: { REPLAY_ARGS(glBufferSubData); a->data = next_data(replay); break; }
+        case FXGL_TRACE_glShaderSource: {
+            REPLAY_ARGS(glShaderSource);
+            size_t count = a->count > 0 ? (size_t)a->count : 0;
+            const char** strings = (const char**)scratch(replay, count * (sizeof(char*) + sizeof(GLint)));
+            if (!strings) return 0;
+            GLint* lengths = (GLint*)(strings + count);
+            for (size_t i = 0; i < count; i++) {
+                uint64_t length;
+                strings[i] = (const char*)next_payload(replay, &length);
+                lengths[i] = (GLint)length;
+            }
+            a->strings = strings;
+            a->lengths = lengths;
+            break;
+        }
+        case FXGL_TRACE_glGetShaderiv: { REPLAY_ARGS(glGetShaderiv); a->params = (GLint*)scratch(replay, 0); break; }
+        case FXGL_TRACE_glGetProgramiv: { REPLAY_ARGS(glGetProgramiv); a->params = (GLint*)scratch(replay, 0); break; }
+        case FXGL_TRACE_glGetQueryObjectiv: { REPLAY_ARGS(glGetQueryObjectiv); a->params = (GLint*)scratch(replay, 0); break; }
+        case FXGL_TRACE_glGetQueryObjectui64v: {
+            REPLAY_ARGS(glGetQueryObjectui64v);
+            a->params = (uint64_t*)scratch(replay, 0);
+            break;
+        }
+        // Enough for any pname the runtime asks for
+        case FXGL_TRACE_glGetIntegerv: { REPLAY_ARGS(glGetIntegerv); a->data = (GLint*)scratch(replay, 0); break; }
+        case FXGL_TRACE_glGetPointerv: { REPLAY_ARGS(glGetPointerv); a->params = (void**)scratch(replay, 0); break; }
+        case FXGL_TRACE_glGetShaderInfoLog: {
+            REPLAY_ARGS(glGetShaderInfoLog);
+            GLsizei* length = (GLsizei*)scratch(replay, sizeof(GLsizei) + (a->size > 0 ? (size_t)a->size : 0));
+            if (!length) return 0;
+            a->log = (char*)(length + 1);
+            if (a->length) a->length = length;
+            break;
+        }
+        case FXGL_TRACE_glGetProgramInfoLog: {
+            REPLAY_ARGS(glGetProgramInfoLog);
+            GLsizei* length = (GLsizei*)scratch(replay, sizeof(GLsizei) + (a->size > 0 ? (size_t)a->size : 0));
+            if (!length) return 0;
+            a->log = (char*)(length + 1);
+            if (a->length) a->length = length;
+            break;
+        }
+        case FXGL_TRACE_glGetUniformLocation: { REPLAY_ARGS(glGetUniformLocation); a->name = (const char*)next_data(replay); break; }
+        case FXGL_TRACE_glGetAttribLocation: { REPLAY_ARGS(glGetAttribLocation); a->name = (const char*)next_data(replay); break; }
+        case FXGL_TRACE_glBindAttribLocation: { REPLAY_ARGS(glBindAttribLocation); a->name = (const char*)next_data(replay); break; }
+        case FXGL_TRACE_glUniformMatrix4fv: { REPLAY_ARGS(glUniformMatrix4fv); a->value = (const float*)next_data(replay); break; }
+        case FXGL_TRACE_glProgramUniformMatrix4fv: {
+            REPLAY_ARGS(glProgramUniformMatrix4fv);
+            a->value = (const float*)next_data(replay);
+            break;
+        }
+        case FXGL_TRACE_glClientWaitSync: { REPLAY_ARGS(glClientWaitSync); a->sync = replayed_sync(replay, a->sync); break; }
+        case FXGL_TRACE_glDeleteSync: { REPLAY_ARGS(glDeleteSync); a->sync = replayed_sync(replay, a->sync); break; }
+        case FXGL_TRACE_glDebugMessageControl: {
+            REPLAY_ARGS(glDebugMessageControl);
+            a->ids = (const GLuint*)next_data(replay);
+            break;
+        }
+        // The captured callback lives in another process
+        case FXGL_TRACE_glDebugMessageCallback: {
+            REPLAY_ARGS(glDebugMessageCallback);
+            a->callback = NULL;
+            a->user = NULL;
+            break;
+        }
+        default: break;
+    }
+    return !replay->truncated;
+}
+
+static void check_names(FXReplay* replay, GLsizei n, const GLuint* names) {
+    if (!replay->expected || n <= 0) return;
+    if (memcmp(replay->expected, names, (size_t)n * sizeof(GLuint)) != 0) replay->stats->name_mismatches++;
+}
+
+// After the call: what the driver handed out against what it did at capture
+static void replay_check(FXReplay* replay, FXGLTraceOp op, void* args, const void* result) {
+    switch (op) {
+        case FXGL_TRACE_glGenVertexArrays: { REPLAY_ARGS(glGenVertexArrays); check_names(replay, a->n, a->arrays); break; }
+        case FXGL_TRACE_glGenBuffers: { REPLAY_ARGS(glGenBuffers); check_names(replay, a->n, a->buffers); break; }
+        case FXGL_TRACE_glGenQueries: { REPLAY_ARGS(glGenQueries); check_names(replay, a->n, a->ids); break; }
+        case FXGL_TRACE_glCreateShader: {
+            REPLAY_ARGS(glCreateShader);
+            if (*(const GLuint*)result != a->result) replay->stats->name_mismatches++;
+            break;
+        }
+        case FXGL_TRACE_glCreateProgram: {
+            REPLAY_ARGS(glCreateProgram);
+            if (*(const GLuint*)result != a->result) replay->stats->name_mismatches++;
+            break;
+        }
+        case FXGL_TRACE_glGetUniformLocation: {
+            REPLAY_ARGS(glGetUniformLocation);
+            if (*(const GLint*)result != a->result) replay->stats->name_mismatches++;
+            break;
+        }
+        case FXGL_TRACE_glGetAttribLocation: {
+            REPLAY_ARGS(glGetAttribLocation);
+            if (*(const GLint*)result != a->result) replay->stats->name_mismatches++;
+            break;
+        }
+        case FXGL_TRACE_glFenceSync: { REPLAY_ARGS(glFenceSync); add_sync(replay, a->result, *(const GLsync*)result); break; }
+        case FXGL_TRACE_glDeleteSync: { REPLAY_ARGS(glDeleteSync); remove_sync(replay, a->sync); break; }
+        default: break;
+    }
+}
+
+// One replayer per entry point: the call through this thread's table, timed
+#define FXTRACE_ARG(arg) , a->arg
+#define FXTRACE_CALL_ARGS_1(args)
+#define FXTRACE_CALL_ARGS_0(args) FXTRACE_REST(~ FXTRACE_EACH(FXTRACE_ARG, FXTRACE_UNPAREN args))
+#define FXTRACE_REPLAY(ret, name, params, args) \
+    static void replay_##name(FXReplay* replay, void* args_data) { \
+        FXTraceArgs_##name* a = (FXTraceArgs_##name*)args_data; \
+        FXGLProc_##name proc = fxgl_dispatch->proc_##name; \
+        if (!proc) { \
+            replay->stats->skipped++; \
+            return; \
+        } \
+        uint64_t start = fx_time_ns(); \
+        FXGL_VOID_##ret(, ret result =) proc(FXTRACE_CAT(FXTRACE_CALL_ARGS_, FXTRACE_IS_VOID(params))(args)); \
+        replay->stats->ns[FXGL_TRACE_##name] += fx_time_ns() - start; \
+        replay->stats->calls[FXGL_TRACE_##name]++; \
+        replay->stats->total_calls++; \
+        replay_check(replay, FXGL_TRACE_##name, a, FXGL_VOID_##ret(NULL, &result)); \
+    }
+FXGL_ENTRY_POINTS(FXTRACE_REPLAY)
+#undef FXTRACE_REPLAY
+
+typedef void (*FXTraceReplayer)(FXReplay* replay, void* args);
+static const FXTraceReplayer g_replayers[FXGL_TRACE_OP_COUNT] = {
+#define FXTRACE_REPLAYER(ret, name, params, args) replay_##name,
+    FXGL_ENTRY_POINTS(FXTRACE_REPLAYER)
+#undef FXTRACE_REPLAYER
+};
+
+// The trace's opcodes in terms of this build's: -1 for a function it lacks
+// or whose arguments have changed since the capture
+static int* read_entry_table(const unsigned char* data, size_t size, size_t* at, uint32_t count) {
+    int* ops = (int*)malloc((count ? count : 1) * sizeof(int));
+    if (!ops) return NULL;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t entry[2];
+        if (size - *at < sizeof(entry)) break;
+        memcpy(entry, data + *at, sizeof(entry));
+        *at += sizeof(entry);
+        if (FXTRACE_ALIGN(entry[1]) > size - *at) break;
+        const char* name = (const char*)data + *at;
+        *at += (size_t)FXTRACE_ALIGN(entry[1]);
+
+        ops[i] = -1;
+        for (int op = 0; op < FXGL_TRACE_OP_COUNT; op++) {
+            if (strlen(g_op_names[op]) != entry[1] || memcmp(g_op_names[op], name, entry[1]) != 0) continue;
+            if (g_args_sizes[op] == entry[0]) ops[i] = op;
+            else fprintf(stderr, "GL trace: %s has changed arguments since the capture, skipped\n", g_op_names[op]);
+            break;
+        }
+        if (i + 1 == count) return ops;
+    }
+    if (count == 0) return ops;
+    free(ops);
+    return NULL;
+}
+
+int fxgl_trace_replay(const char* path, FXGLReplayStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    size_t size = 0;
+    unsigned char* data = (unsigned char*)fx_map_file(path, &size);
+    if (!data) {
+        fprintf(stderr, "Could not open GL trace %s\n", path);
+        return 0;
+    }
+
+    FXGLTraceHeader header;
+    int* ops = NULL;
+    size_t at = sizeof(header);
+    if (size >= sizeof(header)) memcpy(&header, data, sizeof(header));
+    if (size < sizeof(header) || header.magic != FXGL_TRACE_MAGIC || header.version != FXGL_TRACE_VERSION) {
+        fprintf(stderr, "%s is not a GL trace this build can read\n", path);
+    } else if (header.pointer_size != sizeof(void*)) {
+        fprintf(stderr, "%s was captured with %u-byte pointers\n", path, header.pointer_size);
+    } else if (!(ops = read_entry_table(data, size, &at, header.entry_count))) {
+        fprintf(stderr, "%s has a damaged entry table\n", path);
+    }
+    if (!ops) {
+        fx_unmap_file(data, size);
+        return 0;
+    }
+
+    stats->timer_ns = UINT64_MAX;
+    for (int i = 0; i < 64; i++) {
+        uint64_t t = fx_time_ns();
+        uint64_t ns = fx_time_ns() - t;
+        if (ns < stats->timer_ns) stats->timer_ns = ns;
+    }
+
+    FXReplay replay;
+    memset(&replay, 0, sizeof(replay));
+    replay.stats = stats;
+    uint64_t start = fx_time_ns();
+    while (size - at >= 2 * sizeof(uint32_t)) {
+        uint32_t record[2];
+        memcpy(record, data + at, sizeof(record));
+        at += sizeof(record);
+        if (record[1] > size - at) {
+            fprintf(stderr, "GL trace %s is cut short\n", path);
+            break;
+        }
+
+        // Records are 8-byte aligned in a private mapping, so arguments are
+        // used and patched in place
+        unsigned char* args = data + at;
+        at += record[1];
+        int op = record[0] < header.entry_count ? ops[record[0]] : -1;
+        if (op < 0 || g_args_sizes[op] > record[1]) {
+            stats->skipped++;
+            continue;
+        }
+        replay.cursor = args + FXTRACE_ALIGN(g_args_sizes[op]);
+        replay.end = args + record[1];
+        replay.truncated = 0;
+        if (!replay_prepare(&replay, (FXGLTraceOp)op, args)) {
+            stats->skipped++;
+            continue;
+        }
+        g_replayers[op](&replay, args);
+    }
+    stats->total_ns = fx_time_ns() - start;
+
+    free(replay.scratch);
+    free(replay.syncs);
+    free(ops);
+    fx_unmap_file(data, size);
+    return 1;
+}
@@ -0,0 +1,72 @@
+/*
+ * FX GL Call Trace
+ * Every loaded GL call captured to a binary trace, and replayed with per-call timings
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifndef FX_TRACE_H
+#define FX_TRACE_H
+
+#include "fx_gl.h"
+
+// A trace is one file:
+//
+//   FXGLTraceHeader | entry table | call records
+//
+// The entry table names every opcode with the size of its arguments, so a
+// trace still replays after the loader's list has grown, as long as the
+// functions it uses keep their parameters. A record is its opcode and byte
+// count, the arguments as the call received them, then what its pointer
+// arguments pointed at (buffer data, sources, names, uniform arrays), each
+// as a length and the bytes. Everything is 8-byte aligned and in the byte
+// order and pointer size of the capturing machine.
+//
+// Pointer arguments that are offsets into a bound buffer (vertex attributes,
+// indices, indirect commands) are kept as they were, and so are the names of
+// objects: a fresh context on the same driver hands out the same ones.
+
+#define FXGL_TRACE_MAGIC   0x52545846u  // "FXTR"
+#define FXGL_TRACE_VERSION 1
+
+typedef struct FXGLTraceHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t pointer_size;
+    uint32_t entry_count;       // Entry table: u32 argument size, u32 name length, name, padding
+} FXGLTraceHeader;
+
+// One opcode per entry point in the loader's list
+typedef enum FXGLTraceOp {
+#define FXGL_TRACE_OP(ret, name, params, args) FXGL_TRACE_##name,
+    FXGL_ENTRY_POINTS(FXGL_TRACE_OP)
+#undef FXGL_TRACE_OP
+    FXGL_TRACE_OP_COUNT
+} FXGLTraceOp;
+
+// Capture: swaps this thread's table for one of recording shims forwarding
+// to it, so every call made through the loader on this thread is written out
+// after it returns. Calls on other threads are not captured. Returns 0 if a
+// trace is already running or the file can't be created. End it on the same
+// thread.
+int fxgl_trace_begin(const char* path);
+void fxgl_trace_end(void);
+
+typedef struct FXGLReplayStats {
+    uint64_t calls[FXGL_TRACE_OP_COUNT];
+    uint64_t ns[FXGL_TRACE_OP_COUNT];       // Spent inside the GL call
+    uint64_t total_calls;
+    uint64_t total_ns;                      // The whole replay, decoding included
+    uint64_t timer_ns;                      // Reading the clock around a call, part of each ns above
+    uint64_t skipped;                       // Calls this build or this driver lacks
+    uint64_t name_mismatches;               // Objects or locations named differently than at capture
+} FXGLReplayStats;
+
+// Replays a trace through this thread's table, back to back with no pacing.
+// Returns 0 if the file is not a trace this build can read.
+int fxgl_trace_replay(const char* path, FXGLReplayStats* stats);
+const char* fxgl_trace_op_name(FXGLTraceOp op);
+
+#endif // FX_TRACE_H
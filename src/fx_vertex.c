@@ -0,0 +1,280 @@
+/*
+ * FX Shader Runtime - Vertex Layouts
+ * Interleaved vertex layouts derived from shader inputs, with a VAO cache
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fx_internal.h"
+
+#define FX_VERTEX_CACHE_INITIAL_BUCKETS 64
+
+typedef struct FXVertexArray {
+    FXVertexLayout layout;      // Compared in full on a hash match
+    GLuint vertex_buffer;
+    GLuint index_buffer;
+    GLuint vao;
+    struct FXVertexArray* next;
+} FXVertexArray;
+
+// Chained hash table keyed by (layout, buffers). GL thread only.
+// Every VAO with instance attributes points them at the one instance buffer.
+static struct {
+    FXVertexArray** buckets;
+    unsigned int bucket_count;
+    int count;
+    GLuint instance_buffer;
+    size_t instance_capacity;
+    FXVertexCacheStats stats;
+} g_vertex_cache;
+
+static unsigned int hash_u32(unsigned int hash, unsigned int value) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (value >> (i * 8)) & 0xFF;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int array_hash(unsigned int layout_hash, GLuint vertex_buffer, GLuint index_buffer) {
+    return hash_u32(hash_u32(layout_hash, vertex_buffer), index_buffer);
+}
+
+int fx_vertex_layout(const FXShader* shader, FXVertexLayout* layout) {
+    memset(layout, 0, sizeof(*layout));
+    if (!shader) return 0;
+
+    GLuint stride = 0, instance_stride = 0;
+    for (int i = 0; i < shader->input_count; i++) {
+        const FXReflectRecord* input = &shader->inputs[i];
+        FXReflectType type = (FXReflectType)input->type;
+        FXVertexFormat format = (FXVertexFormat)input->format;
+        GLuint size = fx_reflect_attrib_size(type, format);
+        if (!size || type == FX_TYPE_SAMPLER2D || type == FX_TYPE_SAMPLERCUBE) {
+            fprintf(stderr, "Input %s of %s can't be a vertex attribute\n",
+                    fx_reflect_string(shader->reflection.header, input->name), shader->name);
+            return 0;
+        }
+        
+        int slots = type == FX_TYPE_MAT4 ? 4 : 1;   // Four vec4 columns
+        GLint components = type == FX_TYPE_MAT4 ? 4 : fx_reflect_components(type);
+        GLenum gl_type = GL_FLOAT;
+        GLboolean normalized = GL_FALSE;
+        switch (format) {
+            case FX_FORMAT_HALF:    gl_type = GL_HALF_FLOAT; break;
+            case FX_FORMAT_SNORM16: gl_type = GL_SHORT; normalized = GL_TRUE; break;
+            case FX_FORMAT_UNORM16: gl_type = GL_UNSIGNED_SHORT; normalized = GL_TRUE; break;
+            case FX_FORMAT_SNORM8:  gl_type = GL_BYTE; normalized = GL_TRUE; break;
+            case FX_FORMAT_UNORM8:  gl_type = GL_UNSIGNED_BYTE; normalized = GL_TRUE; break;
+            case FX_FORMAT_SNORM10_10_10_2:
+                // Packed types are always read as four components
+                gl_type = GL_INT_2_10_10_10_REV; normalized = GL_TRUE; components = 4;
+                break;
+            case FX_FORMAT_UNORM10_10_10_2:
+                gl_type = GL_UNSIGNED_INT_2_10_10_10_REV; normalized = GL_TRUE; components = 4;
+                break;
+            default: break;
+        }
+        
+        // Inputs the linker dropped still take their space in the vertex
+        if (input->location >= 0) {
+            for (int s = 0; s < slots; s++) {
+                if (layout->attrib_count == FX_MAX_VERTEX_ATTRIBS) {
+                    fprintf(stderr, "Too many vertex attributes in %s\n", shader->name);
+                    return 0;
+                }
+                FXVertexAttrib* attrib = &layout->attribs[layout->attrib_count++];
+                attrib->location = (GLuint)input->location + s;
+                attrib->components = components;
+                attrib->type = gl_type;
+                attrib->normalized = normalized;
+                attrib->offset = input->offset + s * size / slots;
+                attrib->divisor = input->divisor;
+            }
+        }
+        GLuint* end = input->divisor ? &instance_stride : &stride;
+        if (input->offset + size > *end) *end = input->offset + size;
+    }
+    layout->stride = (GLsizei)stride;
+    layout->instance_stride = (GLsizei)instance_stride;
+
+    // Only the interface matters: shaders whose inputs differ in name alone
+    // hash the same and share vertex arrays
+    unsigned int hash = 2166136261u;
+    hash = hash_u32(hash, (unsigned int)layout->stride);
+    hash = hash_u32(hash, (unsigned int)layout->instance_stride);
+    for (int i = 0; i < layout->attrib_count; i++) {
+        hash = hash_u32(hash, layout->attribs[i].location);
+        hash = hash_u32(hash, (unsigned int)layout->attribs[i].components);
+        hash = hash_u32(hash, layout->attribs[i].type);
+        hash = hash_u32(hash, layout->attribs[i].normalized);
+        hash = hash_u32(hash, layout->attribs[i].offset);
+        hash = hash_u32(hash, layout->attribs[i].divisor);
+    }
+    layout->hash = hash;
+    return 1;
+}
+
+int fx_vertex_layout_equal(const FXVertexLayout* a, const FXVertexLayout* b) {
+    if (a == b) return 1;
+    if (a->hash != b->hash || a->stride != b->stride || a->instance_stride != b->instance_stride ||
+        a->attrib_count != b->attrib_count) {
+        return 0;
+    }
+    for (int i = 0; i < a->attrib_count; i++) {
+        const FXVertexAttrib* x = &a->attribs[i];
+        const FXVertexAttrib* y = &b->attribs[i];
+        if (x->location != y->location || x->components != y->components || x->type != y->type ||
+            x->normalized != y->normalized || x->offset != y->offset || x->divisor != y->divisor) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void cache_grow(void) {
+    unsigned int new_count = g_vertex_cache.bucket_count ? g_vertex_cache.bucket_count * 2 : FX_VERTEX_CACHE_INITIAL_BUCKETS;
+    FXVertexArray** new_buckets = (FXVertexArray**)calloc(new_count, sizeof(FXVertexArray*));
+    if (!new_buckets) return;
+
+    for (unsigned int i = 0; i < g_vertex_cache.bucket_count; i++) {
+        FXVertexArray* a = g_vertex_cache.buckets[i];
+        while (a) {
+            FXVertexArray* next = a->next;
+            unsigned int b = array_hash(a->layout.hash, a->vertex_buffer, a->index_buffer) & (new_count - 1);
+            a->next = new_buckets[b];
+            new_buckets[b] = a;
+            a = next;
+        }
+    }
+    free(g_vertex_cache.buckets);
+    g_vertex_cache.buckets = new_buckets;
+    g_vertex_cache.bucket_count = new_count;
+}
+
+static GLuint create_vertex_array(const FXVertexLayout* layout, GLuint vertex_buffer, GLuint index_buffer) {
+    if (layout->instance_stride && !g_vertex_cache.instance_buffer) {
+        glGenBuffers(1, &g_vertex_cache.instance_buffer);
+    }
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    for (int i = 0; i < layout->attrib_count; i++) {
+        // Attributes take whichever buffer is bound to GL_ARRAY_BUFFER here
+        const FXVertexAttrib* attrib = &layout->attribs[i];
+        glBindBuffer(GL_ARRAY_BUFFER, attrib->divisor ? g_vertex_cache.instance_buffer : vertex_buffer);
+        glEnableVertexAttribArray(attrib->location);
+        glVertexAttribPointer(attrib->location, attrib->components, attrib->type, attrib->normalized,
+                              attrib->divisor ? layout->instance_stride : layout->stride,
+                              (const void*)(size_t)attrib->offset);
+        if (attrib->divisor) glVertexAttribDivisor(attrib->location, attrib->divisor);
+    }
+    // The element buffer binding is part of the VAO
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+    return vao;
+}
+
+GLuint fx_bind_vertex_buffers(FXShader* shader, GLuint vertex_buffer, GLuint index_buffer) {
+    if (!shader) return 0;
+    unsigned int hash = array_hash(shader->layout.hash, vertex_buffer, index_buffer);
+    if (g_vertex_cache.bucket_count) {
+        for (FXVertexArray* a = g_vertex_cache.buckets[hash & (g_vertex_cache.bucket_count - 1)]; a; a = a->next) {
+            if (a->vertex_buffer == vertex_buffer && a->index_buffer == index_buffer &&
+                fx_vertex_layout_equal(&a->layout, &shader->layout)) {
+                g_vertex_cache.stats.hits++;
+                glBindVertexArray(a->vao);
+                return a->vao;
+            }
+        }
+    }
+
+    FXVertexLayout layout;
+    if (!fx_vertex_layout(shader, &layout)) return 0;
+    FXVertexArray* entry = (FXVertexArray*)calloc(1, sizeof(FXVertexArray));
+    if (!entry) return 0;
+    entry->layout = layout;
+    entry->vertex_buffer = vertex_buffer;
+    entry->index_buffer = index_buffer;
+    entry->vao = create_vertex_array(&layout, vertex_buffer, index_buffer);
+    g_vertex_cache.stats.misses++;
+
+    if ((unsigned int)g_vertex_cache.count >= g_vertex_cache.bucket_count) cache_grow();
+    if (!g_vertex_cache.bucket_count) {
+        // Out of memory for the table: hand back an uncached VAO rather than fail
+        GLuint vao = entry->vao;
+        free(entry);
+        return vao;
+    }
+    unsigned int b = hash & (g_vertex_cache.bucket_count - 1);
+    entry->next = g_vertex_cache.buckets[b];
+    g_vertex_cache.buckets[b] = entry;
+    g_vertex_cache.count++;
+    g_vertex_cache.stats.vertex_arrays = g_vertex_cache.count;
+    return entry->vao;
+}
+
+GLuint fx_bind_instances(FXShader* shader, GLuint vertex_buffer, GLuint index_buffer,
+                         const void* instances, int instance_count) {
+    FXVertexLayout layout;
+    if (!fx_vertex_layout(shader, &layout)) return 0;
+    if (!layout.instance_stride) {
+        fprintf(stderr, "Shader %s has no instance inputs\n", shader->name);
+        return 0;
+    }
+    GLuint vao = fx_bind_vertex_buffers(shader, vertex_buffer, index_buffer);
+    if (!vao || instance_count <= 0) return vao;
+
+    // Orphan and refill: the driver hands back fresh storage rather than
+    // waiting on draws still reading the previous batch
+    size_t bytes = (size_t)instance_count * (size_t)layout.instance_stride;
+    if (bytes > g_vertex_cache.instance_capacity) {
+        size_t capacity = g_vertex_cache.instance_capacity ? g_vertex_cache.instance_capacity : 64 * 1024;
+        while (capacity < bytes) capacity *= 2;
+        g_vertex_cache.instance_capacity = capacity;
+        g_vertex_cache.stats.instance_buffer_bytes = capacity;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, g_vertex_cache.instance_buffer);
+    glBufferData(GL_ARRAY_BUFFER, (ptrdiff_t)g_vertex_cache.instance_capacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (ptrdiff_t)bytes, instances);
+    g_vertex_cache.stats.instance_uploads++;
+    return vao;
+}
+
+void fx_release_vertex_buffer(GLuint buffer) {
+    for (unsigned int i = 0; i < g_vertex_cache.bucket_count; i++) {
+        FXVertexArray** link = &g_vertex_cache.buckets[i];
+        while (*link) {
+            FXVertexArray* a = *link;
+            if (a->vertex_buffer == buffer || a->index_buffer == buffer) {
+                *link = a->next;
+                glDeleteVertexArrays(1, &a->vao);
+                free(a);
+                g_vertex_cache.count--;
+            } else {
+                link = &a->next;
+            }
+        }
+    }
+    g_vertex_cache.stats.vertex_arrays = g_vertex_cache.count;
+}
+
+void fx_vertex_cache_clear(void) {
+    for (unsigned int i = 0; i < g_vertex_cache.bucket_count; i++) {
+        FXVertexArray* a = g_vertex_cache.buckets[i];
+        while (a) {
+            FXVertexArray* next = a->next;
+            glDeleteVertexArrays(1, &a->vao);
+            free(a);
+            a = next;
+        }
+    }
+    free(g_vertex_cache.buckets);
+    if (g_vertex_cache.instance_buffer) glDeleteBuffers(1, &g_vertex_cache.instance_buffer);
+    memset(&g_vertex_cache, 0, sizeof(g_vertex_cache));
+}
+
+void fx_vertex_cache_stats(FXVertexCacheStats* stats) {
+    if (stats) *stats = g_vertex_cache.stats;
+}
@@ -0,0 +1,77 @@
+/*
+ * FX Shader Compiler Library (libfxc)
+ * Reentrant, in-memory .fx to GLSL compiler shared by the fxc tool and the runtime
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#ifndef FXC_H
+#define FXC_H
+
+#include <stddef.h>
+#include "fx_reflect.h"
+
+typedef enum {
+    FXC_OK = 0,
+    FXC_ERROR_INVALID_ARGUMENT,
+    FXC_ERROR_OUT_OF_MEMORY,
+    FXC_ERROR_PARSE,
+    FXC_ERROR_NO_SHADERS,
+} FXCStatus;
+
+typedef enum {
+    FXC_TARGET_GL33 = 0,        // #version 330: attribute locations are bound by the
+                                // runtime before linking, uniform locations are
+                                // declared where GL_ARB_explicit_uniform_location exists
+    FXC_TARGET_GL43,            // #version 430: every location and binding in layout()
+} FXCTarget;
+
+typedef struct FXCOptions {
+    const char* source_path;    // Recorded in the metadata for live reload; may be NULL
+    const char* name;           // Name for the unnamed vertex_shader/fragment_shader
+                                // program; defaults to the stem of source_path,
+                                // or "main" without one
+    FXCTarget target;           // fxc --target=gl33|gl43
+    int text_metadata;          // Write the .meta as readable text (fxc --meta=text)
+                                // instead of the binary fx_reflect.h blob
+} FXCOptions;
+
+// Reflection entry, e.g. { "vec3", "normal", "snorm10_10_10_2" }
+typedef FXReflectEntry FXCVariable;
+
+typedef struct FXCShaderOutput {
+    const char* name;
+    int is_named_block;         // Declared as 'shader name { ... }'
+    const char* vertex_glsl;    // NULL when the shader has no vertex stage
+    const char* fragment_glsl;  // NULL when the shader has no fragment stage
+    const char* metadata;       // Contents of the .meta file: binary unless text_metadata
+    size_t metadata_size;
+    const FXCVariable* uniforms;
+    int uniform_count;
+    const FXCVariable* inputs;
+    int input_count;
+} FXCShaderOutput;
+
+typedef struct FXCResult {
+    FXCStatus status;
+    FXCShaderOutput* shaders;
+    int shader_count;
+    int error_line;             // Position of the first error, 0 if none
+    int error_col;
+    char error[256];
+} FXCResult;
+
+// Compiles len bytes of .fx source (no terminator needed). opts may be NULL.
+// No global state, no file I/O, never exits: safe to call from any thread.
+// Always call fxc_result_free(), even on failure.
+FXCStatus fxc_compile_source(const char* src, size_t len, const FXCOptions* opts, FXCResult* result);
+void fxc_result_free(FXCResult* result);
+const char* fxc_status_str(FXCStatus status);
+
+// Base path the fxc tool writes an output to (before .vert.glsl/.frag.glsl/.meta):
+// "dir/file_name" for 'shader name {}' blocks, "dir/file" for the unnamed program.
+void fxc_output_path(const char* source_path, const FXCShaderOutput* shader, char* buffer, size_t size);
+
+#endif // FXC_H
@@ -0,0 +1,1405 @@
+/*
+ * FX Shader Compiler Library (libfxc)
+ * Lexer, parser and GLSL/metadata codegen behind fxc_compile_source()
+ * Inspired by RAD Game Tools, Casey Muratori, and Jonathan Blow
+ *
+ * Copyright (c) 2024 Giovanni Carlino
+ * MIT License - see LICENSE file for details
+ */
+
+#include "fxc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+// Debug logging. The library reports errors through FXCResult and never
+// prints on its own; this is only for tracing the parser.
+#define LOG_LEVEL 0  // 0=off, 4=debug
+#define LOG_DEBUG(fmt, ...) if (LOG_LEVEL >= 4) fprintf(stderr, "[DEBUG] " fmt "\n", ##__VA_ARGS__)
+
+// Token types
+typedef enum {
+    TOKEN_EOF,
+    TOKEN_IDENTIFIER,
+    TOKEN_NUMBER,
+    TOKEN_LBRACE,   // {
+    TOKEN_RBRACE,   // }
+    TOKEN_LPAREN,   // (
+    TOKEN_RPAREN,   // )
+    TOKEN_SEMICOLON,// ;
+    TOKEN_COMMA,    // ,
+    TOKEN_EQUAL,    // =
+    TOKEN_ASTERISK, // *
+    TOKEN_DOT,      // .
+    TOKEN_COLON,    // :
+    TOKEN_MINUS,    // -
+    TOKEN_PLUS,     // +
+    TOKEN_SLASH,    // /
+    TOKEN_LT,       // <
+    TOKEN_GT,       // >
+    TOKEN_AMPERSAND,// &
+    TOKEN_PIPE,     // |
+    TOKEN_EXCLAMATION, // !
+    // Keywords
+    TOKEN_SHADER,
+    TOKEN_UNIFORM,
+    TOKEN_INPUT,
+    TOKEN_INSTANCE,
+    TOKEN_PER_DRAW,
+    TOKEN_VOID,
+    TOKEN_OUT,
+    // New syntax keywords
+    TOKEN_VERTEX_SHADER,
+    TOKEN_FRAGMENT_SHADER,
+    // Types
+    TOKEN_FLOAT,
+    TOKEN_VEC2,
+    TOKEN_VEC3,
+    TOKEN_VEC4,
+    TOKEN_MAT4,
+    TOKEN_SAMPLER2D,
+    TOKEN_SAMPLERCUBE,
+} TokenType;
+
+// Token struct
+typedef struct {
+    TokenType type;
+    const char* text;
+    int length;
+    int line;
+    int col;
+} Token;
+
+// Lexer state
+typedef struct {
+    const char* src;
+    size_t length;
+    size_t pos;
+    int line;
+    int col;
+} Lexer;
+
+
+static void lexer_init(Lexer* lex, const char* src, size_t length) {
+    lex->src = src;
+    lex->length = length;
+    lex->pos = 0;
+    lex->line = 1;
+    lex->col = 1;
+    LOG_DEBUG("Lexer initialized with source length: %zu", length);
+}
+
+// Forward declaration
+static Token lexer_next(Lexer* lex);
+
+// Helper: print token type as string
+static const char* token_type_str(TokenType type) {
+    switch(type) {
+        case TOKEN_EOF: return "EOF";
+        case TOKEN_IDENTIFIER: return "IDENTIFIER";
+        case TOKEN_NUMBER: return "NUMBER";
+        case TOKEN_LBRACE: return "{";
+        case TOKEN_RBRACE: return "}";
+        case TOKEN_LPAREN: return "(";
+        case TOKEN_RPAREN: return ")";
+        case TOKEN_SEMICOLON: return ";";
+        case TOKEN_COMMA: return ",";
+        case TOKEN_EQUAL: return "=";
+        case TOKEN_ASTERISK: return "*";
+        case TOKEN_DOT: return ".";
+        case TOKEN_COLON: return ":";
+        case TOKEN_MINUS: return "-";
+        case TOKEN_PLUS: return "+";
+        case TOKEN_SLASH: return "/";
+        case TOKEN_LT: return "<";
+        case TOKEN_GT: return ">";
+        case TOKEN_AMPERSAND: return "&";
+        case TOKEN_PIPE: return "|";
+        case TOKEN_EXCLAMATION: return "!";
+        case TOKEN_SHADER: return "shader";
+        case TOKEN_UNIFORM: return "uniform";
+        case TOKEN_INPUT: return "input";
+        case TOKEN_INSTANCE: return "instance";
+        case TOKEN_PER_DRAW: return "per_draw";
+        case TOKEN_VOID: return "void";
+        case TOKEN_OUT: return "out";
+        case TOKEN_VERTEX_SHADER: return "vertex_shader";
+        case TOKEN_FRAGMENT_SHADER: return "fragment_shader";
+        case TOKEN_FLOAT: return "float";
+        case TOKEN_VEC2: return "vec2";
+        case TOKEN_VEC3: return "vec3";
+        case TOKEN_VEC4: return "vec4";
+        case TOKEN_MAT4: return "mat4";
+        case TOKEN_SAMPLER2D: return "sampler2D";
+        case TOKEN_SAMPLERCUBE: return "samplerCube";
+        default: return "?";
+    }
+}
+
+// --- AST Structures ---
+
+typedef struct FXUniform {
+    const char* type;
+    const char* name;
+    int per_draw;           // Declared 'per_draw': one value per draw
+    struct FXUniform* next;
+} FXUniform;
+
+typedef struct FXInput {
+    const char* type;
+    const char* name;
+    const char* format;     // packed(...) storage format, NULL for float
+    int instanced;          // Declared 'instance': advances once per instance
+    struct FXInput* next;
+} FXInput;
+
+typedef struct FXExpr FXExpr;
+
+typedef struct FXStatement {
+    const char* text;
+    int length;
+    struct FXStatement* next;
+} FXStatement;
+
+typedef struct FXFunction {
+    const char* name;
+    int is_vertex;
+    int is_fragment;
+    const char* out_type;
+    const char* out_name;
+    FXStatement* statements;
+    FXInput* varyings;      // Vertex 'out' declarations hoisted out of the body
+    struct FXFunction* next;
+} FXFunction;
+
+typedef struct FXShader {
+    const char* name;
+    FXUniform* uniforms;
+    FXInput* inputs;
+    FXFunction* functions;
+    int is_named_block;
+    struct FXShader* next;
+} FXShader;
+
+typedef struct {
+    Lexer* lex;
+    Token current;
+    int failed;
+    int error_line;
+    int error_col;
+    char error[256];
+} Parser;
+
+// Growable output string; failed sticks once an allocation fails
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    int failed;
+} FXCBuffer;
+
+// Function prototypes
+static char* parse_function_body_to_glsl(Parser* p, int is_vertex, FXInput** varyings);
+static void cleanup_shader(FXShader* shader);
+static void cleanup_uniform_list(FXUniform* uniforms);
+static void cleanup_input_list(FXInput* inputs);
+static void cleanup_function_list(FXFunction* functions);
+
+
+
+static int is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int is_alnum(char c) {
+    return is_alpha(c) || is_digit(c);
+}
+
+static void skip_whitespace(Lexer* lex) {
+    for (;;) {
+        char c = lex->src[lex->pos];
+        if (c == ' ' || c == '\t' || c == '\r') {
+            lex->pos++;
+            lex->col++;
+        } else if (c == '\n') {
+            lex->pos++;
+            lex->line++;
+            lex->col = 1;
+        } else if (c == '/' && lex->src[lex->pos+1] == '/') {
+            // Single-line comment
+            lex->pos += 2;
+            lex->col += 2;
+            while (lex->src[lex->pos] && lex->src[lex->pos] != '\n') {
+                lex->pos++;
+                lex->col++;
+            }
+        } else if (c == '/' && lex->src[lex->pos+1] == '*') {
+            // Multi-line comment
+            lex->pos += 2;
+            lex->col += 2;
+            while (lex->src[lex->pos] && !(lex->src[lex->pos] == '*' && lex->src[lex->pos+1] == '/')) {
+                if (lex->src[lex->pos] == '\n') {
+                    lex->line++;
+                    lex->col = 1;
+                } else {
+                    lex->col++;
+                }
+                lex->pos++;
+            }
+            if (lex->src[lex->pos]) {
+                lex->pos += 2;
+                lex->col += 2;
+            }
+        } else {
+            break;
+        }
+    }
+}
+
+static int match_keyword(const char* text, int len, const char* kw) {
+    int kwlen = (int)strlen(kw);
+    return len == kwlen && strncmp(text, kw, kwlen) == 0;
+}
+
+static TokenType check_keyword(const char* text, int len) {
+    // Keywords
+    if (match_keyword(text, len, "shader")) return TOKEN_SHADER;
+    if (match_keyword(text, len, "uniform")) return TOKEN_UNIFORM;
+    if (match_keyword(text, len, "input")) return TOKEN_INPUT;
+    if (match_keyword(text, len, "instance")) return TOKEN_INSTANCE;
+    if (match_keyword(text, len, "per_draw")) return TOKEN_PER_DRAW;
+    if (match_keyword(text, len, "void")) return TOKEN_VOID;
+    if (match_keyword(text, len, "out")) return TOKEN_OUT;
+    // New syntax keywords
+    if (match_keyword(text, len, "vertex_shader")) return TOKEN_VERTEX_SHADER;
+    if (match_keyword(text, len, "fragment_shader")) return TOKEN_FRAGMENT_SHADER;
+    // Types
+    if (match_keyword(text, len, "float")) return TOKEN_FLOAT;
+    if (match_keyword(text, len, "vec2")) return TOKEN_VEC2;
+    if (match_keyword(text, len, "vec3")) return TOKEN_VEC3;
+    if (match_keyword(text, len, "vec4")) return TOKEN_VEC4;
+    if (match_keyword(text, len, "mat4")) return TOKEN_MAT4;
+    if (match_keyword(text, len, "sampler2D")) return TOKEN_SAMPLER2D;
+    if (match_keyword(text, len, "samplerCube")) return TOKEN_SAMPLERCUBE;
+    return TOKEN_IDENTIFIER;
+}
+
+static Token lexer_next(Lexer* lex) {
+    skip_whitespace(lex);
+    
+    if (lex->pos >= lex->length) {
+        return (Token){TOKEN_EOF, lex->src + lex->pos, 0, lex->line, lex->col};
+    }
+    
+    char c = lex->src[lex->pos];
+    int start_pos = lex->pos;
+    int start_line = lex->line;
+    int start_col = lex->col;
+    
+    // Identifiers and keywords
+    if (is_alpha(c) || c == '_') {
+        while (is_alnum(lex->src[lex->pos]) || lex->src[lex->pos] == '_') {
+            lex->pos++;
+            lex->col++;
+        }
+        int len = lex->pos - start_pos;
+        TokenType type = check_keyword(lex->src + start_pos, len);
+        Token t = {type, lex->src + start_pos, len, start_line, start_col};
+        return t;
+    }
+    
+    // Numbers
+    if (is_digit(c)) {
+        int num_start = lex->pos;
+        int num_col = lex->col;
+        while (is_digit(lex->src[lex->pos])) {
+            lex->pos++;
+            lex->col++;
+        }
+        if (lex->src[lex->pos] == '.') {
+            lex->pos++;
+            lex->col++;
+            while (is_digit(lex->src[lex->pos])) {
+                lex->pos++;
+                lex->col++;
+            }
+        }
+        int len = lex->pos - num_start;
+        Token t = {TOKEN_NUMBER, lex->src + num_start, len, start_line, num_col};
+        return t;
+    }
+    // Symbols
+    switch (c) {
+        case '{': lex->pos++; lex->col++; return (Token){TOKEN_LBRACE, lex->src + start_pos, 1, start_line, start_col};
+        case '}': lex->pos++; lex->col++; return (Token){TOKEN_RBRACE, lex->src + start_pos, 1, start_line, start_col};
+        case '(': lex->pos++; lex->col++; return (Token){TOKEN_LPAREN, lex->src + start_pos, 1, start_line, start_col};
+        case ')': lex->pos++; lex->col++; return (Token){TOKEN_RPAREN, lex->src + start_pos, 1, start_line, start_col};
+        case ';': lex->pos++; lex->col++; return (Token){TOKEN_SEMICOLON, lex->src + start_pos, 1, start_line, start_col};
+        case ',': lex->pos++; lex->col++; return (Token){TOKEN_COMMA, lex->src + start_pos, 1, start_line, start_col};
+        case '=': lex->pos++; lex->col++; return (Token){TOKEN_EQUAL, lex->src + start_pos, 1, start_line, start_col};
+        case '*': lex->pos++; lex->col++; return (Token){TOKEN_ASTERISK, lex->src + start_pos, 1, start_line, start_col};
+        case '.': lex->pos++; lex->col++; return (Token){TOKEN_DOT, lex->src + start_pos, 1, start_line, start_col};
+        case ':': lex->pos++; lex->col++; return (Token){TOKEN_COLON, lex->src + start_pos, 1, start_line, start_col};
+        case '-': lex->pos++; lex->col++; return (Token){TOKEN_MINUS, lex->src + start_pos, 1, start_line, start_col};
+        case '+': lex->pos++; lex->col++; return (Token){TOKEN_PLUS, lex->src + start_pos, 1, start_line, start_col};
+        case '/': lex->pos++; lex->col++; return (Token){TOKEN_SLASH, lex->src + start_pos, 1, start_line, start_col};
+        case '<': lex->pos++; lex->col++; return (Token){TOKEN_LT, lex->src + start_pos, 1, start_line, start_col};
+        case '>': lex->pos++; lex->col++; return (Token){TOKEN_GT, lex->src + start_pos, 1, start_line, start_col};
+        case '&': lex->pos++; lex->col++; return (Token){TOKEN_AMPERSAND, lex->src + start_pos, 1, start_line, start_col};
+        case '|': lex->pos++; lex->col++; return (Token){TOKEN_PIPE, lex->src + start_pos, 1, start_line, start_col};
+        case '!': lex->pos++; lex->col++; return (Token){TOKEN_EXCLAMATION, lex->src + start_pos, 1, start_line, start_col};
+        default:
+            // Unknown character, skip it
+            lex->pos++;
+            lex->col++;
+            return (Token){TOKEN_EOF, lex->src + start_pos, 1, start_line, start_col};
+    }
+}
+
+// --- Parser Implementation ---
+
+// Records the first error only; later ones are usually fallout from it
+static void parse_error(Parser* p, const char* fmt, ...) {
+    if (p->failed) return;
+    p->failed = 1;
+    p->error_line = p->current.line;
+    p->error_col = p->current.col;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(p->error, sizeof(p->error), fmt, args);
+    va_end(args);
+}
+
+static void parser_advance(Parser* p) {
+    p->current = lexer_next(p->lex);
+}
+
+static int parser_match(Parser* p, TokenType type) {
+    if (p->current.type == type) {
+        parser_advance(p);
+        return 1;
+    }
+    return 0;
+}
+
+static int parser_expect(Parser* p, TokenType type, const char* msg) {
+    if (!parser_match(p, type)) {
+        parse_error(p, "expected %s at line %d, col %d (got %s)",
+                    msg, p->current.line, p->current.col, token_type_str(p->current.type));
+        return 0;
+    }
+    return 1; // Success
+}
+
+static char* token_to_str(const Token* t) {
+    char* s = (char*)malloc(t->length + 1);
+    if (!s) return NULL;
+    memcpy(s, t->text, t->length);
+    s[t->length] = 0;
+    return s;
+}
+
+static char* str_dup(const char* s) {
+    size_t len = strlen(s);
+    char* copy = (char*)malloc(len + 1);
+    if (copy) memcpy(copy, s, len + 1);
+    return copy;
+}
+
+// 'uniform' or 'per_draw' declaration
+static FXUniform* parse_uniform(Parser* p) {
+    int per_draw = p->current.type == TOKEN_PER_DRAW;
+    const char* keyword = per_draw ? "per_draw" : "uniform";
+    parser_advance(p);
+    if (p->current.type < TOKEN_FLOAT || p->current.type > TOKEN_SAMPLERCUBE) {
+        parse_error(p, "expected type after '%s' at line %d", keyword, p->current.line);
+        return NULL;
+    }
+    if (per_draw && p->current.type >= TOKEN_SAMPLER2D) {
+        parse_error(p, "per_draw values can't be samplers (line %d)", p->current.line);
+        return NULL;
+    }
+    char* type = token_to_str(&p->current);
+    parser_advance(p);
+    if (p->current.type != TOKEN_IDENTIFIER) {
+        parse_error(p, "expected identifier after type in uniform declaration at line %d", p->current.line);
+        free(type);
+        return NULL;
+    }
+    char* name = token_to_str(&p->current);
+    parser_advance(p);
+    if (!parser_expect(p, TOKEN_SEMICOLON, ";")) {
+        free(type);
+        free(name);
+        return NULL;
+    }
+    FXUniform* u = (FXUniform*)calloc(1, sizeof(FXUniform));
+    u->type = type;
+    u->name = name;
+    u->per_draw = per_draw;
+    return u;
+}
+
+// 'input' or 'instance' declaration; the two differ only in the divisor
+static FXInput* parse_input(Parser* p) {
+    int instanced = p->current.type == TOKEN_INSTANCE;
+    const char* keyword = instanced ? "instance" : "input";
+    parser_advance(p);
+    if (p->current.type < TOKEN_FLOAT || p->current.type > TOKEN_SAMPLERCUBE) {
+        parse_error(p, "expected type after '%s' at line %d", keyword, p->current.line);
+        return NULL;
+    }
+    if (instanced && p->current.type >= TOKEN_SAMPLER2D) {
+        parse_error(p, "instance inputs can't be samplers (line %d)", p->current.line);
+        return NULL;
+    }
+    char* type = token_to_str(&p->current);
+    parser_advance(p);
+    if (p->current.type != TOKEN_IDENTIFIER) {
+        parse_error(p, "expected identifier after type in input declaration at line %d", p->current.line);
+        free(type);
+        return NULL;
+    }
+    char* name = token_to_str(&p->current);
+    parser_advance(p);
+
+    // Optional ': SEMANTIC', then an optional 'packed(format)' for storage
+    if (parser_match(p, TOKEN_COLON)) {
+        parser_expect(p, TOKEN_IDENTIFIER, "semantic");
+    }
+    char* format = NULL;
+    if (!p->failed && p->current.type == TOKEN_IDENTIFIER &&
+        p->current.length == 6 && strncmp(p->current.text, "packed", 6) == 0) {
+        parser_advance(p);
+        parser_expect(p, TOKEN_LPAREN, "(");
+        if (p->current.type == TOKEN_IDENTIFIER || (p->current.type >= TOKEN_FLOAT && p->current.type <= TOKEN_MAT4)) {
+            format = token_to_str(&p->current);
+        }
+        int line = p->current.line;
+        parser_advance(p);
+        parser_expect(p, TOKEN_RPAREN, ")");
+        int known = format ? fx_reflect_format(format) : -1;
+        if (!p->failed && known < 0) {
+            parse_error(p, "unknown packed format '%s' for input %s at line %d", format ? format : "", name, line);
+        } else if (!p->failed && !fx_reflect_attrib_size(fx_reflect_type(type), (FXVertexFormat)known)) {
+            parse_error(p, "input %s: %s can't be stored as %s at line %d", name, type, format, line);
+        }
+    }
+    if (p->failed || !parser_expect(p, TOKEN_SEMICOLON, ";")) {
+        free(type);
+        free(name);
+        free(format);
+        return NULL;
+    }
+    FXInput* in = (FXInput*)calloc(1, sizeof(FXInput));
+    in->type = type;
+    in->name = name;
+    in->format = format;
+    in->instanced = instanced;
+    return in;
+}
+
+static FXStatement* parse_statement(Parser* p) {
+    // For now, just grab everything up to the next '}' or end of function
+    int start = p->current.text - p->lex->src;
+    int depth = 0;
+    while (p->current.type != TOKEN_RBRACE && p->current.type != TOKEN_EOF) {
+        if (p->current.type == TOKEN_LBRACE) depth++;
+        if (p->current.type == TOKEN_RBRACE && depth > 0) depth--;
+        parser_advance(p);
+        if (depth == 0 && (p->current.type == TOKEN_RBRACE || p->current.type == TOKEN_EOF)) break;
+    }
+    int end = p->current.text - p->lex->src;
+    FXStatement* stmt = (FXStatement*)calloc(1, sizeof(FXStatement));
+    // Own a copy so the AST can outlive the source buffer
+    char* text = (char*)malloc(end - start + 1);
+    memcpy(text, p->lex->src + start, end - start);
+    text[end - start] = '\0';
+    stmt->text = text;
+    stmt->length = end - start;
+    return stmt;
+}
+
+static FXFunction* parse_function(Parser* p) {
+    LOG_DEBUG("Parsing function at line %d", p->current.line);
+
+    parser_expect(p, TOKEN_VOID, "'void'");
+    char* name = token_to_str(&p->current);
+    parser_expect(p, TOKEN_IDENTIFIER, "function name");
+    int is_vertex = strcmp(name, "vertex") == 0;
+    int is_fragment = strcmp(name, "fragment") == 0;
+
+    LOG_DEBUG("Function name: %s (vertex=%d, fragment=%d)", name, is_vertex, is_fragment);
+
+    parser_expect(p, TOKEN_LPAREN, "(");
+    char* out_type = NULL;
+    char* out_name = NULL;
+    // Handle fragment function output parameter
+    if (is_fragment && parser_match(p, TOKEN_OUT)) {
+        if (p->current.type < TOKEN_FLOAT || p->current.type > TOKEN_MAT4) {
+            parse_error(p, "expected type after 'out' in fragment() at line %d", p->current.line);
+            free(name);
+            return NULL;
+        }
+        out_type = token_to_str(&p->current);
+        parser_advance(p);
+        out_name = token_to_str(&p->current);
+        parser_expect(p, TOKEN_IDENTIFIER, "output param name");
+        LOG_DEBUG("Fragment output: %s %s", out_type, out_name);
+    }
+    // For now, we don't handle input parameters to functions
+    // They are declared as shader inputs instead
+    parser_expect(p, TOKEN_RPAREN, ")");
+    parser_expect(p, TOKEN_LBRACE, "{");
+    FXStatement* stmts = parse_statement(p);
+    parser_expect(p, TOKEN_RBRACE, "}");
+
+    FXFunction* fn = (FXFunction*)calloc(1, sizeof(FXFunction));
+    fn->name = name;
+    fn->is_vertex = is_vertex;
+    fn->is_fragment = is_fragment;
+    fn->out_type = out_type;
+    fn->out_name = out_name;
+    fn->statements = stmts;
+
+    LOG_DEBUG("Parsed function: %s", name);
+    return fn;
+}
+
+// New parser for vertex_shader and fragment_shader syntax
+static FXFunction* parse_new_function(Parser* p) {
+    LOG_DEBUG("Parsing new-style function at line %d", p->current.line);
+
+    TokenType function_type = p->current.type;
+    int is_vertex = (function_type == TOKEN_VERTEX_SHADER);
+    int is_fragment = (function_type == TOKEN_FRAGMENT_SHADER);
+
+    parser_advance(p); // Consume vertex_shader or fragment_shader
+
+    char* name = NULL;
+    if (p->current.type == TOKEN_IDENTIFIER) {
+        name = token_to_str(&p->current);
+        parser_advance(p);
+    } else {
+        // Anonymous function: use default name
+        name = str_dup(is_vertex ? "vertex" : "fragment");
+    }
+
+    LOG_DEBUG("New function: %s (vertex=%d, fragment=%d)", name, is_vertex, is_fragment);
+
+    parser_expect(p, TOKEN_LPAREN, "(");
+    while (p->current.type != TOKEN_RPAREN && p->current.type != TOKEN_EOF && !p->failed) {
+        // Type
+        if (p->current.type == TOKEN_FLOAT || p->current.type == TOKEN_VEC2 || p->current.type == TOKEN_VEC3 ||
+            p->current.type == TOKEN_VEC4 || p->current.type == TOKEN_MAT4 || p->current.type == TOKEN_SAMPLER2D ||
+            p->current.type == TOKEN_SAMPLERCUBE || p->current.type == TOKEN_IDENTIFIER) {
+            parser_advance(p);
+        } else {
+            parse_error(p, "expected parameter type at line %d, col %d (got %s)", p->current.line, p->current.col, token_type_str(p->current.type));
+            break;
+        }
+        // Name
+        parser_expect(p, TOKEN_IDENTIFIER, "parameter name");
+
+        // Check for colon (semantic)
+        if (p->current.type == TOKEN_COLON) {
+            parser_advance(p);
+            parser_expect(p, TOKEN_IDENTIFIER, "semantic");
+        }
+
+        // Check for comma or end
+        if (p->current.type == TOKEN_COMMA) {
+            parser_advance(p);
+        } else if (p->current.type == TOKEN_RPAREN) {
+            break;
+        } else {
+            parse_error(p, "expected ',' or ')' in parameter list at line %d (got %s)", p->current.line, token_type_str(p->current.type));
+            break;
+        }
+    }
+    parser_expect(p, TOKEN_RPAREN, ")");
+    parser_expect(p, TOKEN_LBRACE, "{");
+    FXInput* varyings = NULL;
+    char* body_glsl = p->failed ? NULL : parse_function_body_to_glsl(p, is_vertex, &varyings);
+    parser_expect(p, TOKEN_RBRACE, "}");
+    if (!body_glsl || p->failed) {
+        free(name);
+        free(body_glsl);
+        cleanup_input_list(varyings);
+        return NULL;
+    }
+
+    // Create a statement from the processed body
+    FXStatement* stmts = (FXStatement*)calloc(1, sizeof(FXStatement));
+    stmts->text = body_glsl;
+    stmts->length = strlen(body_glsl);
+
+    FXFunction* fn = (FXFunction*)calloc(1, sizeof(FXFunction));
+    fn->name = name;
+    fn->is_vertex = is_vertex;
+    fn->is_fragment = is_fragment;
+    fn->out_type = NULL;
+    fn->out_name = NULL;
+    fn->statements = stmts;
+    fn->varyings = varyings;
+
+    LOG_DEBUG("Parsed new function: %s", name);
+    return fn;
+}
+
+static FXShader* parse_shader(Parser* p) {
+    LOG_DEBUG("Parsing shader at line %d", p->current.line);
+
+    parser_expect(p, TOKEN_SHADER, "'shader'");
+    char* name = token_to_str(&p->current);
+    parser_expect(p, TOKEN_IDENTIFIER, "shader name");
+
+    LOG_DEBUG("Shader name: %s", name);
+
+    parser_expect(p, TOKEN_LBRACE, "{");
+    FXShader* shader = (FXShader*)calloc(1, sizeof(FXShader));
+    shader->name = name;
+    shader->is_named_block = 1;
+    FXUniform** uptr = &shader->uniforms;
+    FXInput** iptr = &shader->inputs;
+    FXFunction** fptr = &shader->functions;
+
+    while (p->current.type != TOKEN_RBRACE && p->current.type != TOKEN_EOF && !p->failed) {
+        if (p->current.type == TOKEN_UNIFORM || p->current.type == TOKEN_PER_DRAW) {
+            LOG_DEBUG("Parsing uniform at line %d", p->current.line);
+            FXUniform* u = parse_uniform(p);
+            if (!u) break;
+            *uptr = u;
+            uptr = &u->next;
+        } else if (p->current.type == TOKEN_INPUT || p->current.type == TOKEN_INSTANCE) {
+            LOG_DEBUG("Parsing input at line %d", p->current.line);
+            FXInput* in = parse_input(p);
+            if (!in) break;
+            *iptr = in;
+            iptr = &in->next;
+        } else if (p->current.type == TOKEN_VOID) {
+            LOG_DEBUG("Parsing void function at line %d", p->current.line);
+            FXFunction* fn = parse_function(p);
+            if (!fn) break;
+            *fptr = fn;
+            fptr = &fn->next;
+        } else {
+            parse_error(p, "unexpected token '%.*s' in shader block at line %d",
+                        p->current.length, p->current.text, p->current.line);
+        }
+    }
+
+    parser_expect(p, TOKEN_RBRACE, "}");
+
+    LOG_DEBUG("Parsed shader: %s", name);
+    return shader;
+}
+
+static FXShader* parse_shader_file(Parser* p, const char* program_name) {
+    LOG_DEBUG("Starting to parse shader file");
+
+    FXShader* shaders = NULL;
+    FXShader** sptr = &shaders;
+    parser_advance(p); // Load first token
+
+    // Top-level uniforms/inputs belong to the unnamed vertex_shader/fragment_shader
+    // program, which collects every standalone stage in the file
+    FXShader* program = NULL;
+    FXUniform* pending_uniforms = NULL;
+    FXInput* pending_inputs = NULL;
+    FXUniform** uptr = &pending_uniforms;
+    FXInput** iptr = &pending_inputs;
+
+    while (p->current.type != TOKEN_EOF && !p->failed) {
+        if (p->current.type == TOKEN_SHADER) {
+            LOG_DEBUG("Found shader block at line %d", p->current.line);
+            FXShader* s = parse_shader(p);
+            *sptr = s;
+            sptr = &s->next;
+        } else if (p->current.type == TOKEN_UNIFORM || p->current.type == TOKEN_PER_DRAW) {
+            LOG_DEBUG("Found top-level uniform at line %d", p->current.line);
+            FXUniform* u = parse_uniform(p);
+            if (!u) break;
+            *uptr = u;
+            uptr = &u->next;
+        } else if (p->current.type == TOKEN_INPUT || p->current.type == TOKEN_INSTANCE) {
+            LOG_DEBUG("Found top-level input at line %d", p->current.line);
+            FXInput* in = parse_input(p);
+            if (!in) break;
+            *iptr = in;
+            iptr = &in->next;
+        } else if (p->current.type == TOKEN_VERTEX_SHADER || p->current.type == TOKEN_FRAGMENT_SHADER) {
+            LOG_DEBUG("Found standalone shader at line %d", p->current.line);
+            int line = p->current.line;
+            FXFunction* fn = parse_new_function(p);
+            if (!fn) break;
+            if (!program) {
+                program = (FXShader*)calloc(1, sizeof(FXShader));
+                program->name = str_dup(program_name);
+                *sptr = program;
+                sptr = &program->next;
+            }
+            FXFunction** fptr = &program->functions;
+            for (; *fptr; fptr = &(*fptr)->next) {
+                if ((*fptr)->is_vertex == fn->is_vertex) {
+                    parse_error(p, "duplicate %s at line %d", fn->is_vertex ? "vertex_shader" : "fragment_shader", line);
+                }
+            }
+            *fptr = fn;
+        } else {
+            parse_error(p, "unexpected token at line %d: '%.*s'",
+                        p->current.line, p->current.length, p->current.text);
+        }
+    }
+
+    if (program) {
+        program->uniforms = pending_uniforms;
+        program->inputs = pending_inputs;
+    } else {
+        cleanup_uniform_list(pending_uniforms);
+        cleanup_input_list(pending_inputs);
+    }
+
+    LOG_DEBUG("Finished parsing shader file");
+    return shaders;
+}
+
+// --- Code Generation ---
+
+static void buf_append(FXCBuffer* b, const char* text, size_t length) {
+    if (b->failed) return;
+    if (b->length + length + 1 > b->capacity) {
+        size_t capacity = b->capacity ? b->capacity : 1024;
+        while (b->length + length + 1 > capacity) capacity *= 2;
+        char* data = (char*)realloc(b->data, capacity);
+        if (!data) {
+            b->failed = 1;
+            return;
+        }
+        b->data = data;
+        b->capacity = capacity;
+    }
+    memcpy(b->data + b->length, text, length);
+    b->length += length;
+    b->data[b->length] = '\0';
+}
+
+static void buf_putc(FXCBuffer* b, char c) {
+    buf_append(b, &c, 1);
+}
+
+static void buf_printf(FXCBuffer* b, const char* fmt, ...) {
+    char stack[256];
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(stack, sizeof(stack), fmt, args);
+    va_end(args);
+    if (length < 0) {
+        b->failed = 1;
+        return;
+    }
+    if ((size_t)length < sizeof(stack)) {
+        buf_append(b, stack, (size_t)length);
+        return;
+    }
+    char* heap = (char*)malloc((size_t)length + 1);
+    if (!heap) {
+        b->failed = 1;
+        return;
+    }
+    va_start(args, fmt);
+    vsnprintf(heap, (size_t)length + 1, fmt, args);
+    va_end(args);
+    buf_append(b, heap, (size_t)length);
+    free(heap);
+}
+
+static void write_glsl_header(FXCBuffer* b, FXCTarget target, int draw_id) {
+    if (target == FXC_TARGET_GL43) {
+        buf_printf(b, "#version 430 core\n");
+        if (draw_id) buf_printf(b, "#extension GL_ARB_shader_draw_parameters : require\n");
+    } else {
+        // Uniform locations need an extension on 3.3; the runtime checks for
+        // the same one before trusting the locations in the metadata
+        buf_printf(b, "#version 330 core\n");
+        buf_printf(b, "#ifdef GL_ARB_explicit_uniform_location\n");
+        buf_printf(b, "#extension GL_ARB_explicit_uniform_location : enable\n");
+        buf_printf(b, "#define FX_LOCATION(n) layout(location = n)\n");
+        buf_printf(b, "#else\n");
+        buf_printf(b, "#define FX_LOCATION(n)\n");
+        buf_printf(b, "#endif\n");
+    }
+    buf_printf(b, "precision highp float;\n\n");
+}
+
+// Locations and bindings come from the reflection records, so the GLSL and
+// the .meta always agree
+static void write_uniforms(FXCBuffer* b, FXUniform* uniforms, const FXReflectRecord* records, FXCTarget target) {
+    for (FXUniform* u = uniforms; u; u = u->next, records++) {
+        if (target == FXC_TARGET_GL43 && u->per_draw) continue;   // In the draw buffer
+        if (target == FXC_TARGET_GL43 && records->binding >= 0) {
+            buf_printf(b, "layout(location = %d, binding = %d) ", records->location, records->binding);
+        } else if (target == FXC_TARGET_GL43) {
+            buf_printf(b, "layout(location = %d) ", records->location);
+        } else {
+            buf_printf(b, "FX_LOCATION(%d) ", records->location);
+        }
+        buf_printf(b, "uniform %s %s;\n", u->type, u->name);
+    }
+    if (uniforms) buf_printf(b, "\n");
+}
+
+static int has_per_draw(FXUniform* uniforms) {
+    for (FXUniform* u = uniforms; u; u = u->next) {
+        if (u->per_draw) return 1;
+    }
+    return 0;
+}
+
+// gl43 per_draw values: one FXDrawData per draw of a multi-draw, indexed by
+// gl_DrawID, which the vertex stage forwards to the fragment stage. The
+// defines let bodies use the plain names either way.
+static void write_draw_buffer(FXCBuffer* b, FXUniform* uniforms, int is_vertex) {
+    buf_printf(b, "struct FXDrawData {\n");
+    for (FXUniform* u = uniforms; u; u = u->next) {
+        if (u->per_draw) buf_printf(b, "    %s %s;\n", u->type, u->name);
+    }
+    buf_printf(b, "};\n");
+    buf_printf(b, "layout(std430, binding = %d) readonly buffer FXDrawBuffer {\n", FX_DRAW_BUFFER_BINDING);
+    buf_printf(b, "    FXDrawData fx_draws[];\n");
+    buf_printf(b, "};\n");
+    buf_printf(b, "%s int fx_draw_index;\n", is_vertex ? "flat out" : "flat in");
+    for (FXUniform* u = uniforms; u; u = u->next) {
+        if (u->per_draw) buf_printf(b, "#define %s (fx_draws[fx_draw_index].%s)\n", u->name, u->name);
+    }
+    buf_printf(b, "\n");
+}
+
+static void write_inputs(FXCBuffer* b, FXInput* inputs, const FXReflectRecord* records) {
+    for (FXInput* in = inputs; in; in = in->next, records++) {
+        buf_printf(b, "layout(location = %d) in %s %s;\n", records->location, in->type, in->name);
+    }
+    if (inputs) buf_printf(b, "\n");
+}
+
+static void write_varyings(FXCBuffer* b, FXInput* varyings, const char* qualifier) {
+    for (FXInput* v = varyings; v; v = v->next) {
+        buf_printf(b, "%s %s %s;\n", qualifier, v->type, v->name);
+    }
+    if (varyings) buf_printf(b, "\n");
+}
+
+static void write_vertex_outputs_as_fragment_inputs(FXCBuffer* b) {
+    // These are the outputs from vertex shader that become inputs to fragment shader
+    buf_printf(b, "in vec3 v_normal;\n");
+    buf_printf(b, "in vec3 v_position;\n");
+    buf_printf(b, "in vec2 v_texCoord;\n");
+    buf_printf(b, "\n");
+}
+
+static void write_function(FXCBuffer* b, FXFunction* fn, int draw_id) {
+    if (fn->is_vertex) {
+        buf_printf(b, "void main() {\n");
+        if (draw_id) buf_printf(b, "    fx_draw_index = gl_DrawIDARB;\n");
+        // Write vertex shader body (already processed)
+        if (fn->statements) {
+            buf_printf(b, "%s", fn->statements->text);
+        }
+        buf_printf(b, "}\n");
+    } else if (fn->is_fragment) {
+        // Fragment shader needs output declaration; old-style fragment(out T name)
+        // names its own, the new syntax always writes fragColor
+        if (fn->out_type && fn->out_name) {
+            buf_printf(b, "layout(location = 0) out %s %s;\n\n", fn->out_type, fn->out_name);
+        } else {
+            buf_printf(b, "layout(location = 0) out vec4 fragColor;\n\n");
+        }
+        buf_printf(b, "void main() {\n");
+        // Write fragment shader body (already processed)
+        if (fn->statements) {
+            buf_printf(b, "%s", fn->statements->text);
+        }
+        buf_printf(b, "}\n");
+    }
+}
+
+static void generate_glsl(FXShader* shader, FXReflectHeader* reflection, FXCTarget target,
+                          FXCBuffer* vert, FXCBuffer* frag) {
+    LOG_DEBUG("Generating GLSL for shader: %s", shader->name);
+
+    // Find vertex and fragment functions
+    FXFunction* vertex_fn = NULL;
+    FXFunction* fragment_fn = NULL;
+    for (FXFunction* fn = shader->functions; fn; fn = fn->next) {
+        if (fn->is_vertex) vertex_fn = fn;
+        if (fn->is_fragment) fragment_fn = fn;
+    }
+
+    LOG_DEBUG("Found vertex function: %s", vertex_fn ? vertex_fn->name : "none");
+    LOG_DEBUG("Found fragment function: %s", fragment_fn ? fragment_fn->name : "none");
+
+    int draw_id = target == FXC_TARGET_GL43 && has_per_draw(shader->uniforms);
+
+    // Vertex shader
+    if (vertex_fn) {
+        write_glsl_header(vert, target, draw_id);
+        write_uniforms(vert, shader->uniforms, fx_reflect_uniforms(reflection), target);
+        if (draw_id) write_draw_buffer(vert, shader->uniforms, 1);
+        write_inputs(vert, shader->inputs, fx_reflect_inputs(reflection));
+        write_varyings(vert, vertex_fn->varyings, "out");
+        write_function(vert, vertex_fn, draw_id);
+    }
+    // Fragment shader
+    if (fragment_fn) {
+        write_glsl_header(frag, target, 0);
+        write_uniforms(frag, shader->uniforms, fx_reflect_uniforms(reflection), target);
+        if (draw_id) write_draw_buffer(frag, shader->uniforms, 0);
+        // The fragment stage reads whatever the vertex stage declared 'out';
+        // old-style function bodies aren't scanned, so they get the fixed set
+        if (vertex_fn && vertex_fn->varyings) {
+            write_varyings(frag, vertex_fn->varyings, "in");
+        } else {
+            write_vertex_outputs_as_fragment_inputs(frag);
+        }
+        write_function(frag, fragment_fn, 0);
+    }
+}
+
+// Text form of the reflection data, for 'fxc --meta=text'; the runtime reads
+// either form
+static void generate_text_metadata(const FXCShaderOutput* out, FXCTarget target, FXCBuffer* meta,
+                                   const char* source_path) {
+    buf_printf(meta, "shader %s\n", out->name);
+    buf_printf(meta, "target %s\n", target == FXC_TARGET_GL43 ? "gl43" : "gl33");
+    if (source_path) {
+        buf_printf(meta, "source %s\n", source_path); // Watched by the runtime for live reload
+    }
+    buf_printf(meta, "uniforms %d\n", out->uniform_count);
+    for (int i = 0; i < out->uniform_count; i++) {
+        const char* keyword = out->uniforms[i].divisor ? "per_draw" : "uniform";
+        buf_printf(meta, "%s %s %s\n", keyword, out->uniforms[i].type, out->uniforms[i].name);
+    }
+    buf_printf(meta, "inputs %d\n", out->input_count);
+    for (int i = 0; i < out->input_count; i++) {
+        const char* keyword = out->inputs[i].divisor ? "instance" : "input";
+        if (out->inputs[i].format) {
+            buf_printf(meta, "%s %s %s %s\n", keyword, out->inputs[i].type, out->inputs[i].name, out->inputs[i].format);
+        } else {
+            buf_printf(meta, "%s %s %s\n", keyword, out->inputs[i].type, out->inputs[i].name);
+        }
+    }
+}
+
+// Parse function body and convert to GLSL; vertex 'out' declarations are
+// collected into varyings so they can be declared at global scope
+static char* parse_function_body_to_glsl(Parser* p, int is_vertex, FXInput** varyings) {
+    // Start collecting the function body
+    FXCBuffer body = {0};
+    FXInput** vptr = varyings;
+    int depth = 0;
+    TokenType prev_token = TOKEN_EOF;
+
+    while (p->current.type != TOKEN_RBRACE && p->current.type != TOKEN_EOF && !p->failed) {
+        if (p->current.type == TOKEN_LBRACE) {
+            depth++;
+            buf_putc(&body, '{');
+            parser_advance(p);
+        } else if (p->current.type == TOKEN_RBRACE) {
+            if (depth > 0) {
+                depth--;
+                buf_putc(&body, '}');
+                parser_advance(p);
+            } else {
+                break; // End of function
+            }
+        } else if (p->current.type == TOKEN_OUT) {
+            // Handle out declarations - convert to proper GLSL
+            parser_advance(p); // Skip 'out'
+
+            // Get type
+            if (p->current.type < TOKEN_FLOAT || p->current.type > TOKEN_SAMPLERCUBE) {
+                parse_error(p, "expected type after 'out' at line %d", p->current.line);
+                break;
+            }
+
+            // For vertex shader, convert to varying out
+            // For fragment shader, it's the output color
+            if (is_vertex) {
+                char* type = token_to_str(&p->current);
+                parser_advance(p);
+
+                // Get variable name
+                if (p->current.type != TOKEN_IDENTIFIER) {
+                    parse_error(p, "expected identifier after type in out declaration at line %d", p->current.line);
+                    free(type);
+                    break;
+                }
+                FXInput* v = (FXInput*)calloc(1, sizeof(FXInput));
+                v->type = type;
+                v->name = token_to_str(&p->current);
+                *vptr = v;
+                vptr = &v->next;
+                parser_advance(p);
+
+                // Skip semantic if present
+                if (p->current.type == TOKEN_COLON) {
+                    parser_advance(p); // Skip colon
+                    if (p->current.type == TOKEN_IDENTIFIER) {
+                        parser_advance(p); // Skip semantic
+                    }
+                }
+            } else {
+                // Fragment shader - skip the out declaration since we handle it in main
+                parser_advance(p); // Skip type
+                if (p->current.type == TOKEN_IDENTIFIER) {
+                    parser_advance(p); // Skip name
+                }
+                if (p->current.type == TOKEN_COLON) {
+                    parser_advance(p); // Skip colon
+                    if (p->current.type == TOKEN_IDENTIFIER) {
+                        parser_advance(p); // Skip semantic
+                    }
+                }
+            }
+
+            // Skip semicolon
+            if (p->current.type == TOKEN_SEMICOLON) {
+                parser_advance(p);
+            }
+        } else {
+            // Add space before current token if needed
+            int add_space_before = 0;
+            if (prev_token != TOKEN_EOF) {
+                // Handle compound assignment operators (+=, -=, etc.)
+                if (p->current.type == TOKEN_EQUAL &&
+                    (prev_token == TOKEN_PLUS || prev_token == TOKEN_MINUS ||
+                     prev_token == TOKEN_ASTERISK || prev_token == TOKEN_SLASH)) {
+                    // No space before = in compound operators
+                    add_space_before = 0;
+                }
+                // Space before operators
+                else if (p->current.type == TOKEN_EQUAL || p->current.type == TOKEN_PLUS ||
+                    p->current.type == TOKEN_MINUS || p->current.type == TOKEN_ASTERISK ||
+                    p->current.type == TOKEN_SLASH || p->current.type == TOKEN_LT ||
+                    p->current.type == TOKEN_GT) {
+                    add_space_before = 1;
+                }
+                // Space after operators
+                else if (prev_token == TOKEN_EQUAL || prev_token == TOKEN_PLUS ||
+                        prev_token == TOKEN_MINUS || prev_token == TOKEN_ASTERISK ||
+                        prev_token == TOKEN_SLASH || prev_token == TOKEN_LT ||
+                        prev_token == TOKEN_GT) {
+                    add_space_before = 1;
+                }
+                // Space between identifiers
+                else if (prev_token == TOKEN_IDENTIFIER && p->current.type == TOKEN_IDENTIFIER) {
+                    add_space_before = 1;
+                }
+                // Space after type keywords
+                else if ((prev_token >= TOKEN_FLOAT && prev_token <= TOKEN_SAMPLERCUBE) &&
+                         p->current.type == TOKEN_IDENTIFIER) {
+                    add_space_before = 1;
+                }
+                // Space after commas
+                else if (prev_token == TOKEN_COMMA) {
+                    add_space_before = 1;
+                }
+                // Space before commas (but not always needed)
+                else if (p->current.type == TOKEN_COMMA && prev_token != TOKEN_RPAREN) {
+                    // Don't add space before comma after closing paren
+                }
+            }
+
+            if (add_space_before) {
+                buf_putc(&body, ' ');
+            }
+
+            // Copy current token
+            if (p->current.type == TOKEN_IDENTIFIER || p->current.type == TOKEN_NUMBER) {
+                buf_append(&body, p->current.text, p->current.length);
+            } else {
+                // Handle operators and symbols
+                const char* token_str = token_type_str(p->current.type);
+                if (token_str && strlen(token_str) == 1) {
+                    buf_putc(&body, token_str[0]);
+                } else {
+                    // Copy the actual text for multi-character tokens
+                    buf_append(&body, p->current.text, p->current.length);
+                }
+            }
+
+            // Add newline after semicolons for better formatting
+            if (p->current.type == TOKEN_SEMICOLON) {
+                buf_append(&body, "\n    ", 5);
+            }
+
+            prev_token = p->current.type;
+            parser_advance(p);
+        }
+    }
+
+    if (body.failed) {
+        parse_error(p, "out of memory");
+        free(body.data);
+        return NULL;
+    }
+    if (!body.data) buf_append(&body, "", 0);
+    return body.data;
+}
+
+static void cleanup_shader(FXShader* shader) {
+    // Free shader name
+    free((void*)shader->name);
+    cleanup_uniform_list(shader->uniforms);
+    cleanup_input_list(shader->inputs);
+    cleanup_function_list(shader->functions);
+    // Free shader itself
+    free(shader);
+}
+
+static void cleanup_uniform_list(FXUniform* uniforms) {
+    FXUniform* u = uniforms;
+    while (u) {
+        FXUniform* next = u->next;
+        free((void*)u->type);
+        free((void*)u->name);
+        free(u);
+        u = next;
+    }
+}
+
+static void cleanup_input_list(FXInput* inputs) {
+    FXInput* in = inputs;
+    while (in) {
+        FXInput* next = in->next;
+        free((void*)in->type);
+        free((void*)in->name);
+        free((void*)in->format);
+        free(in);
+        in = next;
+    }
+}
+
+static void cleanup_function_list(FXFunction* functions) {
+    FXFunction* fn = functions;
+    while (fn) {
+        FXFunction* next = fn->next;
+        free((void*)fn->name);
+        free((void*)fn->out_type);
+        free((void*)fn->out_name);
+        cleanup_input_list(fn->varyings);
+        FXStatement* stmt = fn->statements;
+        while (stmt) {
+            FXStatement* next_stmt = stmt->next;
+            free((void*)stmt->text);
+            free(stmt);
+            stmt = next_stmt;
+        }
+        free(fn);
+        fn = next;
+    }
+}
+
+// --- Public API ---
+
+static FXCVariable* reflect_uniforms(FXUniform* uniforms, int* count) {
+    int n = 0;
+    for (FXUniform* u = uniforms; u; u = u->next) n++;
+    *count = n;
+    FXCVariable* vars = (FXCVariable*)calloc(n ? n : 1, sizeof(FXCVariable));
+    if (!vars) return NULL;
+    int i = 0;
+    for (FXUniform* u = uniforms; u; u = u->next, i++) {
+        vars[i].type = str_dup(u->type);
+        vars[i].name = str_dup(u->name);
+        vars[i].divisor = u->per_draw;
+    }
+    return vars;
+}
+
+static FXCVariable* reflect_inputs(FXInput* inputs, int* count) {
+    int n = 0;
+    for (FXInput* in = inputs; in; in = in->next) n++;
+    *count = n;
+    FXCVariable* vars = (FXCVariable*)calloc(n ? n : 1, sizeof(FXCVariable));
+    if (!vars) return NULL;
+    int i = 0;
+    for (FXInput* in = inputs; in; in = in->next, i++) {
+        vars[i].type = str_dup(in->type);
+        vars[i].name = str_dup(in->name);
+        vars[i].format = in->format ? str_dup(in->format) : NULL;
+        vars[i].divisor = in->instanced;
+    }
+    return vars;
+}
+
+static FXCStatus emit_shader(FXShader* shader, const char* source_path, const FXCOptions* opts,
+                             FXCShaderOutput* out) {
+    out->name = str_dup(shader->name);
+    out->is_named_block = shader->is_named_block;
+    out->uniforms = reflect_uniforms(shader->uniforms, &out->uniform_count);
+    out->inputs = reflect_inputs(shader->inputs, &out->input_count);
+    if (!out->name || !out->uniforms || !out->inputs) return FXC_ERROR_OUT_OF_MEMORY;
+
+    // Assign locations first; the GLSL declares what the reflection says
+    uint32_t flags = FX_REFLECT_ASSIGNED | (opts->target == FXC_TARGET_GL43 ? FX_REFLECT_GL43 : 0);
+    size_t reflection_size = 0;
+    FXReflectHeader* reflection = (FXReflectHeader*)fx_reflect_build(
+        out->name, source_path, flags, out->uniforms, out->uniform_count,
+        out->inputs, out->input_count, &reflection_size);
+    if (!reflection) return FXC_ERROR_OUT_OF_MEMORY;
+
+    FXCBuffer vert = {0}, frag = {0};
+    generate_glsl(shader, reflection, opts->target, &vert, &frag);
+    out->vertex_glsl = vert.data;
+    out->fragment_glsl = frag.data;
+    if (vert.failed || frag.failed) {
+        free(reflection);
+        return FXC_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (opts->text_metadata) {
+        FXCBuffer meta = {0};
+        generate_text_metadata(out, opts->target, &meta, source_path);
+        out->metadata = meta.data;
+        out->metadata_size = meta.length;
+        free(reflection);
+    } else {
+        out->metadata = (const char*)reflection;
+        out->metadata_size = reflection_size;
+    }
+    return out->metadata ? FXC_OK : FXC_ERROR_OUT_OF_MEMORY;
+}
+
+static FXCStatus fail(FXCResult* result, FXCStatus status, const char* message) {
+    result->status = status;
+    snprintf(result->error, sizeof(result->error), "%s", message);
+    return status;
+}
+
+FXCStatus fxc_compile_source(const char* src, size_t len, const FXCOptions* opts, FXCResult* result) {
+    if (!result) return FXC_ERROR_INVALID_ARGUMENT;
+    memset(result, 0, sizeof(*result));
+    if (!src) return fail(result, FXC_ERROR_INVALID_ARGUMENT, "no source");
+
+    FXCOptions defaults = {0};
+    if (!opts) opts = &defaults;
+    const char* source_path = opts->source_path;
+    char stem[128] = "main";
+    if (opts->name) {
+        snprintf(stem, sizeof(stem), "%s", opts->name);
+    } else if (source_path) {
+        // File name without directory or extension
+        const char* base = source_path;
+        for (const char* c = source_path; *c; c++) {
+            if (*c == '/' || *c == '\\') base = c + 1;
+        }
+        const char* dot = strrchr(base, '.');
+        int length = dot ? (int)(dot - base) : (int)strlen(base);
+        if (length > 0) snprintf(stem, sizeof(stem), "%.*s", length, base);
+    }
+    const char* program_name = stem;
+
+    // The lexer peeks one character ahead, so work on a terminated copy
+    char* text = (char*)malloc(len + 1);
+    if (!text) return fail(result, FXC_ERROR_OUT_OF_MEMORY, "out of memory");
+    memcpy(text, src, len);
+    text[len] = '\0';
+
+    Lexer lex;
+    lexer_init(&lex, text, len);
+    Parser parser = {0};
+    parser.lex = &lex;
+    FXShader* shaders = parse_shader_file(&parser, program_name);
+
+    if (parser.failed) {
+        fail(result, FXC_ERROR_PARSE, parser.error);
+        result->error_line = parser.error_line;
+        result->error_col = parser.error_col;
+    } else if (!shaders) {
+        fail(result, FXC_ERROR_NO_SHADERS, "no shaders found");
+    } else {
+        int count = 0;
+        for (FXShader* s = shaders; s; s = s->next) count++;
+        result->shaders = (FXCShaderOutput*)calloc(count, sizeof(FXCShaderOutput));
+        if (!result->shaders) {
+            fail(result, FXC_ERROR_OUT_OF_MEMORY, "out of memory");
+        } else {
+            result->shader_count = count;
+            int i = 0;
+            for (FXShader* s = shaders; s; s = s->next, i++) {
+                if (emit_shader(s, source_path, opts, &result->shaders[i]) != FXC_OK) {
+                    fail(result, FXC_ERROR_OUT_OF_MEMORY, "out of memory");
+                    break;
+                }
+            }
+        }
+    }
+
+    FXShader* s = shaders;
+    while (s) {
+        FXShader* next = s->next;
+        cleanup_shader(s);
+        s = next;
+    }
+    free(text);
+    return result->status;
+}
+
+void fxc_result_free(FXCResult* result) {
+    if (!result) return;
+    for (int i = 0; i < result->shader_count; i++) {
+        FXCShaderOutput* out = &result->shaders[i];
+        free((void*)out->name);
+        free((void*)out->vertex_glsl);
+        free((void*)out->fragment_glsl);
+        free((void*)out->metadata);
+        for (int j = 0; out->uniforms && j < out->uniform_count; j++) {
+            free((void*)out->uniforms[j].type);
+            free((void*)out->uniforms[j].name);
+        }
+        for (int j = 0; out->inputs && j < out->input_count; j++) {
+            free((void*)out->inputs[j].type);
+            free((void*)out->inputs[j].name);
+            free((void*)out->inputs[j].format);
+        }
+        free((void*)out->uniforms);
+        free((void*)out->inputs);
+    }
+    free(result->shaders);
+    result->shaders = NULL;
+    result->shader_count = 0;
+}
+
+const char* fxc_status_str(FXCStatus status) {
+    switch (status) {
+        case FXC_OK: return "ok";
+        case FXC_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case FXC_ERROR_OUT_OF_MEMORY: return "out of memory";
+        case FXC_ERROR_PARSE: return "parse error";
+        case FXC_ERROR_NO_SHADERS: return "no shaders found";
+        default: return "unknown error";
+    }
+}
+
+void fxc_output_path(const char* source_path, const FXCShaderOutput* shader, char* buffer, size_t size) {
+    if (shader->is_named_block) {
+        snprintf(buffer, size, "%s_%s", source_path, shader->name);
+        return;
+    }
+    // Unnamed program: the source path minus its extension
+    const char* dot = strrchr(source_path, '.');
+    const char* slash = strrchr(source_path, '/');
+    const char* backslash = strrchr(source_path, '\\');
+    if (backslash > slash) slash = backslash;
+    if (dot && (!slash || dot > slash)) {
+        snprintf(buffer, size, "%.*s", (int)(dot - source_path), source_path);
+    } else {
+        snprintf(buffer, size, "%s", source_path);
+    }
+}